@@ -0,0 +1,575 @@
+/*
+ * Fuzz test for the config.dat parser. Starts from well-formed images
+ * (current format with one or several profiles, rules and title rules, with and
+ * without unknown records, and the legacy raw dump) and mutates them: bit flips, byte overwrites, truncation,
+ * extension and header rewrites with the CRC patched up, so mutations
+ * reach the record parser instead of dying at the checksum. Checks that
+ *
+ *   - anything accepted is a valid config that survives a write/read trip,
+ *   - anything rejected leaves the output untouched,
+ *   - the parser never reads outside the buffer (build with sanitizers,
+ *     which the Makefile does when the compiler supports them).
+ *
+ *   config_fuzz [-n iterations] [-s seed]
+ *
+ * Building with -DFANCONTROL_LIBFUZZER instead provides a libFuzzer entry
+ * point for coverage-guided runs.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fan_config.h"
+#include "trace.h"
+
+#define DEFAULT_ITERATIONS  200000
+#define SENTINEL_BYTE       0xA5
+
+_Static_assert(DEFAULT_CURVE_ENTRIES == FAN_CONFIG_LEGACY_POINTS,
+               "legacy files are a dump of the default curve");
+
+/* ── Property check ───────────────────────────────────────────────── */
+
+typedef struct
+{
+    u64 accepted;
+    u64 legacy;
+    u64 rejected[FanConfigResult_BadProfile + 1];
+    u64 failures;
+} FuzzStats;
+
+static void Fail(FuzzStats *st, const char *what, const u8 *data, size_t size)
+{
+    if (st->failures++ < 5)
+    {
+        fprintf(stderr, "FAIL: %s (%zu bytes):", what, size);
+        for (size_t i = 0; i < size && i < 64; i++)
+            fprintf(stderr, " %02x", data[i]);
+        fprintf(stderr, "\n");
+    }
+}
+
+static void CheckOne(FuzzStats *st, const u8 *data, size_t size)
+{
+    FanConfig out, sentinel;
+    memset(&out, SENTINEL_BYTE, sizeof(out));
+    memset(&sentinel, SENTINEL_BYTE, sizeof(sentinel));
+
+    FanConfigResult result = FanConfigParse(data, size, &out);
+
+    if (result != FanConfigResult_Ok && result != FanConfigResult_Legacy)
+    {
+        if (result > FanConfigResult_BadProfile)
+            Fail(st, "unknown result", data, size);
+        else
+            st->rejected[result]++;
+        if (memcmp(&out, &sentinel, sizeof(out)) != 0)
+            Fail(st, "rejected input wrote output", data, size);
+        return;
+    }
+
+    if (result == FanConfigResult_Legacy)
+        st->legacy++;
+    else
+        st->accepted++;
+
+    if (!FanConfigValid(&out))
+    {
+        Fail(st, "accepted an invalid config", data, size);
+        return;
+    }
+
+    static u8 buf[FAN_CONFIG_MAX_SIZE];
+    static FanConfig again;
+    size_t n = FanConfigSerialize(&out, buf, sizeof(buf));
+    if (n == 0 || FanConfigParse(buf, n, &again) != FanConfigResult_Ok ||
+        !FanConfigEqual(&again, &out))
+        Fail(st, "accepted config did not round-trip", data, size);
+}
+
+#ifdef FANCONTROL_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const u8 *data, size_t size)
+{
+    FuzzStats st = { 0 };
+    CheckOne(&st, data, size);
+    if (st.failures)
+        abort();
+    return 0;
+}
+
+#else
+
+/* ── Seeds and mutations ──────────────────────────────────────────── */
+
+static u64 rngState;
+
+static u32 Rand(void)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (u32)(rngState >> 32);
+}
+
+/* Strictly increasing temperatures, stopping early at the top of the
+ * range; always at least FAN_CURVE_MIN_POINTS. */
+static void RandomCurve(FanProfile *profile)
+{
+    size_t want = FAN_CURVE_MIN_POINTS + Rand() % (FAN_CURVE_MAX_POINTS - FAN_CURVE_MIN_POINTS + 1);
+    int t = FAN_LUT_MIN_C + (int)(Rand() % 20);
+
+    profile->count = 0;
+    while (profile->count < want && t <= FAN_LUT_MAX_C)
+    {
+        profile->points[profile->count].temperature_c = t;
+        profile->points[profile->count].fanLevel_f    = (float)(Rand() % 1001) / 1000.0f;
+        profile->count++;
+        t += 1 + (int)(Rand() % 4);
+    }
+}
+
+/* Mostly single-profile configs, like most users have. */
+static void RandomConfig(FanConfig *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->profileCount = Rand() % 2 ? 1 : 1 + Rand() % FAN_PROFILE_MAX;
+    cfg->ruleCount    = cfg->profileCount > 1 ? Rand() % (FAN_PROFILE_RULE_MAX + 1) : 0;
+
+    for (size_t i = 0; i < cfg->profileCount; i++)
+    {
+        size_t len = 1 + Rand() % (FAN_PROFILE_NAME_MAX - 1);
+        for (size_t c = 0; c < len; c++)
+            cfg->profiles[i].name[c] = (char)('a' + Rand() % 26);
+        RandomCurve(&cfg->profiles[i]);
+    }
+
+    for (size_t i = 0; i < cfg->ruleCount; i++)
+    {
+        cfg->rules[i].profile    = (u8)(Rand() % cfg->profileCount);
+        cfg->rules[i].docked     = (u8)(Rand() % 3);
+        cfg->rules[i].charging   = (u8)(Rand() % 3);
+        cfg->rules[i].batteryMax = (u8)(Rand() % 101);
+    }
+
+    /* Application IDs look like 0x0100xxxxxxxxx000. */
+    cfg->titleCount = cfg->profileCount > 1 ? Rand() % (FAN_TITLE_RULE_MAX + 1) : 0;
+    for (size_t i = 0; i < cfg->titleCount; i++)
+    {
+        cfg->titles[i].titleId = 0x0100000000000000ULL | ((u64)(i + 1) << 13) | ((u64)Rand() << 24);
+        cfg->titles[i].profile = (u8)(Rand() % cfg->profileCount);
+    }
+}
+
+/* Re-seals the payload after a mutation so it passes the CRC check. */
+static void FixCrc(u8 *data, size_t size)
+{
+    FanConfigHeader header;
+    if (size < sizeof(header))
+        return;
+    memcpy(&header, data, sizeof(header));
+    if (header.headerSize < sizeof(header) || header.headerSize > size)
+        return;
+    header.crc32 = FanConfigCrc32(data + header.headerSize, size - header.headerSize);
+    memcpy(data, &header, sizeof(header));
+}
+
+/* Appends a record with an unknown tag, as a newer writer would. */
+static size_t AppendUnknownRecord(u8 *data, size_t size, size_t cap)
+{
+    FanConfigRecord record = { .tag = (u16)(0x100 + Rand() % 64), .size = (u16)(Rand() % 24) };
+    FanConfigHeader header;
+
+    if (size + sizeof(record) + record.size > cap)
+        return size;
+
+    memcpy(data + size, &record, sizeof(record));
+    for (u16 i = 0; i < record.size; i++)
+        data[size + sizeof(record) + i] = (u8)Rand();
+    size += sizeof(record) + record.size;
+
+    memcpy(&header, data, sizeof(header));
+    header.payloadSize = (u32)(size - header.headerSize);
+    memcpy(data, &header, sizeof(header));
+    FixCrc(data, size);
+    return size;
+}
+
+static size_t Seed(u8 *data, size_t cap)
+{
+    static FanConfig cfg;
+
+    switch (Rand() % 4)
+    {
+        case 0:
+            memcpy(data, defaultCurve, sizeof(defaultCurve));
+            return sizeof(defaultCurve);
+        case 1:
+            RandomConfig(&cfg);
+            return AppendUnknownRecord(data, FanConfigSerialize(&cfg, data, cap), cap);
+        default:
+            RandomConfig(&cfg);
+            return FanConfigSerialize(&cfg, data, cap);
+    }
+}
+
+static size_t Mutate(u8 *data, size_t size, size_t cap)
+{
+    int rounds = 1 + Rand() % 4;
+    bool reseal = Rand() % 2;
+
+    while (rounds--)
+    {
+        switch (Rand() % 6)
+        {
+            case 0:     /* bit flip */
+                if (size)
+                    data[Rand() % size] ^= (u8)(1u << (Rand() % 8));
+                break;
+            case 1:     /* interesting byte */
+            {
+                static const u8 values[] = { 0x00, 0x01, 0x7F, 0x80, 0xFF, 0x0A, 0x40 };
+                if (size)
+                    data[Rand() % size] = values[Rand() % sizeof(values)];
+                break;
+            }
+            case 2:     /* truncate */
+                if (size)
+                    size = Rand() % size;
+                break;
+            case 3:     /* extend with noise */
+            {
+                size_t extra = Rand() % 32;
+                if (size + extra > cap)
+                    extra = cap - size;
+                for (size_t i = 0; i < extra; i++)
+                    data[size + i] = (u8)Rand();
+                size += extra;
+                break;
+            }
+            case 4:     /* rewrite a header field */
+            {
+                static const size_t offsets[] = { 4, 6, 8, 16, 18 };
+                size_t off = offsets[Rand() % 5];
+                u16 v = (u16)(Rand() % 3 == 0 ? Rand() : Rand() % 96);
+                if (off + sizeof(v) <= size)
+                    memcpy(data + off, &v, sizeof(v));
+                break;
+            }
+            case 5:     /* duplicate a chunk over another */
+                if (size > 8)
+                {
+                    size_t len = 1 + Rand() % 8;
+                    memmove(data + Rand() % (size - len), data + Rand() % (size - len), len);
+                }
+                break;
+        }
+    }
+
+    if (reseal)
+        FixCrc(data, size);
+    return size;
+}
+
+/* ── Fixed checks ─────────────────────────────────────────────────── */
+
+static bool SelfTest(void)
+{
+    bool ok = true;
+    static FanConfig cfg, out;
+    static u8 buf[FAN_CONFIG_MAX_SIZE];
+
+    /* Standard check value for CRC-32/ISO-HDLC. */
+    if (FanConfigCrc32("123456789", 9) != 0xCBF43926)
+    {
+        fprintf(stderr, "FAIL: crc32 check value\n");
+        ok = false;
+    }
+
+    if (FanConfigParse(defaultCurve, sizeof(defaultCurve), &out) != FanConfigResult_Legacy ||
+        out.profileCount != 1 || out.profiles[0].count != FAN_CONFIG_LEGACY_POINTS ||
+        memcmp(out.profiles[0].points, defaultCurve, sizeof(defaultCurve)) != 0)
+    {
+        fprintf(stderr, "FAIL: legacy config.dat not migrated\n");
+        ok = false;
+    }
+
+    /* The old overlay allowed any order and repeated temperatures. */
+    TemperaturePoint shuffled[FAN_CONFIG_LEGACY_POINTS];
+    memcpy(shuffled, defaultCurve, sizeof(shuffled));
+    shuffled[0] = defaultCurve[9];
+    shuffled[9] = defaultCurve[0];
+    shuffled[5].temperature_c = defaultCurve[4].temperature_c;
+    if (FanConfigParse(shuffled, sizeof(shuffled), &out) != FanConfigResult_Legacy ||
+        out.profiles[0].count != FAN_CONFIG_LEGACY_POINTS - 1 ||
+        !FanConfigValid(&out) ||
+        out.profiles[0].points[4].fanLevel_f != defaultCurve[5].fanLevel_f)
+    {
+        fprintf(stderr, "FAIL: unsorted legacy config.dat not repaired\n");
+        ok = false;
+    }
+
+    FanConfigInitSingle(&cfg, defaultCurve, FAN_CONFIG_LEGACY_POINTS);
+    size_t n = FanConfigSerialize(&cfg, buf, sizeof(buf));
+    if (n != sizeof(FanConfigHeader) + 2 * sizeof(FanConfigRecord) + FAN_PROFILE_NAME_MAX +
+             sizeof(defaultCurve) ||
+        FanConfigParse(buf, n, &out) != FanConfigResult_Ok ||
+        !FanConfigEqual(&out, &cfg))
+    {
+        fprintf(stderr, "FAIL: default curve round trip\n");
+        ok = false;
+    }
+
+    buf[n - 1] ^= 0x01;
+    if (FanConfigParse(buf, n, &out) != FanConfigResult_BadChecksum)
+    {
+        fprintf(stderr, "FAIL: corrupted payload not caught by the checksum\n");
+        ok = false;
+    }
+
+    if (FanConfigSerialize(&cfg, buf, n - 1) != 0)
+    {
+        fprintf(stderr, "FAIL: serialize overran a short buffer\n");
+        ok = false;
+    }
+
+    /* Handheld on battery -> 1, docked -> 2, low battery -> 3, else 0. */
+    static const FanProfileRule rules[] =
+    {
+        { 3, FanProfileMatch_Any, FanProfileMatch_No,  15  },
+        { 2, FanProfileMatch_Yes, FanProfileMatch_Any, 100 },
+        { 1, FanProfileMatch_No,  FanProfileMatch_No,  100 },
+    };
+    static const struct { FanPowerState power; size_t profile; } cases[] =
+    {
+        { { false, false, 80 }, 1 },
+        { { false, false, 10 }, 3 },
+        { { false, true,  10 }, 0 },
+        { { true,  true,  50 }, 2 },
+        { { true,  false, 15 }, 3 },
+    };
+    for (size_t i = 1; i < 4; i++)
+    {
+        cfg.profiles[i] = cfg.profiles[0];
+        snprintf(cfg.profiles[i].name, FAN_PROFILE_NAME_MAX, "p%zu", i);
+    }
+    cfg.profileCount = 4;
+    memcpy(cfg.rules, rules, sizeof(rules));
+    cfg.ruleCount = sizeof(rules) / sizeof(rules[0]);
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        size_t got = FanProfileSelect(&cfg, &cases[i].power);
+        if (got != cases[i].profile)
+        {
+            fprintf(stderr, "FAIL: profile rule case %zu picked %zu\n", i, got);
+            ok = false;
+        }
+    }
+
+    n = FanConfigSerialize(&cfg, buf, sizeof(buf));
+    if (n == 0 || FanConfigParse(buf, n, &out) != FanConfigResult_Ok || !FanConfigEqual(&out, &cfg))
+    {
+        fprintf(stderr, "FAIL: multi-profile round trip\n");
+        ok = false;
+    }
+
+    /* Title rules: every ID found in O(1) probes, others not found. */
+    static FanTitleIndex index;
+    cfg.titleCount = FAN_TITLE_RULE_MAX;
+    for (size_t i = 0; i < cfg.titleCount; i++)
+    {
+        cfg.titles[i].titleId = 0x01006A800016E000ULL + ((u64)i << 16);
+        cfg.titles[i].profile = (u8)(i % cfg.profileCount);
+    }
+    FanTitleIndexBuild(&index, &cfg);
+    for (size_t i = 0; i < cfg.titleCount; i++)
+    {
+        if (FanTitleIndexLookup(&index, cfg.titles[i].titleId) != cfg.titles[i].profile)
+        {
+            fprintf(stderr, "FAIL: title %016llx not found\n",
+                    (unsigned long long)cfg.titles[i].titleId);
+            ok = false;
+        }
+    }
+    if (FanTitleIndexLookup(&index, 0x0100000000001000ULL) != -1 ||
+        FanTitleIndexLookup(&index, 0) != -1)
+    {
+        fprintf(stderr, "FAIL: title without a rule matched\n");
+        ok = false;
+    }
+
+    n = FanConfigSerialize(&cfg, buf, sizeof(buf));
+    if (n == 0 || FanConfigParse(buf, n, &out) != FanConfigResult_Ok || !FanConfigEqual(&out, &cfg))
+    {
+        fprintf(stderr, "FAIL: title rules round trip\n");
+        ok = false;
+    }
+
+    cfg.titles[1].titleId = cfg.titles[0].titleId;
+    if (FanConfigSerialize(&cfg, buf, sizeof(buf)) != 0)
+    {
+        fprintf(stderr, "FAIL: serialized a duplicate title rule\n");
+        ok = false;
+    }
+    cfg.titleCount = 0;
+
+    /* A rule pointing past the last profile makes the file unusable. */
+    cfg.rules[0].profile = 4;
+    if (FanConfigSerialize(&cfg, buf, sizeof(buf)) != 0)
+    {
+        fprintf(stderr, "FAIL: serialized a rule for a missing profile\n");
+        ok = false;
+    }
+    return ok;
+}
+
+/* Serializes valid, then swaps in bad's records and fixes up the CRC, so
+ * the parser sees a well-formed file with invalid values. */
+static size_t SerializeUnchecked(const FanControllerSettings *valid, const FanControllerSettings *bad,
+                                 u8 *buf, size_t cap)
+{
+    size_t n = FanSettingsSerialize(valid, buf, cap);
+    FanConfigHeader header;
+    FanConfigRecord record;
+
+    if (n == 0)
+        return 0;
+    memcpy(&header, buf, sizeof(header));
+    for (size_t off = header.headerSize; off + sizeof(record) <= n; off += sizeof(record) + record.size)
+    {
+        memcpy(&record, buf + off, sizeof(record));
+        u8 *data = buf + off + sizeof(record);
+        switch (record.tag)
+        {
+            case FanSettingsTag_Pid:   memcpy(data, &bad->pid, sizeof(bad->pid));     break;
+            case FanSettingsTag_Gate:  memcpy(data, &bad->gate, sizeof(bad->gate));   break;
+            case FanSettingsTag_Sched: memcpy(data, &bad->sched, sizeof(bad->sched)); break;
+            case FanSettingsTag_Log:   memcpy(data, &bad->logLevel, sizeof(bad->logLevel)); break;
+            default:                   break;
+        }
+    }
+    header.crc32 = FanConfigCrc32(buf + header.headerSize, header.payloadSize);
+    memcpy(buf, &header, sizeof(header));
+    return n;
+}
+
+/* settings.dat: round trip, and the checks that keep bad PID limits and
+ * gains, write gate thresholds, ramp steps and scheduler intervals away
+ * from the fan. */
+static bool SettingsSelfTest(void)
+{
+    static const FanControllerSettings defaults = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+    FanControllerSettings settings = defaults, out;
+    u8 buf[FAN_SETTINGS_MAX_SIZE];
+    bool ok = true;
+
+    settings.mode = FanControlMode_Pid;
+    settings.pid.setpointC = 55.0f;
+    settings.filter.medianWindow = 5;
+    settings.gate.deadband_f = 0.03f;
+    settings.sched.maxIntervalNs = 2000000000ULL;
+    settings.logLevel = FanLogLevel_Debug;
+    size_t n = FanSettingsSerialize(&settings, buf, sizeof(buf));
+    if (n == 0 || FanSettingsParse(buf, n, &out) != FanConfigResult_Ok ||
+        memcmp(&out.pid, &settings.pid, sizeof(out.pid)) != 0 || out.mode != settings.mode ||
+        out.gate.deadband_f != settings.gate.deadband_f ||
+        out.sched.maxIntervalNs != settings.sched.maxIntervalNs || out.logLevel != settings.logLevel)
+    {
+        fprintf(stderr, "FAIL: settings round trip\n");
+        ok = false;
+    }
+
+    buf[n - 1] ^= 0x01;
+    if (FanSettingsParse(buf, n, &out) != FanConfigResult_BadChecksum)
+    {
+        fprintf(stderr, "FAIL: settings checksum not checked\n");
+        ok = false;
+    }
+
+    /* A bare struct dump has no header. */
+    if (FanSettingsParse(&settings, sizeof(settings), &out) != FanConfigResult_BadMagic)
+    {
+        fprintf(stderr, "FAIL: accepted a headerless settings file\n");
+        ok = false;
+    }
+
+    FanControllerSettings bad[11];
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+        bad[i] = settings;
+    bad[0].pid.kp = NAN;
+    bad[1].pid.outMin_f = 0.8f;
+    bad[1].pid.outMax_f = 0.2f;
+    bad[2].pid.outMax_f = 1.5f;
+    bad[3].gate.deadband_f = -0.01f;
+    bad[4].gate.hysteresis_f = NAN;
+    bad[5].gate.slewUp_f = INFINITY;
+    bad[6].sched.minIntervalNs = 0;
+    bad[7].sched.minIntervalNs = 3000000000ULL;
+    bad[8].sched.slopeAlpha = 0.0f;
+    bad[9].gate.slewStepNs = 0;
+    bad[10].logLevel = FanLogLevel_Error + 1;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        if (FanSettingsSerialize(&bad[i], buf, sizeof(buf)) != 0 ||
+            FanSettingsParse(buf, SerializeUnchecked(&settings, &bad[i], buf, sizeof(buf)), &out) !=
+                FanConfigResult_BadRecord)
+        {
+            fprintf(stderr, "FAIL: accepted invalid settings %zu\n", i);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    u64 iterations = DEFAULT_ITERATIONS;
+    u64 seed = 0x9E3779B97F4A7C15ULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1)
+    {
+        if (opt == 'n')
+            iterations = strtoull(optarg, NULL, 0);
+        else if (opt == 's')
+            seed = strtoull(optarg, NULL, 0);
+        else
+        {
+            fprintf(stderr, "usage: %s [-n iterations] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    rngState = seed ? seed : 1;
+
+    bool ok = SelfTest();
+    ok = SettingsSelfTest() && ok;
+    FuzzStats st = { 0 };
+
+    for (u64 i = 0; i < iterations; i++)
+    {
+        /* Exact-size heap copy so an overread trips the sanitizer. */
+        static u8 image[FAN_CONFIG_MAX_SIZE];
+        size_t size = Seed(image, sizeof(image));
+        size = Mutate(image, size, sizeof(image));
+
+        u8 *data = malloc(size ? size : 1);
+        memcpy(data, image, size);
+        CheckOne(&st, data, size);
+        free(data);
+    }
+
+    printf("%llu inputs: %llu accepted, %llu legacy\n", (unsigned long long)iterations,
+           (unsigned long long)st.accepted, (unsigned long long)st.legacy);
+    for (int r = FanConfigResult_Truncated; r <= FanConfigResult_BadProfile; r++)
+        printf("  %-24s %llu\n", FanConfigResultString(r), (unsigned long long)st.rejected[r]);
+
+    ok = ok && st.failures == 0;
+    printf("config_fuzz: %s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+#endif
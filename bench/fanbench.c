@@ -0,0 +1,338 @@
+/*
+ * Control-loop benchmark: runs FanLoopStep against the simulated plant on a
+ * virtual clock for a set of workload profiles and reports
+ *
+ *   cpu ns/it   CPU time spent in FanLoopStep per iteration (host CPU)
+ *   writes/min  fan writes issued per simulated minute
+ *   wake/min    loop iterations per simulated minute
+ *   peak C      highest simulated SoC temperature
+ *   >70C s      time spent above 70 C
+ *   duty %      time-averaged actual fan level
+ *   noise dB    acoustic proxy: time-averaged 50*log10(fan level), i.e. fan
+ *               sound power relative to 100% by the fan laws (floor -40 dB)
+ *   swing %/min total movement of the actual fan level per minute, a proxy
+ *               for audible speed changes
+ *   p-p %       largest spread of the fan level within any PP_WINDOW_S
+ *               window, i.e. the worst spike and recovery
+ *
+ *   fanbench [-m curve|pid] [-f soc|max|weighted|curves] [-s up,down|off]
+ *            [-p horizon_s|off] [trace.csv ...]
+ *
+ * -f picks the sensor fusion; the non-SoC modes use the simulated PCB and
+ * battery temperatures with the offsets in FusionPreset. -s sets the slew
+ * limits in % per second, or turns them off. -p feeds the curve the
+ * thermal model's prediction horizon_s ahead instead of the reading; the
+ * time constant and gain the model ends up with go under each row.
+ * Traces use the
+ * bench "time_s,temp_c" format (see trace.h) and are run after the
+ * built-in profiles.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "control_loop.h"
+#include "hal_sim.h"
+#include "trace.h"
+
+#define HOT_THRESHOLD_C     70.0f
+#define NOISE_FLOOR_DB     -40.0f
+#define PP_WINDOW_S         10
+
+/* ── Workload profiles ────────────────────────────────────────────── */
+
+static float IdlePower(void *user, double t)
+{
+    (void)user;
+    return 2.5f + 0.2f * (float)sin(t * 0.7);
+}
+
+static float DockedGamingPower(void *user, double t)
+{
+    (void)user;
+    /* Frame-to-frame load plus scene changes every 90 s. */
+    float scene = fmod(t, 90.0) < 45.0 ? 1.5f : -1.0f;
+    return 10.0f + scene + 1.2f * (float)sin(t * 3.1) + 0.5f * (float)sin(t * 17.0);
+}
+
+static float ThermalSoakPower(void *user, double t)
+{
+    (void)user;
+    return t < 30.0 ? 4.0f : 13.0f;
+}
+
+static float DockCyclePower(void *user, double t)
+{
+    (void)user;
+    /* Docked (boost clocks) and handheld alternating every 20 s. */
+    return fmod(t, 40.0) < 20.0 ? 11.0f : 6.0f;
+}
+
+static float BurstPower(void *user, double t)
+{
+    (void)user;
+    /* Light handheld load with a 3 s burst (loading screen, shader
+     * compile) every 30 s. */
+    return fmod(t, 30.0) < 3.0 ? 14.0f : 5.0f;
+}
+
+typedef struct
+{
+    const char     *name;
+    float           durationS;
+    float           ambientC;
+    FanSimPowerFn   power;
+    void           *user;
+} Profile;
+
+/* ── Metrics ──────────────────────────────────────────────────────── */
+
+typedef struct
+{
+    float   peakC;
+    double  hotS;
+    double  dutySum;        /* level * s                    */
+    double  noiseSum;       /* dB * s                       */
+    double  swing;          /* summed |d level|             */
+    float   lastLevel;
+
+    /* Per-second fan level range over the last PP_WINDOW_S seconds */
+    float   bucketMin[PP_WINDOW_S];
+    float   bucketMax[PP_WINDOW_S];
+    u64     second;
+    float   peakToPeak;
+} Observer;
+
+static void ObservePeakToPeak(Observer *obs, u64 second, float level)
+{
+    if (second != obs->second || obs->bucketMax[0] < obs->bucketMin[0])
+    {
+        for (u64 s = obs->second + 1; s <= second; s++)
+        {
+            obs->bucketMin[s % PP_WINDOW_S] = level;
+            obs->bucketMax[s % PP_WINDOW_S] = level;
+        }
+        obs->second = second;
+    }
+
+    size_t i = second % PP_WINDOW_S;
+    if (level < obs->bucketMin[i])
+        obs->bucketMin[i] = level;
+    if (level > obs->bucketMax[i])
+        obs->bucketMax[i] = level;
+
+    float lo = obs->bucketMin[0], hi = obs->bucketMax[0];
+    for (size_t b = 1; b < PP_WINDOW_S; b++)
+    {
+        lo = fminf(lo, obs->bucketMin[b]);
+        hi = fmaxf(hi, obs->bucketMax[b]);
+    }
+    if (hi - lo > obs->peakToPeak)
+        obs->peakToPeak = hi - lo;
+}
+
+static void Observe(void *user, const FanSim *sim)
+{
+    Observer *obs = user;
+    double dt = (double)sim->params.stepNs / 1e9;
+
+    if (sim->socC > obs->peakC)
+        obs->peakC = sim->socC;
+    if (sim->socC > HOT_THRESHOLD_C)
+        obs->hotS += dt;
+
+    float db = sim->fanLevel > 0.0f ? 50.0f * log10f(sim->fanLevel) : NOISE_FLOOR_DB;
+    obs->noiseSum += (db < NOISE_FLOOR_DB ? NOISE_FLOOR_DB : db) * dt;
+    obs->dutySum  += sim->fanLevel * dt;
+    obs->swing    += fabsf(sim->fanLevel - obs->lastLevel);
+    obs->lastLevel = sim->fanLevel;
+    ObservePeakToPeak(obs, sim->nowNs / 1000000000ULL, sim->fanLevel);
+}
+
+static double ThreadCpuNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void RunProfile(const Profile *profile, const FanControllerSettings *base)
+{
+    FanControllerSettings settings = *base;
+    FanSimParams          params   = FAN_SIM_DEFAULTS;
+    FanSim   sim;
+    FanHal   hal;
+    FanCurve fanCurve;
+    Observer obs = { .bucketMin = { 1.0f }, .bucketMax = { 0.0f } };
+
+    params.ambientC = profile->ambientC;
+
+    FanLoop loop =
+    {
+        .curve      = &fanCurve,
+        .gateCfg    = &settings.gate,
+        .schedCfg   = &settings.sched,
+        .settings   = &settings,
+    };
+    FanCurveBuild(&fanCurve, defaultCurve, DEFAULT_CURVE_ENTRIES);
+    FanLoopInit(&loop);
+
+    FanSimInit(&sim, &params, profile->power, profile->user);
+    sim.observer     = Observe;
+    sim.observerUser = &obs;
+    obs.peakC        = sim.socC;
+    FanSimGetHal(&sim, &hal);
+
+    const u64 endNs = (u64)((double)profile->durationS * 1e9);
+    double cpuNs = 0.0;
+    u64    iterations = 0;
+
+    while (sim.nowNs < endNs)
+    {
+        u64 interval;
+
+        double start = ThreadCpuNs();
+        FanLoopStep(&loop, &hal, &interval);
+        cpuNs += ThreadCpuNs() - start;
+        iterations++;
+
+        hal.sleepNs(hal.ctx, interval);
+    }
+
+    double minutes = (double)sim.nowNs / 60e9;
+    double seconds = (double)sim.nowNs / 1e9;
+
+    printf("%-14s %9.0f %10.1f %9.1f %7.2f %8.1f %7.1f %9.1f %11.1f %6.1f\n",
+           profile->name,
+           cpuNs / (double)iterations,
+           (double)loop.gate.writesIssued / minutes,
+           (double)iterations / minutes,
+           obs.peakC,
+           obs.hotS,
+           obs.dutySum * 100.0 / seconds,
+           obs.noiseSum / seconds,
+           obs.swing * 100.0 / minutes,
+           obs.peakToPeak * 100.0f);
+    if (settings.predict.enabled)
+        printf("  model: tau %.1f s, gain %.1f C/100%%, %u samples\n", loop.predictor.tauS,
+               loop.predictor.gainC, loop.predictor.samples);
+}
+
+/* The PCB and battery run far cooler than the SoC; the offsets bring them
+ * onto the same scale so they can take over when they heat up. */
+static const FanFusionConfig FusionPreset =
+{
+    .weight  = { 1.0f, 0.5f, 0.5f },
+    .offsetC = { 0.0f, 15.0f, 25.0f },
+};
+
+static const char *const fusionNames[] = { "soc", "max", "weighted", "curves" };
+
+int main(int argc, char *argv[])
+{
+    FanControllerSettings settings = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+    int argi = 1;
+
+    while (argi < argc && argv[argi][0] == '-')
+    {
+        const char *opt = argv[argi];
+        const char *val = argi + 1 < argc ? argv[argi + 1] : NULL;
+        u32 fusion = 0;
+
+        if (val != NULL && strcmp(opt, "-m") == 0)
+        {
+            settings.mode = strcmp(val, "pid") == 0 ? FanControlMode_Pid : FanControlMode_Curve;
+        }
+        else if (val != NULL && strcmp(opt, "-f") == 0)
+        {
+            while (fusion <= FanFusionMode_Curves && strcmp(val, fusionNames[fusion]) != 0)
+                fusion++;
+            if (fusion > FanFusionMode_Curves)
+                val = NULL;
+            else if (fusion != FanFusionMode_Soc)
+                settings.fusion = FusionPreset;
+            settings.fusion.mode = fusion;
+        }
+        else if (val != NULL && strcmp(opt, "-s") == 0)
+        {
+            float up = 0.0f, down = 0.0f;
+            if (strcmp(val, "off") != 0 &&
+                (sscanf(val, "%f,%f", &up, &down) != 2 || up < 0.0f || down < 0.0f))
+                val = NULL;
+            else
+            {
+                settings.gate.slewUp_f   = up / 100.0f;
+                settings.gate.slewDown_f = down / 100.0f;
+            }
+        }
+        else if (val != NULL && strcmp(opt, "-p") == 0)
+        {
+            settings.predict.enabled = strcmp(val, "off") != 0;
+            if (settings.predict.enabled &&
+                (sscanf(val, "%f", &settings.predict.horizonS) != 1 ||
+                 !FanPredictConfigValid(&settings.predict)))
+                val = NULL;
+        }
+        else
+        {
+            val = NULL;
+        }
+
+        if (val == NULL)
+        {
+            fprintf(stderr, "usage: %s [-m curve|pid] [-f soc|max|weighted|curves] "
+                    "[-s up,down|off] [-p horizon_s|off] [trace.csv ...]\n", argv[0]);
+            return 1;
+        }
+        argi += 2;
+    }
+
+    static const Profile builtin[] =
+    {
+        { "idle",          1800.0f, 25.0f, IdlePower,         NULL },
+        { "docked-gaming", 1800.0f, 25.0f, DockedGamingPower, NULL },
+        { "thermal-soak",  3600.0f, 35.0f, ThermalSoakPower,  NULL },
+        { "dock-cycle",    1200.0f, 25.0f, DockCyclePower,    NULL },
+        { "bursts",        1200.0f, 25.0f, BurstPower,        NULL },
+    };
+
+    printf("mode: %s, fusion: %s, slew: ", settings.mode == FanControlMode_Pid ? "pid" : "curve",
+           fusionNames[settings.fusion.mode]);
+    if (settings.gate.slewUp_f > 0.0f || settings.gate.slewDown_f > 0.0f)
+        printf("+%.0f/-%.0f %%/s", settings.gate.slewUp_f * 100.0f, settings.gate.slewDown_f * 100.0f);
+    else
+        printf("off");
+    if (settings.predict.enabled)
+        printf(", lookahead: %.1f s\n", settings.predict.horizonS);
+    else
+        printf("\n");
+    printf("%-14s %9s %10s %9s %7s %8s %7s %9s %11s %6s\n",
+           "profile", "cpu ns/it", "writes/min", "wake/min",
+           "peak C", ">70C s", "duty %", "noise dB", "swing %/min", "p-p %");
+
+    for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++)
+        RunProfile(&builtin[i], &settings);
+
+    FanSimParams params = FAN_SIM_DEFAULTS;
+    for (; argi < argc; argi++)
+    {
+        Trace trace = { .params = &params };
+        if (TraceLoad(&trace, argv[argi]) != 0)
+            return 1;
+
+        Profile profile =
+        {
+            .name      = argv[argi],
+            .durationS = TraceDuration(&trace),
+            .ambientC  = params.ambientC,
+            .power     = TracePower,
+            .user      = &trace,
+        };
+        RunProfile(&profile, &settings);
+        TraceFree(&trace);
+    }
+    return 0;
+}
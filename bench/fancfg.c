@@ -0,0 +1,138 @@
+/*
+ * Host-side helper for config.dat files with several fan profiles. The
+ * overlay edits the curves of existing profiles but doesn't create them or
+ * their switching rules; this does.
+ *
+ *   fancfg dump <config.dat>       print profiles, rules and title rules
+ *   fancfg example <config.dat>    write a four-profile example config
+ *
+ * Copy the written file to sdmc:/config/NX-FanControl/config.dat; a running
+ * sysmodule picks it up within a second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fan_config.h"
+
+static const char *MatchString(u8 match)
+{
+    switch (match)
+    {
+        case FanProfileMatch_Yes:   return "yes";
+        case FanProfileMatch_No:    return "no";
+        default:                    return "any";
+    }
+}
+
+static int Dump(const char *path)
+{
+    static u8 buf[FAN_CONFIG_MAX_SIZE + 1];
+    static FanConfig cfg;
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    size_t size = fread(buf, 1, sizeof(buf), file);
+    fclose(file);
+
+    FanConfigResult result = FanConfigParse(buf, size, &cfg);
+    if (result != FanConfigResult_Ok && result != FanConfigResult_Legacy)
+    {
+        fprintf(stderr, "%s: %s\n", path, FanConfigResultString(result));
+        return 1;
+    }
+    if (result == FanConfigResult_Legacy)
+        printf("(legacy format)\n");
+
+    for (size_t i = 0; i < cfg.profileCount; i++)
+    {
+        const FanProfile *profile = &cfg.profiles[i];
+        printf("profile %zu \"%s\":", i, profile->name);
+        for (size_t p = 0; p < profile->count; p++)
+            printf(" %d:%.0f%%", profile->points[p].temperature_c,
+                   profile->points[p].fanLevel_f * 100.0f);
+        printf("\n");
+    }
+
+    for (size_t i = 0; i < cfg.ruleCount; i++)
+    {
+        const FanProfileRule *rule = &cfg.rules[i];
+        printf("rule %zu: docked %s, charging %s, battery <= %u%% -> %s\n", i,
+               MatchString(rule->docked), MatchString(rule->charging), rule->batteryMax,
+               cfg.profiles[rule->profile].name);
+    }
+
+    for (size_t i = 0; i < cfg.titleCount; i++)
+        printf("title %016llX -> %s\n", (unsigned long long)cfg.titles[i].titleId,
+               cfg.profiles[cfg.titles[i].profile].name);
+    return 0;
+}
+
+static void AddProfile(FanConfig *cfg, const char *name, const TemperaturePoint *tbl, size_t count)
+{
+    FanProfile *profile = &cfg->profiles[cfg->profileCount++];
+
+    strncpy(profile->name, name, FAN_PROFILE_NAME_MAX - 1);
+    memcpy(profile->points, tbl, count * sizeof(TemperaturePoint));
+    profile->count = count;
+}
+
+static int Example(const char *path)
+{
+    static const TemperaturePoint balanced[] =
+        { { 35, 0.10f }, { 45, 0.30f }, { 55, 0.50f }, { 65, 0.80f }, { 75, 1.00f } };
+    static const TemperaturePoint silent[] =
+        { { 45, 0.00f }, { 55, 0.20f }, { 65, 0.50f }, { 75, 1.00f } };
+    static const TemperaturePoint performance[] =
+        { { 30, 0.20f }, { 40, 0.40f }, { 50, 0.70f }, { 60, 1.00f } };
+    static const TemperaturePoint docked[] =
+        { { 30, 0.30f }, { 45, 0.50f }, { 55, 0.80f }, { 65, 1.00f } };
+
+    /* Handheld on battery stays quiet, low battery is quieter still,
+     * docked or charging handheld get more airflow. */
+    static const FanProfileRule rules[] =
+    {
+        { 3, FanProfileMatch_Yes, FanProfileMatch_Any, 100 },
+        { 1, FanProfileMatch_No,  FanProfileMatch_No,  20  },
+        { 2, FanProfileMatch_No,  FanProfileMatch_Yes, 100 },
+    };
+
+    static FanConfig cfg;
+    static u8 buf[FAN_CONFIG_MAX_SIZE];
+
+    memset(&cfg, 0, sizeof(cfg));
+    AddProfile(&cfg, "Balanced",    balanced,    sizeof(balanced) / sizeof(balanced[0]));
+    AddProfile(&cfg, "Silent",      silent,      sizeof(silent) / sizeof(silent[0]));
+    AddProfile(&cfg, "Performance", performance, sizeof(performance) / sizeof(performance[0]));
+    AddProfile(&cfg, "Docked",      docked,      sizeof(docked) / sizeof(docked[0]));
+    memcpy(cfg.rules, rules, sizeof(rules));
+    cfg.ruleCount = sizeof(rules) / sizeof(rules[0]);
+
+    size_t size = FanConfigSerialize(&cfg, buf, sizeof(buf));
+    FILE *file = fopen(path, "wb");
+    if (size == 0 || file == NULL || fwrite(buf, 1, size, file) != size)
+    {
+        perror(path);
+        if (file != NULL)
+            fclose(file);
+        return 1;
+    }
+    fclose(file);
+    return Dump(path);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "dump") == 0)
+        return Dump(argv[2]);
+    if (argc == 3 && strcmp(argv[1], "example") == 0)
+        return Example(argv[2]);
+
+    fprintf(stderr, "usage: %s dump|example <config.dat>\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,640 @@
+/*
+ * Linux stand-in for the sysmodule's fanctl service: the control loop runs
+ * against the simulated plant and FanIpcDispatch serves requests over a
+ * Unix socket (host/ipc_mock.h).
+ *
+ *   fanctl_mock serve [socket]               run the mock server
+ *   fanctl_mock call [socket] <command>      one client request, where
+ *       command is state | telemetry | mode curve|pid | pause | resume
+ *                | table T:L,T:L,...       (T in C, L in 0..1)
+ *   fanctl_mock selftest                     server + client round trips,
+ *                                            exits non-zero on a mismatch
+ *
+ * The plant runs on its virtual clock, advanced by the loop's own sleep
+ * interval between socket polls, so simulated time runs far faster than
+ * wall time. Every iteration is also published to a telemetry ring in a
+ * memfd, handed to clients by GetTelemetry like the console's shared
+ * memory handle.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "control_loop.h"
+#include "supervisor.h"
+#include "fan_ipc.h"
+#include "hal_sim.h"
+#include "ipc_mock.h"
+#include "shm_host.h"
+#include "telemetry.h"
+#include "trace.h"
+
+#define DEFAULT_SOCKET  "/tmp/fanctl.sock"
+#define POLL_MS         1
+
+/* ── Mock controller ──────────────────────────────────────────────── */
+
+typedef struct
+{
+    FanWriteGateConfig    gateCfg;
+    FanSchedulerConfig    schedCfg;
+    FanControllerSettings settings;
+    FanSimParams          params;
+    FanCurve              curve;
+    FanSim                sim;
+    FanHal                hal;
+    FanLoop               loop;
+    FanSupervisorConfig   supCfg;
+    FanSupervisor         sup;
+    u64                   interval;
+    bool                  paused;
+    FanShm                telemetryShm;
+    FanTelemetryRing     *telemetry;
+    u64                   launchNs;
+} MockController;
+
+static float SteadyPower(void *user, double t)
+{
+    (void)user;
+    (void)t;
+    return 9.0f;
+}
+
+static void MockControllerInit(MockController *mc)
+{
+    *mc = (MockController)
+    {
+        .gateCfg  = FAN_WRITE_GATE_DEFAULTS,
+        .schedCfg = FAN_SCHEDULER_DEFAULTS,
+        .settings = FAN_CONTROLLER_SETTINGS_DEFAULTS,
+        .params   = FAN_SIM_DEFAULTS,
+        .supCfg   = FAN_SUPERVISOR_DEFAULTS,
+    };
+
+    FanCurveBuild(&mc->curve, defaultCurve, DEFAULT_CURVE_ENTRIES);
+    FanSimInit(&mc->sim, &mc->params, SteadyPower, NULL);
+    FanSimGetHal(&mc->sim, &mc->hal);
+
+    mc->loop.curve    = &mc->curve;
+    mc->loop.gateCfg  = &mc->gateCfg;
+    mc->loop.schedCfg = &mc->schedCfg;
+    mc->loop.settings = &mc->settings;
+    FanLoopInit(&mc->loop);
+    FanSupervisorInit(&mc->sup);
+    mc->launchNs = (u64)NowNs();
+
+    if (FanShmCreate(&mc->telemetryShm, sizeof(FanTelemetryRing)) == 0)
+    {
+        mc->telemetry = mc->telemetryShm.addr;
+        FanTelemetryRingInit(mc->telemetry);
+    }
+}
+
+static void MockControllerClose(MockController *mc)
+{
+    FanShmClose(&mc->telemetryShm);
+    mc->telemetry = NULL;
+}
+
+/* One loop iteration plus the sleep it asked for, on the virtual clock. */
+static void MockControllerStep(MockController *mc)
+{
+    if (mc->paused)
+    {
+        mc->hal.sleepNs(mc->hal.ctx, 100000000ULL);
+        return;
+    }
+
+    u64 start = (u64)NowNs();
+    Result rs = FanSupervisorStep(&mc->sup, &mc->supCfg, &mc->loop, &mc->hal, &mc->interval);
+    u64 latencyNs = (u64)NowNs() - start;
+
+    if (mc->telemetry != NULL)
+    {
+        FanTelemetrySample sample =
+        {
+            .timestampNs   = mc->loop.lastNs,
+            .socC          = mc->loop.sample.socC,
+            .pcbC          = mc->loop.sample.pcbC,
+            .targetLevel   = mc->loop.target,
+            .dutyLevel     = mc->loop.gate.applied,
+            .loopLatencyNs = (u32)latencyNs,
+            .result        = rs,
+            .battC         = mc->loop.sample.battC,
+            .controlC      = mc->loop.controlC,
+            .flags         = (mc->loop.readFailed ? FAN_TELEMETRY_READ_FAILED : 0) |
+                             (mc->loop.dutyMismatch ? FAN_TELEMETRY_DUTY_MISMATCH : 0) |
+                             ((u32)mc->sup.state << FAN_TELEMETRY_STATE_SHIFT),
+            .faults        = (u32)mc->sup.faults,
+            .recoveryUs    = (u32)(mc->sup.lastRecoveryNs / 1000),
+            .pwmLevel      = mc->loop.pwmLevel,
+        };
+        FanTelemetryPublish(mc->telemetry, &sample);
+        if (mc->loop.gate.applied >= 0.0f)
+            FanTelemetrySetFirstWrite(mc->telemetry, ((u64)NowNs() - mc->launchNs) / 1000);
+    }
+
+    mc->hal.sleepNs(mc->hal.ctx, mc->interval);
+}
+
+static void MockGetState(void *ctx, FanIpcState *out)
+{
+    MockController *mc = ctx;
+
+    out->socC             = mc->loop.sample.socC;
+    out->pcbC             = mc->loop.sample.pcbC;
+    out->battC            = mc->loop.sample.battC;
+    out->controlC         = mc->loop.controlC;
+    out->targetLevel      = mc->loop.target;
+    out->appliedLevel     = mc->loop.gate.applied;
+    out->mode             = mc->settings.mode;
+    out->paused           = mc->paused;
+    out->writesIssued     = mc->loop.gate.writesIssued;
+    out->writesSuppressed = mc->loop.gate.writesSuppressed;
+    out->readFailures     = mc->loop.readFailures;
+    out->lastIntervalNs   = mc->interval;
+    out->wakeupsPerMinute = mc->loop.sched.wakeupsPerMinute;
+    out->supervisorState  = mc->sup.state;
+    out->handbacks        = (u32)mc->sup.handbacks;
+    out->writeFaults      = mc->sup.faults;
+    out->recoveries       = mc->sup.recoveries;
+    out->lastRecoveryNs   = mc->sup.lastRecoveryNs;
+    out->maxRecoveryNs    = mc->sup.maxRecoveryNs;
+    out->pwmLevel         = mc->loop.pwmLevel;
+    out->dutyMismatches   = mc->loop.dutyMismatches;
+    out->reasserts        = mc->loop.reasserts;
+}
+
+/* The mock controller has a single profile. */
+static Result MockSetTable(void *ctx, u32 profile, const TemperaturePoint *tbl, size_t count)
+{
+    MockController *mc = ctx;
+    if (profile != 0)
+        return FAN_IPC_RESULT(FanIpcError_BadTable);
+    FanCurveBuild(&mc->curve, tbl, count);
+    return 0;
+}
+
+static Result MockSetMode(void *ctx, u32 mode)
+{
+    MockController *mc = ctx;
+    if (mode != mc->settings.mode)
+    {
+        mc->settings.mode = mode;
+        FanPidInit(&mc->loop.pid);
+    }
+    return 0;
+}
+
+static void MockSetPaused(void *ctx, bool paused)
+{
+    MockController *mc = ctx;
+    mc->paused = paused;
+}
+
+static Result MockGetTelemetry(void *ctx, FanIpcTelemetryInfo *out, Handle *handle)
+{
+    MockController *mc = ctx;
+    if (mc->telemetry == NULL)
+        return FAN_IPC_RESULT(FanIpcError_Unavailable);
+
+    out->size = mc->telemetryShm.size;
+    *handle   = mc->telemetryShm.fd;
+    return 0;
+}
+
+static volatile sig_atomic_t stopRequested;
+
+static void OnSignal(int sig)
+{
+    (void)sig;
+    stopRequested = 1;
+}
+
+static int Serve(const char *path)
+{
+    MockController   mc;
+    FanIpcMockServer server;
+
+    MockControllerInit(&mc);
+
+    FanIpcHandlers handlers =
+    {
+        .ctx          = &mc,
+        .getState     = MockGetState,
+        .setTable     = MockSetTable,
+        .setMode      = MockSetMode,
+        .setPaused    = MockSetPaused,
+        .getTelemetry = MockGetTelemetry,
+    };
+
+    if (FanIpcMockServerOpen(&server, path) < 0)
+    {
+        perror(path);
+        MockControllerClose(&mc);
+        return 1;
+    }
+
+    while (!stopRequested)
+    {
+        MockControllerStep(&mc);
+        if (FanIpcMockServerProcess(&server, &handlers, POLL_MS) < 0)
+        {
+            perror("fanctl_mock");
+            break;
+        }
+    }
+
+    FanIpcMockServerClose(&server, path);
+    MockControllerClose(&mc);
+    return 0;
+}
+
+/* ── Client ───────────────────────────────────────────────────────── */
+
+static Result CallState(int fd, FanIpcState *state)
+{
+    size_t size;
+    Result rc = FanIpcMockCall(fd, FanIpcCmd_GetState, NULL, 0, state, sizeof(*state), &size, NULL);
+    if (R_SUCCEEDED(rc) && size != sizeof(*state))
+        return FAN_IPC_MOCK_TRANSPORT_ERROR;
+    return rc;
+}
+
+static Result CallMode(int fd, u32 mode)
+{
+    return FanIpcMockCall(fd, FanIpcCmd_SetMode, &mode, sizeof(mode), NULL, 0, NULL, NULL);
+}
+
+static Result CallTable(int fd, const TemperaturePoint *tbl, size_t count)
+{
+    FanIpcTable table;
+
+    if (count > FAN_CURVE_MAX_POINTS)
+        return FAN_IPC_RESULT(FanIpcError_BadTable);
+
+    memset(&table, 0, sizeof(table));
+    table.count = count;
+    memcpy(table.points, tbl, count * sizeof(*tbl));
+    return FanIpcMockCall(fd, FanIpcCmd_SetTable, &table, FAN_IPC_TABLE_SIZE(count),
+                          NULL, 0, NULL, NULL);
+}
+
+static Result CallSimple(int fd, u32 cmd)
+{
+    return FanIpcMockCall(fd, cmd, NULL, 0, NULL, 0, NULL, NULL);
+}
+
+/* Maps the server's telemetry ring read-only into shm. */
+static Result CallTelemetry(int fd, FanShm *shm, const FanTelemetryRing **ring)
+{
+    FanIpcTelemetryInfo info;
+    Handle handle;
+    size_t size;
+
+    Result rc = FanIpcMockCall(fd, FanIpcCmd_GetTelemetry, NULL, 0, &info, sizeof(info),
+                               &size, &handle);
+    if (R_FAILED(rc))
+        return rc;
+    if (size != sizeof(info) || handle == INVALID_HANDLE ||
+        FanShmMapRemote(shm, handle, info.size, false) < 0)
+        return FAN_IPC_MOCK_TRANSPORT_ERROR;
+
+    *ring = shm->addr;
+    if (!FanTelemetryRingValid(*ring))
+    {
+        FanShmClose(shm);
+        return FAN_IPC_RESULT(FanIpcError_Unavailable);
+    }
+    return 0;
+}
+
+static void PrintState(const FanIpcState *s)
+{
+    printf("soc %.2f C  pcb %.2f C  target %.3f  applied %.3f  mode %s%s\n",
+           s->socC, s->pcbC, s->targetLevel, s->appliedLevel,
+           s->mode == FanControlMode_Pid ? "pid" : "curve",
+           s->paused ? "  (paused)" : "");
+    printf("writes %llu issued / %llu suppressed  read failures %llu  "
+           "interval %.1f ms  %u wakeups/min\n",
+           (unsigned long long)s->writesIssued, (unsigned long long)s->writesSuppressed,
+           (unsigned long long)s->readFailures, (double)s->lastIntervalNs / 1e6,
+           s->wakeupsPerMinute);
+    printf("supervisor %s  write faults %llu  recoveries %llu (last %.1f ms, max %.1f ms)  "
+           "handbacks %u\n",
+           FanSupervisorStateName((FanSupervisorState)s->supervisorState),
+           (unsigned long long)s->writeFaults, (unsigned long long)s->recoveries,
+           (double)s->lastRecoveryNs / 1e6, (double)s->maxRecoveryNs / 1e6, s->handbacks);
+    printf("pwm readback %.3f  overwritten %llu  re-asserts %llu\n", s->pwmLevel,
+           (unsigned long long)s->dutyMismatches, (unsigned long long)s->reasserts);
+}
+
+/* Parses "T:L,T:L,..." into tbl; returns the point count or 0. */
+static size_t ParseTable(const char *arg, TemperaturePoint *tbl)
+{
+    size_t count = 0;
+    const char *p = arg;
+
+    while (*p && count < FAN_CURVE_MAX_POINTS)
+    {
+        int   t;
+        float l;
+        int   used;
+
+        if (sscanf(p, "%d:%f%n", &t, &l, &used) != 2)
+            return 0;
+        tbl[count].temperature_c = t;
+        tbl[count].fanLevel_f    = l;
+        count++;
+
+        p += used;
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return 0;
+    }
+    return *p == '\0' ? count : 0;
+}
+
+static int Call(const char *path, int argc, char *argv[])
+{
+    int fd = FanIpcMockConnect(path);
+    if (fd < 0)
+    {
+        perror(path);
+        return 1;
+    }
+
+    Result rc;
+    const char *cmd = argv[0];
+
+    if (strcmp(cmd, "state") == 0)
+    {
+        FanIpcState state;
+        rc = CallState(fd, &state);
+        if (R_SUCCEEDED(rc))
+            PrintState(&state);
+    }
+    else if (strcmp(cmd, "mode") == 0 && argc == 2 &&
+             (strcmp(argv[1], "pid") == 0 || strcmp(argv[1], "curve") == 0))
+    {
+        rc = CallMode(fd, strcmp(argv[1], "pid") == 0 ? FanControlMode_Pid : FanControlMode_Curve);
+    }
+    else if (strcmp(cmd, "telemetry") == 0)
+    {
+        /* The last few samples, read from shared memory with no requests. */
+        FanShm shm;
+        const FanTelemetryRing *ring;
+        rc = CallTelemetry(fd, &shm, &ring);
+        if (R_SUCCEEDED(rc))
+        {
+            FanTelemetrySample samples[8];
+            u64 cursor = atomic_load(&ring->head);
+            cursor = cursor > 8 ? cursor - 8 : 0;
+            size_t n = FanTelemetryReadSince(ring, &cursor, samples, 8, NULL);
+            printf("fan up %u us after launch\n", FanTelemetryFirstWriteUs(ring));
+            for (size_t i = 0; i < n; i++)
+                printf("%10.3f s  soc %.2f C  pcb %.2f C  target %.3f  duty %.3f  loop %u ns\n",
+                       (double)samples[i].timestampNs / 1e9, samples[i].socC, samples[i].pcbC,
+                       samples[i].targetLevel, samples[i].dutyLevel, samples[i].loopLatencyNs);
+            FanShmClose(&shm);
+        }
+    }
+    else if (strcmp(cmd, "pause") == 0)
+    {
+        rc = CallSimple(fd, FanIpcCmd_Pause);
+    }
+    else if (strcmp(cmd, "resume") == 0)
+    {
+        rc = CallSimple(fd, FanIpcCmd_Resume);
+    }
+    else if (strcmp(cmd, "table") == 0 && argc == 2)
+    {
+        TemperaturePoint tbl[FAN_CURVE_MAX_POINTS];
+        size_t count = ParseTable(argv[1], tbl);
+        rc = count ? CallTable(fd, tbl, count) : FAN_IPC_RESULT(FanIpcError_BadTable);
+    }
+    else
+    {
+        fprintf(stderr, "unknown command: %s\n", cmd);
+        close(fd);
+        return 1;
+    }
+
+    close(fd);
+    if (R_FAILED(rc))
+    {
+        fprintf(stderr, "%s failed: 0x%x\n", cmd, rc);
+        return 1;
+    }
+    return 0;
+}
+
+/* ── Self test ────────────────────────────────────────────────────── */
+
+typedef struct
+{
+    const char     *path;
+    FanIpcMockServer server;
+    MockController  mc;
+    FanIpcHandlers  handlers;
+    atomic_bool     stop;
+} SelfTestServer;
+
+static void *SelfTestServerThread(void *arg)
+{
+    SelfTestServer *st = arg;
+
+    while (!atomic_load(&st->stop))
+    {
+        MockControllerStep(&st->mc);
+        FanIpcMockServerProcess(&st->server, &st->handlers, POLL_MS);
+    }
+    return NULL;
+}
+
+static int failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+/* Lets the server run a few hundred iterations. */
+static void Settle(void)
+{
+    usleep(200000);
+}
+
+static int SelfTest(void)
+{
+    static SelfTestServer st;
+    char path[64];
+    pthread_t thread;
+
+    snprintf(path, sizeof(path), "/tmp/fanctl_mock.%d.sock", (int)getpid());
+    st.path = path;
+    MockControllerInit(&st.mc);
+    st.handlers = (FanIpcHandlers)
+    {
+        .ctx          = &st.mc,
+        .getState     = MockGetState,
+        .setTable     = MockSetTable,
+        .setMode      = MockSetMode,
+        .setPaused    = MockSetPaused,
+        .getTelemetry = MockGetTelemetry,
+    };
+
+    if (FanIpcMockServerOpen(&st.server, path) < 0)
+    {
+        perror(path);
+        return 1;
+    }
+    pthread_create(&thread, NULL, SelfTestServerThread, &st);
+
+    int fd = FanIpcMockConnect(path);
+    CHECK(fd >= 0);
+
+    FanIpcState state;
+    Settle();
+    CHECK(CallState(fd, &state) == 0);
+    CHECK(state.mode == FanControlMode_Curve);
+    CHECK(!state.paused);
+    CHECK(state.socC > 25.0f);
+    CHECK(state.writesIssued > 0);
+    CHECK(state.supervisorState == FanSupervisorState_Normal && state.writeFaults == 0);
+    CHECK(state.pwmLevel >= 0.0f && state.dutyMismatches == 0);
+
+    /* Mode changes, invalid modes rejected. */
+    CHECK(CallMode(fd, FanControlMode_Pid) == 0);
+    CHECK(CallState(fd, &state) == 0 && state.mode == FanControlMode_Pid);
+    CHECK(CallMode(fd, 7) == FAN_IPC_RESULT(FanIpcError_BadMode));
+    CHECK(CallMode(fd, FanControlMode_Curve) == 0);
+
+    /* Table validation, then a flat full-speed curve takes effect. */
+    TemperaturePoint bad[] = { { 50, 0.5f }, { 40, 0.6f } };
+    TemperaturePoint dup[] = { { 40, 0.5f }, { 40, 0.6f } };
+    TemperaturePoint over[] = { { 40, 0.5f }, { 50, 1.5f } };
+    TemperaturePoint full[] = { { 20, 1.0f }, { 90, 1.0f } };
+    CHECK(CallTable(fd, bad, 2) == FAN_IPC_RESULT(FanIpcError_BadTable));
+    CHECK(CallTable(fd, dup, 2) == FAN_IPC_RESULT(FanIpcError_BadTable));
+    CHECK(CallTable(fd, over, 2) == FAN_IPC_RESULT(FanIpcError_BadTable));
+    CHECK(CallTable(fd, full, 1) == FAN_IPC_RESULT(FanIpcError_BadTable));
+
+    /* A full-resolution curve goes through; the count must match the size. */
+    TemperaturePoint fine[FAN_CURVE_MAX_POINTS];
+    for (int i = 0; i < FAN_CURVE_MAX_POINTS; i++)
+    {
+        fine[i].temperature_c = 30 + i;
+        fine[i].fanLevel_f    = (float)i / (FAN_CURVE_MAX_POINTS - 1);
+    }
+    CHECK(CallTable(fd, fine, FAN_CURVE_MAX_POINTS) == 0);
+    FanIpcTable lying = { .count = 3 };
+    CHECK(FanIpcMockCall(fd, FanIpcCmd_SetTable, &lying, FAN_IPC_TABLE_SIZE(2), NULL, 0, NULL, NULL)
+          == FAN_IPC_RESULT(FanIpcError_BadSize));
+    FanIpcTable second = { .count = 2, .profile = 1 };
+    memcpy(second.points, full, sizeof(full));
+    CHECK(FanIpcMockCall(fd, FanIpcCmd_SetTable, &second, FAN_IPC_TABLE_SIZE(2), NULL, 0, NULL, NULL)
+          == FAN_IPC_RESULT(FanIpcError_BadTable));
+
+    CHECK(CallTable(fd, full, 2) == 0);
+    Settle();
+    CHECK(CallState(fd, &state) == 0);
+    CHECK(state.targetLevel == 1.0f && state.appliedLevel == 1.0f);
+
+    /* Pause stops writes, resume restarts them. */
+    CHECK(CallSimple(fd, FanIpcCmd_Pause) == 0);
+    FanIpcState paused;
+    CHECK(CallState(fd, &paused) == 0 && paused.paused);
+    CHECK(CallTable(fd, defaultCurve, DEFAULT_CURVE_ENTRIES) == 0);
+    Settle();
+    CHECK(CallState(fd, &state) == 0);
+    CHECK(state.writesIssued == paused.writesIssued);
+    CHECK(CallSimple(fd, FanIpcCmd_Resume) == 0);
+    Settle();
+    CHECK(CallState(fd, &state) == 0);
+    CHECK(!state.paused && state.writesIssued > paused.writesIssued);
+
+    /* Malformed requests. */
+    u32 junk = 0;
+    CHECK(FanIpcMockCall(fd, 99, NULL, 0, NULL, 0, NULL, NULL) == FAN_IPC_RESULT(FanIpcError_UnknownCommand));
+    CHECK(FanIpcMockCall(fd, FanIpcCmd_GetState, &junk, sizeof(junk), &state, sizeof(state), NULL, NULL)
+          == FAN_IPC_RESULT(FanIpcError_BadSize));
+    CHECK(FanIpcMockCall(fd, FanIpcCmd_SetTable, &junk, sizeof(junk), NULL, 0, NULL, NULL)
+          == FAN_IPC_RESULT(FanIpcError_BadSize));
+
+    /* Telemetry: the ring is readable without further requests and keeps
+     * moving while the loop runs. */
+    FanShm shm;
+    const FanTelemetryRing *ring = NULL;
+    FanTelemetrySample first, last;
+    CHECK(CallTelemetry(fd, &shm, &ring) == 0);
+    if (ring != NULL)
+    {
+        CHECK(FanTelemetryReadLatest(ring, &first));
+        Settle();
+        CHECK(FanTelemetryReadLatest(ring, &last));
+        CHECK(last.timestampNs > first.timestampNs);
+        CHECK(last.socC > 25.0f && last.dutyLevel >= 0.0f && last.dutyLevel <= 1.0f);
+        CHECK(FanTelemetryFirstWriteUs(ring) > 0);
+
+        u64 cursor = atomic_load(&ring->head) - 4;
+        FanTelemetrySample recent[4];
+        CHECK(FanTelemetryReadSince(ring, &cursor, recent, 4, NULL) == 4);
+        CHECK(recent[0].timestampNs < recent[3].timestampNs);
+        FanShmClose(&shm);
+    }
+
+    /* A second session sees the same state. */
+    int fd2 = FanIpcMockConnect(path);
+    FanIpcState other;
+    CHECK(fd2 >= 0 && CallState(fd2, &other) == 0 && other.mode == state.mode);
+
+    close(fd2);
+    close(fd);
+    atomic_store(&st.stop, true);
+    pthread_join(thread, NULL);
+    FanIpcMockServerClose(&st.server, path);
+    MockControllerClose(&st.mc);
+
+    printf("fanctl_mock selftest: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "selftest") == 0)
+        return SelfTest();
+
+    if (argc >= 2 && strcmp(argv[1], "serve") == 0)
+    {
+        signal(SIGINT, OnSignal);
+        signal(SIGTERM, OnSignal);
+        return Serve(argc >= 3 ? argv[2] : DEFAULT_SOCKET);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "call") == 0)
+    {
+        /* Socket path is optional: anything with a '/' is taken as one. */
+        int argi = 2;
+        const char *path = DEFAULT_SOCKET;
+        if (strchr(argv[argi], '/') != NULL)
+            path = argv[argi++];
+        if (argi < argc)
+            return Call(path, argc - argi, argv + argi);
+    }
+
+    fprintf(stderr,
+            "usage: %s serve [socket]\n"
+            "       %s call [socket] state|telemetry|mode curve|pid|pause|resume|table T:L,...\n"
+            "       %s selftest\n", argv[0], argv[0], argv[0]);
+    return 1;
+}
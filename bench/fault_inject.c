@@ -0,0 +1,312 @@
+/*
+ * Drives the fan supervisor (supervisor.h) down each of its recovery paths
+ * by injecting faults into the simulated fan session, and checks the PWM
+ * readback against a foreign writer:
+ *
+ *   transient     two writes fail; a retry gets through
+ *   session       the session breaks; retries fail until it is reopened
+ *   stuck         writes fail through the retries and reopens, the safe
+ *                 level sticks, and the curve takes over after the hold
+ *   dead          reopens fail too; the fan goes back to the firmware and
+ *                 is taken back by a probe once the fault clears
+ *   intermittent  isolated write failures under a varying load for an
+ *                 hour; none of them may get past a retry
+ *   overwrite     another agent overwrites the level once; the readback
+ *                 notices and the level is re-asserted
+ *   fight         another agent overwrites it every 3 s for an hour;
+ *                 re-asserts stay within their rate limit
+ *
+ *   fault_inject [-v]
+ *
+ * Prints the counters and recovery latency of each scenario and exits
+ * non-zero if one doesn't end in the expected state. -v also prints every
+ * state change.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "supervisor.h"
+#include "hal_sim.h"
+#include "trace.h"
+
+static bool verbose;
+
+static float VaryingPower(void *user, double tS)
+{
+    (void)user;
+    return 8.0f + 4.0f * (float)sin(tS / 20.0);
+}
+
+/* A settled fan only gets written again if something moves it. */
+static float SteadyPower(void *user, double tS)
+{
+    (void)user;
+    (void)tS;
+    return 9.0f;
+}
+
+/* ── Rig ──────────────────────────────────────────────────────────── */
+
+typedef struct
+{
+    FanWriteGateConfig    gateCfg;
+    FanSchedulerConfig    schedCfg;
+    FanControllerSettings settings;
+    FanSupervisorConfig   supCfg;
+    FanSimParams          params;
+    FanCurve              curve;
+    FanSim                sim;
+    FanHal                hal;
+    FanLoop               loop;
+    FanSupervisor         sup;
+
+    u32     visited;        /* mask of FanSupervisorState seen          */
+    bool    safeApplied;    /* fan commanded to the safe level          */
+    bool    firmwareApplied;/* fan at the firmware level after handback */
+    u32     flakyOdds;      /* arm one failing write on 1 in n healthy
+                             * iterations, 0 for none                   */
+    u64     overwrittenNs;  /* time the fan sat off the level written   */
+} Rig;
+
+static void RigInit(Rig *r)
+{
+    *r = (Rig)
+    {
+        .gateCfg  = FAN_WRITE_GATE_DEFAULTS,
+        .schedCfg = FAN_SCHEDULER_DEFAULTS,
+        .settings = FAN_CONTROLLER_SETTINGS_DEFAULTS,
+        .supCfg   = FAN_SUPERVISOR_DEFAULTS,
+        .params   = FAN_SIM_DEFAULTS,
+    };
+
+    FanCurveBuild(&r->curve, defaultCurve, DEFAULT_CURVE_ENTRIES);
+    FanSimInit(&r->sim, &r->params, VaryingPower, NULL);
+    FanSimGetHal(&r->sim, &r->hal);
+
+    r->loop.curve    = &r->curve;
+    r->loop.gateCfg  = &r->gateCfg;
+    r->loop.schedCfg = &r->schedCfg;
+    r->loop.settings = &r->settings;
+    FanLoopInit(&r->loop);
+    FanSupervisorInit(&r->sup);
+    r->visited = 1u << FanSupervisorState_Normal;
+}
+
+/* Runs the supervised loop for seconds of simulated time. */
+static void Run(Rig *r, double seconds)
+{
+    u64 endNs = r->sim.nowNs + (u64)(seconds * 1e9);
+
+    srand(7);
+    while (r->sim.nowNs < endNs)
+    {
+        FanSupervisorState prev = r->sup.state;
+        u64 interval;
+
+        if (r->flakyOdds && r->sup.state == FanSupervisorState_Normal &&
+            r->sim.failWrites == 0 && rand() % r->flakyOdds == 0)
+            r->sim.failWrites = 1;
+
+        FanSupervisorStep(&r->sup, &r->supCfg, &r->loop, &r->hal, &interval);
+
+        FanSupervisorState state = r->sup.state;
+        r->visited |= 1u << state;
+        if (state == FanSupervisorState_SafeLevel && !r->sup.recovering &&
+            r->sim.commandedLevel == r->supCfg.safeLevel)
+            r->safeApplied = true;
+        if (state == FanSupervisorState_Handback &&
+            r->sim.commandedLevel == r->sim.firmwareLevel)
+            r->firmwareApplied = true;
+
+        if (state == FanSupervisorState_Normal && r->loop.gate.applied >= 0.0f &&
+            fabsf(r->sim.commandedLevel - r->loop.gate.applied) > r->gateCfg.verifyTol_f)
+            r->overwrittenNs += interval;
+
+        if (verbose && state != prev)
+            printf("  %9.3f s  %-10s -> %s\n", (double)r->sim.nowNs / 1e9,
+                   FanSupervisorStateName(prev), FanSupervisorStateName(state));
+
+        r->hal.sleepNs(r->hal.ctx, interval);
+    }
+}
+
+static void Report(const char *name, const Rig *r)
+{
+    printf("%-13s %7llu %7llu %7llu %7llu %11.1f %11.1f  %s\n", name,
+           (unsigned long long)r->sup.faults, (unsigned long long)r->sup.recoveries,
+           (unsigned long long)r->sup.reopens, (unsigned long long)r->sup.handbacks,
+           (double)r->sup.lastRecoveryNs / 1e6, (double)r->sup.maxRecoveryNs / 1e6,
+           FanSupervisorStateName(r->sup.state));
+}
+
+/* ── Scenarios ────────────────────────────────────────────────────── */
+
+static int failures;
+
+#define CHECK(name, cond)                                               \
+    do {                                                                \
+        if (!(cond))                                                    \
+        {                                                               \
+            fprintf(stderr, "%s: check failed: %s\n", name, #cond);     \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define VISITED(r, state)   (((r)->visited >> FanSupervisorState_##state) & 1)
+
+/* Faults are armed before the first iteration, whose write is never
+ * gated, so every scenario starts with a failing write. */
+
+static void Transient(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.failWrites = 2;
+    Run(&r, 60.0);
+    Report("transient", &r);
+
+    CHECK("transient", r.sup.state == FanSupervisorState_Normal);
+    CHECK("transient", r.sup.faults == 2 && r.sup.recoveries == 1);
+    CHECK("transient", !VISITED(&r, Reopen) && r.sup.reopens == 0);
+    /* 100 + 200 ms of backoff */
+    CHECK("transient", r.sup.lastRecoveryNs == 300000000ULL);
+}
+
+static void Session(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.sessionBroken = true;
+    Run(&r, 60.0);
+    Report("session", &r);
+
+    CHECK("session", r.sup.state == FanSupervisorState_Normal);
+    CHECK("session", r.sup.faults == 1 + r.supCfg.retries);
+    CHECK("session", r.sup.reopens == 1 && r.sim.reopens == 1);
+    CHECK("session", VISITED(&r, Reopen) && !VISITED(&r, SafeLevel));
+}
+
+static void Stuck(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.failWrites = 1 + r.supCfg.retries + r.supCfg.reopens;
+    Run(&r, 10.0);
+
+    CHECK("stuck", r.sup.state == FanSupervisorState_SafeLevel && r.safeApplied);
+    CHECK("stuck", r.loop.gate.applied == r.supCfg.safeLevel);
+
+    Run(&r, (double)r.supCfg.safeHoldNs / 1e9 + 60.0);
+    Report("stuck", &r);
+
+    CHECK("stuck", r.sup.state == FanSupervisorState_Normal && r.loop.fixedLevel < 0.0f);
+    CHECK("stuck", r.sup.recoveries == 1 && r.sup.handbacks == 0);
+    /* The curve ramps down from the safe level rather than dropping. */
+    CHECK("stuck", r.loop.gate.applied < r.supCfg.safeLevel && r.loop.gate.applied > 0.0f);
+}
+
+static void Dead(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.sessionBroken = true;
+    r.sim.failReopens   = UINT32_MAX;
+    Run(&r, 120.0);
+
+    CHECK("dead", r.sup.state == FanSupervisorState_Handback && r.firmwareApplied);
+    CHECK("dead", r.sup.handbacks == 1 && r.sim.releases >= 1);
+    CHECK("dead", r.loop.released && r.loop.gate.applied < 0.0f);
+    CHECK("dead", r.sup.recoveries == 0);
+
+    /* Readings keep coming while the firmware has the fan. */
+    u64 reads = r.sim.sensorReads;
+    r.sim.failReopens = 0;
+    Run(&r, (double)r.supCfg.probeNs / 1e9 + 10.0);
+    Report("dead", &r);
+
+    CHECK("dead", r.sim.sensorReads > reads);
+    CHECK("dead", r.sup.state == FanSupervisorState_Normal && !r.loop.released);
+    CHECK("dead", r.sup.recoveries == 1 && r.sup.lastRecoveryNs > r.supCfg.probeNs);
+    CHECK("dead", r.loop.gate.applied >= 0.0f);
+}
+
+static void Intermittent(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.flakyOdds = 20;
+    Run(&r, 3600.0);
+    Report("intermittent", &r);
+
+    CHECK("intermittent", r.sup.faults > 0 && r.sup.recoveries == r.sup.faults);
+    CHECK("intermittent", !VISITED(&r, Reopen) && !VISITED(&r, SafeLevel) &&
+                          !VISITED(&r, Handback));
+    CHECK("intermittent", r.sup.maxRecoveryNs <= r.supCfg.backoffNs);
+    CHECK("intermittent", fabsf(r.loop.gate.applied - r.loop.target) < 0.1f);
+}
+
+static void Overwrite(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.power           = SteadyPower;
+    r.sim.foreignLevel    = 0.0f;
+    r.sim.foreignNextNs   = 60000000000ULL;
+    r.sim.foreignPeriodNs = UINT64_MAX / 2;
+    Run(&r, 120.0);
+    Report("overwrite", &r);
+    printf("%-13s overwritten %llu times, %llu re-asserts, %.1f s off level\n", "",
+           (unsigned long long)r.loop.dutyMismatches, (unsigned long long)r.loop.reasserts,
+           (double)r.overwrittenNs / 1e9);
+
+    CHECK("overwrite", r.sim.foreignWrites == 1);
+    CHECK("overwrite", r.loop.dutyMismatches == 1 && r.loop.reasserts == 1);
+    CHECK("overwrite", r.overwrittenNs <= r.gateCfg.verifyNs + r.schedCfg.maxIntervalNs);
+    CHECK("overwrite", fabsf(r.sim.commandedLevel - r.loop.gate.applied) < 0.001f);
+    CHECK("overwrite", r.sup.faults == 0);
+}
+
+static void Fight(void)
+{
+    static Rig r;
+    RigInit(&r);
+    r.sim.power           = SteadyPower;
+    r.sim.foreignLevel    = 0.0f;
+    r.sim.foreignNextNs   = 60000000000ULL;
+    r.sim.foreignPeriodNs = 3000000000ULL;
+    Run(&r, 3600.0);
+    Report("fight", &r);
+
+    double offShare = (double)r.overwrittenNs / 3600e9;
+    printf("%-13s overwritten %llu times, %llu re-asserts, %.0f%% of the time off level\n", "",
+           (unsigned long long)r.loop.dutyMismatches, (unsigned long long)r.loop.reasserts,
+           offShare * 100.0);
+
+    CHECK("fight", r.loop.reasserts > 0);
+    CHECK("fight", r.loop.reasserts <= 3600000000000ULL / r.gateCfg.reassertHoldNs + 1);
+    CHECK("fight", r.loop.dutyMismatches >= r.loop.reasserts);
+    /* Each overwrite is found within verifyNs, and put right within
+     * reassertHoldNs of the last re-assert. */
+    CHECK("fight", offShare < 0.75);
+}
+
+int main(int argc, char *argv[])
+{
+    verbose = argc >= 2 && strcmp(argv[1], "-v") == 0;
+
+    printf("%-13s %7s %7s %7s %7s %11s %11s  %s\n", "scenario", "faults", "recov",
+           "reopens", "handback", "last ms", "max ms", "end state");
+    Transient();
+    Session();
+    Stuck();
+    Dead();
+    Intermittent();
+    Overwrite();
+    Fight();
+
+    printf("fault_inject: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
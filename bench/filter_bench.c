@@ -0,0 +1,280 @@
+/*
+ * Temperature filter benchmark: feeds a noisy, glitchy copy of a trace
+ * through each FanFilter mode and reports its CPU cost and how closely it
+ * follows the clean signal.
+ *
+ *   filter_bench [-i interval_ms] [trace.csv]
+ *
+ * Readings are taken every interval_ms (default 500, about what the
+ * scheduler settles at under load) with 0.3 C of Gaussian noise, and 2% of
+ * them are replaced by a glitch 15-30 C off, like a bad I2C read. Without
+ * a trace a built-in 45 -> 70 -> 50 C profile is used.
+ *
+ *   ns/upd   CPU time per FanFilterUpdate (host CPU)
+ *   rms      RMS error against the clean signal
+ *   spike    worst error while the clean signal was flat, i.e. what a
+ *            glitch gets through
+ *   lag      shift of the clean signal that best matches the output
+ *   t90      time to 90% of a clean 40 -> 70 C step
+ *
+ * With the default interval and the built-in profile, exits non-zero if a
+ * median or Kalman filter lets a glitch through (spike over SPIKE_LIMIT_C)
+ * or takes over T90_LIMIT_S on the step.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "controller.h"
+#include "trace.h"
+
+#define NOISE_SIGMA_C       0.3f
+#define GLITCH_PERCENT      2
+#define FLAT_WINDOW_S       10.0f
+#define MAX_LAG_S           10.0f
+#define SPEED_UPDATES       10000000L
+#define SPIKE_LIMIT_C       3.0f
+#define T90_LIMIT_S         3.0f
+
+static TracePoint builtinProfile[] =
+{
+    {   0.0f, 45.0f }, {  60.0f, 45.0f }, {  61.0f, 70.0f },
+    { 240.0f, 70.0f }, { 300.0f, 50.0f }, { 600.0f, 50.0f },
+};
+
+static TracePoint stepProfile[] =
+{
+    {   0.0f, 40.0f }, {  30.0f, 40.0f }, {  30.001f, 70.0f }, {  60.0f, 70.0f },
+};
+
+static Trace trace =
+{
+    .points = builtinProfile,
+    .count  = sizeof(builtinProfile) / sizeof(builtinProfile[0]),
+};
+
+static const Trace stepTrace =
+{
+    .points = stepProfile,
+    .count  = sizeof(stepProfile) / sizeof(stepProfile[0]),
+};
+
+static const struct { const char *name; FanFilterConfig cfg; } filters[] =
+{
+    { "none",     { .mode = FanFilterMode_None } },
+    { "ema 0.5",  { .mode = FanFilterMode_Ema,    .emaAlpha = 0.5f } },
+    { "ema 0.2",  { .mode = FanFilterMode_Ema,    .emaAlpha = 0.2f } },
+    { "median 3", { .mode = FanFilterMode_Median, .medianWindow = 3 } },
+    { "median 5", { .mode = FanFilterMode_Median, .medianWindow = 5 } },
+    { "kalman",   { .mode = FanFilterMode_Kalman, .kalmanQ = 0.5f, .kalmanR = 0.25f,
+                    .outlierSigma = 4.0f } },
+};
+
+#define FILTER_COUNT (sizeof(filters) / sizeof(filters[0]))
+
+static float Gaussian(void)
+{
+    float u1 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+    float u2 = (float)rand() / (float)RAND_MAX;
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+typedef struct
+{
+    float  *clean;
+    float  *noisy;
+    bool   *flat;       /* clean signal unchanged over FLAT_WINDOW_S */
+    size_t  count;
+    float   intervalS;
+} Signal;
+
+/* Same seed for every call, so each filter sees the same readings. */
+static void SignalBuild(Signal *sig, const Trace *src, float intervalS)
+{
+    sig->intervalS = intervalS;
+    sig->count = (size_t)(TraceDuration(src) / intervalS) + 1;
+    sig->clean = malloc(sig->count * sizeof(float));
+    sig->noisy = malloc(sig->count * sizeof(float));
+    sig->flat  = malloc(sig->count * sizeof(bool));
+
+    srand(1);
+    size_t flatSamples = (size_t)(FLAT_WINDOW_S / intervalS);
+    for (size_t i = 0; i < sig->count; i++)
+    {
+        float clean = TraceTempAt(src, (double)i * intervalS);
+        float noisy = clean + NOISE_SIGMA_C * Gaussian();
+        if (rand() % 100 < GLITCH_PERCENT)
+            noisy = clean + (rand() & 1 ? 1.0f : -1.0f) * (15.0f + (float)(rand() % 16));
+
+        sig->clean[i] = clean;
+        sig->noisy[i] = noisy;
+        sig->flat[i]  = i >= flatSamples;
+        for (size_t j = i - (i >= flatSamples ? flatSamples : i); j < i && sig->flat[i]; j++)
+            sig->flat[i] = fabsf(sig->clean[j] - clean) < 0.01f;
+    }
+}
+
+static void SignalFree(Signal *sig)
+{
+    free(sig->clean);
+    free(sig->noisy);
+    free(sig->flat);
+}
+
+static u64 SampleNs(const Signal *sig, size_t i)
+{
+    return (u64)((double)i * sig->intervalS * 1e9) + 1;
+}
+
+static void RunFilter(const Signal *sig, const FanFilterConfig *cfg, float *out, u64 *outliers)
+{
+    FanFilter filter;
+    FanFilterInit(&filter);
+    for (size_t i = 0; i < sig->count; i++)
+        out[i] = FanFilterUpdate(&filter, cfg, sig->noisy[i], SampleNs(sig, i));
+    *outliers = filter.outliers;
+}
+
+typedef struct
+{
+    double  nsPerUpdate;
+    float   rmsC;
+    float   spikeC;
+    float   lagS;
+    float   t90S;
+    u64     outliers;
+} FilterResult;
+
+static float BestLag(const Signal *sig, const float *out)
+{
+    size_t maxShift = (size_t)(MAX_LAG_S / sig->intervalS);
+    size_t best = 0;
+    double bestErr = INFINITY;
+
+    for (size_t shift = 0; shift <= maxShift && shift < sig->count; shift++)
+    {
+        double err = 0.0;
+        for (size_t i = shift; i < sig->count; i++)
+        {
+            double d = out[i] - sig->clean[i - shift];
+            err += d * d;
+        }
+        err /= (double)(sig->count - shift);
+        if (err < bestErr)
+        {
+            bestErr = err;
+            best = shift;
+        }
+    }
+    return (float)best * sig->intervalS;
+}
+
+static void Evaluate(const Signal *sig, const Signal *step, const FanFilterConfig *cfg,
+                     float *out, FilterResult *res)
+{
+    RunFilter(sig, cfg, out, &res->outliers);
+
+    double sq = 0.0;
+    res->spikeC = 0.0f;
+    for (size_t i = 0; i < sig->count; i++)
+    {
+        float err = fabsf(out[i] - sig->clean[i]);
+        sq += (double)err * err;
+        if (sig->flat[i] && err > res->spikeC)
+            res->spikeC = err;
+    }
+    res->rmsC = (float)sqrt(sq / (double)sig->count);
+    res->lagS = BestLag(sig, out);
+
+    /* The step runs without glitches so t90 is the filter's own lag. */
+    u64 unused;
+    RunFilter(step, cfg, out, &unused);
+    res->t90S = NAN;
+    for (size_t i = 0; i < step->count; i++)
+    {
+        float tS = (float)i * step->intervalS;
+        if (tS > stepProfile[1].t && out[i] >= 40.0f + 0.9f * 30.0f)
+        {
+            res->t90S = tS - stepProfile[1].t;
+            break;
+        }
+    }
+
+    FanFilter filter;
+    volatile float sink = 0.0f;
+    FanFilterInit(&filter);
+    double start = NowNs();
+    for (long i = 0; i < SPEED_UPDATES; i++)
+    {
+        size_t s = (size_t)i % sig->count;
+        sink += FanFilterUpdate(&filter, cfg, sig->noisy[s], (u64)i * 500000000ULL + 1);
+    }
+    res->nsPerUpdate = (NowNs() - start) / (double)SPEED_UPDATES;
+}
+
+int main(int argc, char *argv[])
+{
+    int intervalMs = 500;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            intervalMs = atoi(argv[++i]);
+        else if (argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+            intervalMs = 0;
+    }
+    if (intervalMs <= 0)
+    {
+        fprintf(stderr, "usage: %s [-i interval_ms] [trace.csv]\n", argv[0]);
+        return 1;
+    }
+    if (path != NULL && TraceLoad(&trace, path) != 0)
+    {
+        fprintf(stderr, "%s: cannot load trace\n", path);
+        return 1;
+    }
+
+    float intervalS = (float)intervalMs / 1000.0f;
+    Signal sig, step;
+    SignalBuild(&sig, &trace, intervalS);
+    SignalBuild(&step, &stepTrace, intervalS);
+    memcpy(step.noisy, step.clean, step.count * sizeof(float));
+
+    float *out = malloc((sig.count > step.count ? sig.count : step.count) * sizeof(float));
+    bool checked = path == NULL && intervalMs == 500;
+    bool ok = true;
+
+    printf("%zu readings every %d ms, noise %.1f C, %d%% glitches\n\n",
+           sig.count, intervalMs, NOISE_SIGMA_C, GLITCH_PERCENT);
+    printf("%-10s %8s %8s %8s %8s %8s %9s\n",
+           "filter", "ns/upd", "rms C", "spike C", "lag s", "t90 s", "outliers");
+
+    for (size_t f = 0; f < FILTER_COUNT; f++)
+    {
+        FilterResult res;
+        Evaluate(&sig, &step, &filters[f].cfg, out, &res);
+        printf("%-10s %8.2f %8.2f %8.2f %8.1f %8.1f %9llu\n", filters[f].name,
+               res.nsPerUpdate, res.rmsC, res.spikeC, res.lagS, res.t90S,
+               (unsigned long long)res.outliers);
+
+        bool rejects = filters[f].cfg.mode == FanFilterMode_Median ||
+                       filters[f].cfg.mode == FanFilterMode_Kalman;
+        if (checked && rejects && !(res.spikeC <= SPIKE_LIMIT_C && res.t90S <= T90_LIMIT_S))
+            ok = false;
+    }
+
+    if (checked)
+        printf("\nfilter_bench: %s\n", ok ? "ok" : "FAILED");
+
+    free(out);
+    SignalFree(&sig);
+    SignalFree(&step);
+    if (path != NULL)
+        TraceFree(&trace);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/*
+ * Curve lookup microbenchmark: InterpolateFanLevel (linear scan with float
+ * divides) against FanCurveLutLookup (precompiled Q15 table), plus a dense
+ * sweep that checks the table stays within one Q15 LSB of the scan for the
+ * default curve and a set of random curves. Exits non-zero if it doesn't.
+ *
+ *   lut_bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "controller.h"
+#include "trace.h"
+
+#define CURVE_ENTRIES       DEFAULT_CURVE_ENTRIES
+#define RANDOM_CURVES      200
+#define SWEEP_STEP_C       (1.0f / 1024.0f)
+
+/* Sorted whole-degree knots with arbitrary (non-monotonic) levels. */
+static void RandomCurve(TemperaturePoint *tbl)
+{
+    int t = rand() % 30;
+    for (int i = 0; i < CURVE_ENTRIES; i++)
+    {
+        t += 1 + rand() % 9;
+        tbl[i].temperature_c = t;
+        tbl[i].fanLevel_f    = (float)(rand() % 101) / 100.0f;
+    }
+}
+
+static float MaxErrorLsb(const TemperaturePoint *tbl)
+{
+    FanCurveLut lut;
+    FanCurveLutBuild(&lut, tbl, CURVE_ENTRIES);
+
+    float worst = 0.0f;
+    for (float t = FAN_LUT_MIN_C - 5.0f; t <= FAN_LUT_MAX_C; t += SWEEP_STEP_C)
+    {
+        float ref = InterpolateFanLevel(tbl, CURVE_ENTRIES, t);
+        float err = fabsf((float)FanCurveLutLookupQ15(&lut, t) - ref * FAN_LUT_ONE);
+        if (err > worst)
+            worst = err;
+    }
+    return worst;
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = argc > 1 ? atol(argv[1]) : 10000000L;
+
+    /* ── Equivalence ────────────────────────────────────────────── */
+    srand(1);
+    float worst = MaxErrorLsb(defaultCurve);
+    for (int i = 0; i < RANDOM_CURVES; i++)
+    {
+        TemperaturePoint tbl[CURVE_ENTRIES];
+        RandomCurve(tbl);
+        float err = MaxErrorLsb(tbl);
+        if (err > worst)
+            worst = err;
+    }
+    printf("max |lut - scan|: %.3f LSB over %d curves (limit 1)\n",
+           worst, RANDOM_CURVES + 1);
+
+    /* ── Speed ──────────────────────────────────────────────────── */
+    FanCurveLut lut;
+    FanCurveLutBuild(&lut, defaultCurve, CURVE_ENTRIES);
+
+    static float temps[4096];
+    for (size_t i = 0; i < sizeof(temps) / sizeof(temps[0]); i++)
+        temps[i] = 20.0f + (float)(rand() % 6000) / 100.0f;
+
+    volatile float sink = 0.0f;
+    double start = NowNs();
+    for (long i = 0; i < iterations; i++)
+        sink += InterpolateFanLevel(defaultCurve, CURVE_ENTRIES, temps[i & 4095]);
+    double scanNs = (NowNs() - start) / (double)iterations;
+
+    start = NowNs();
+    for (long i = 0; i < iterations; i++)
+        sink += FanCurveLutLookup(&lut, temps[i & 4095]);
+    double lutNs = (NowNs() - start) / (double)iterations;
+
+    start = NowNs();
+    for (int i = 0; i < 1000; i++)
+        FanCurveLutBuild(&lut, defaultCurve, CURVE_ENTRIES);
+    double buildUs = (NowNs() - start) / 1000.0 / 1e3;
+
+    printf("scan:  %6.2f ns/lookup\n", scanNs);
+    printf("lut:   %6.2f ns/lookup (%.1fx)\n", lutNs, scanNs / lutNs);
+    printf("build: %6.2f us (%zu bytes)\n", buildUs, sizeof(FanCurveLut));
+
+    return worst <= 1.0f ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*
+ * Replays a temperature trace through the curve and PID controllers and
+ * reports overshoot, settling time and fan writes for each.
+ *
+ *   pid_replay [trace.csv]
+ *
+ * The trace is "time_s,temp_c" per line and is taken as the temperature the
+ * SoC would reach with the fan stopped; it is converted to a power draw for
+ * the simulated plant (host/hal_sim.c), and the full control loop runs
+ * against it on a virtual clock. Without a trace a built-in
+ * idle-then-sustained-load profile is used.
+ *
+ * Overshoot is the peak above the PID setpoint; settle time is when the
+ * temperature last left a +/-1 C band around its final value.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "control_loop.h"
+#include "hal_sim.h"
+#include "trace.h"
+
+#define SETTLE_BAND_C        1.0f
+
+static TracePoint builtinProfile[] =
+{
+    {   0.0f, 42.0f }, {  60.0f, 42.0f }, {  61.0f, 82.0f },
+    { 900.0f, 82.0f },
+};
+
+static Trace trace =
+{
+    .points = builtinProfile,
+    .count  = sizeof(builtinProfile) / sizeof(builtinProfile[0]),
+};
+
+typedef struct
+{
+    float   settleRefC;     /* NAN on the first pass        */
+    float   peakC;
+    float   lastOutS;       /* last time outside the band   */
+    double  levelSum;
+    u64     steps;
+} Observer;
+
+static void Observe(void *user, const FanSim *sim)
+{
+    Observer *obs = user;
+
+    if (sim->socC > obs->peakC)
+        obs->peakC = sim->socC;
+    if (!isnan(obs->settleRefC) && fabsf(sim->socC - obs->settleRefC) > SETTLE_BAND_C)
+        obs->lastOutS = (float)sim->nowNs / 1e9f;
+    obs->levelSum += sim->fanLevel;
+    obs->steps++;
+}
+
+typedef struct
+{
+    float   peakC;
+    float   finalC;
+    float   overshootC;
+    float   settleS;
+    u64     writes;
+    u64     suppressed;
+    float   meanLevel;
+} RunResult;
+
+/* Simulates the whole trace. settleRefC is the temperature the settle time
+ * is measured against; pass NAN on the first run to learn it. */
+static void Simulate(FanControlMode mode, float settleRefC, RunResult *res)
+{
+    FanWriteGateConfig    gateCfg  = FAN_WRITE_GATE_DEFAULTS;
+    FanSchedulerConfig    schedCfg = FAN_SCHEDULER_DEFAULTS;
+    FanControllerSettings settings = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+    FanSimParams          params   = FAN_SIM_DEFAULTS;
+    FanSim  sim;
+    FanHal  hal;
+    FanCurve fanCurve;
+    Observer obs = { .settleRefC = settleRefC };
+
+    settings.mode = mode;
+
+    FanLoop loop =
+    {
+        .curve      = &fanCurve,
+        .gateCfg    = &gateCfg,
+        .schedCfg   = &schedCfg,
+        .settings   = &settings,
+    };
+    FanCurveBuild(&fanCurve, defaultCurve, DEFAULT_CURVE_ENTRIES);
+    FanLoopInit(&loop);
+
+    trace.params = &params;
+    FanSimInit(&sim, &params, TracePower, &trace);
+    sim.observer     = Observe;
+    sim.observerUser = &obs;
+    /* Start from the first trace point's steady state, not from ambient. */
+    sim.socC  = TraceTempAt(&trace, 0.0);
+    sim.sinkC = params.ambientC + (sim.socC - params.ambientC) * params.sinkToAmbientR /
+                (params.socToSinkR + params.sinkToAmbientR);
+    obs.peakC = sim.socC;
+    FanSimGetHal(&sim, &hal);
+
+    const u64 endNs = (u64)((double)TraceDuration(&trace) * 1e9);
+    while (sim.nowNs < endNs)
+    {
+        u64 interval;
+        FanLoopStep(&loop, &hal, &interval);
+        hal.sleepNs(hal.ctx, interval);
+    }
+
+    res->peakC      = obs.peakC;
+    res->finalC     = sim.socC;
+    res->overshootC = obs.peakC - settings.pid.setpointC;
+    res->settleS    = obs.lastOutS;
+    res->writes     = loop.gate.writesIssued;
+    res->suppressed = loop.gate.writesSuppressed;
+    res->meanLevel  = obs.steps ? (float)(obs.levelSum / (double)obs.steps) : 0.0f;
+}
+
+static void Run(FanControlMode mode, RunResult *res)
+{
+    RunResult first;
+    Simulate(mode, NAN, &first);
+    Simulate(mode, first.finalC, res);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && TraceLoad(&trace, argv[1]) != 0)
+        return 1;
+
+    static const struct { FanControlMode mode; const char *name; } modes[] =
+    {
+        { FanControlMode_Curve, "curve" },
+        { FanControlMode_Pid,   "pid"   },
+    };
+
+    printf("%-6s %8s %8s %14s %10s %8s %11s %9s\n",
+           "mode", "peak C", "final C", "overshoot C", "settle s",
+           "writes", "suppressed", "mean fan");
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        RunResult r;
+        Run(modes[i].mode, &r);
+        printf("%-6s %8.2f %8.2f %14.2f %10.1f %8llu %11llu %8.1f%%\n",
+               modes[i].name, r.peakC, r.finalC, r.overshootC, r.settleS,
+               (unsigned long long)r.writes, (unsigned long long)r.suppressed,
+               r.meanLevel * 100.0f);
+    }
+    return 0;
+}
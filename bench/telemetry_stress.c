@@ -0,0 +1,266 @@
+/*
+ * Reader/writer stress test for the telemetry ring. One writer process
+ * publishes samples as fast as it can into a shared memfd while reader
+ * processes map it read-only and poll it, half with FanTelemetryReadLatest
+ * and half with FanTelemetryReadSince. Every sample is derived from its
+ * index, so a reader can tell a torn copy from a real one.
+ *
+ *   telemetry_stress [-n samples] [-r readers]
+ *
+ * Exits non-zero if any reader saw a torn sample, went backwards, or
+ * skipped samples without them being reported as dropped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "shm_host.h"
+#include "telemetry.h"
+#include "trace.h"
+
+#define DEFAULT_SAMPLES  2000000ULL
+#define DEFAULT_READERS  4
+#define MAX_READERS      16
+#define BATCH            16
+
+/* Shared between the processes next to the ring. */
+typedef struct
+{
+    FanTelemetryRing    ring;
+    atomic_bool         writerDone;
+    atomic_int          readersReady;
+} StressBlock;
+
+/* ── Sample encoding ──────────────────────────────────────────────── */
+
+static void MakeSample(u64 index, FanTelemetrySample *s)
+{
+    u32 mix = (u32)(index * 2654435761u);
+
+    s->timestampNs   = index;
+    s->socC          = (float)(index & 0xFFFF);
+    s->pcbC          = -(float)(index & 0xFFFF);
+    s->targetLevel   = (float)(mix & 0xFF) / 255.0f;
+    s->dutyLevel     = (float)((mix >> 8) & 0xFF) / 255.0f;
+    s->loopLatencyNs = mix;
+    s->result        = mix ^ 0x5A5A5A5A;
+    s->battC         = (float)(mix & 0x3F);
+    s->controlC      = (float)((mix >> 6) & 0x3F);
+    s->flags         = mix & (FAN_TELEMETRY_READ_FAILED | FAN_TELEMETRY_STATE_MASK);
+    s->faults        = mix >> 16;
+    s->recoveryUs    = mix * 3;
+    s->pwmLevel      = (float)(~mix & 0xFF) / 255.0f;
+}
+
+static bool SampleConsistent(const FanTelemetrySample *s)
+{
+    FanTelemetrySample expect;
+    MakeSample(s->timestampNs, &expect);
+    return memcmp(s, &expect, sizeof(expect)) == 0;
+}
+
+/* ── Writer / readers ─────────────────────────────────────────────── */
+
+static void Writer(StressBlock *block, u64 samples, int readers)
+{
+    FanTelemetrySample s;
+
+    /* Don't start until every reader is polling. */
+    while (atomic_load(&block->readersReady) < readers)
+        ;
+
+    double start = NowNs();
+    for (u64 i = 0; i < samples; i++)
+    {
+        MakeSample(i, &s);
+        FanTelemetryPublish(&block->ring, &s);
+    }
+    double elapsed = NowNs() - start;
+
+    atomic_store(&block->writerDone, true);
+    printf("writer       %llu samples, %.1f ns/publish\n",
+           (unsigned long long)samples, elapsed / (double)samples);
+}
+
+typedef struct
+{
+    u64 reads;          /* samples returned                        */
+    u64 misses;         /* ReadLatest gave up / nothing new        */
+    u64 dropped;        /* ReadSince overwrite reports             */
+    u64 torn;           /* inconsistent samples (must stay 0)      */
+    u64 backwards;      /* ordering violations (must stay 0)       */
+    u64 gaps;           /* unreported skips in ReadSince (must be 0) */
+} ReaderStats;
+
+static void ReaderLatest(const FanTelemetryRing *ring, const StressBlock *block,
+                         ReaderStats *st)
+{
+    FanTelemetrySample s;
+    u64 last = 0;
+    bool any = false;
+
+    while (!atomic_load((atomic_bool *)&block->writerDone))
+    {
+        if (!FanTelemetryReadLatest(ring, &s))
+        {
+            st->misses++;
+            continue;
+        }
+
+        st->reads++;
+        if (!SampleConsistent(&s))
+            st->torn++;
+        else if (any && s.timestampNs < last)
+            st->backwards++;
+
+        last = s.timestampNs;
+        any  = true;
+    }
+}
+
+static void ReaderSince(const FanTelemetryRing *ring, const StressBlock *block,
+                        ReaderStats *st)
+{
+    FanTelemetrySample batch[BATCH];
+    u64 cursor = 0;
+    u64 expected = 0;
+
+    for (;;)
+    {
+        bool done = atomic_load((atomic_bool *)&block->writerDone);
+        u64 before = st->dropped;
+        size_t n = FanTelemetryReadSince(ring, &cursor, batch, BATCH, &st->dropped);
+
+        if (n == 0)
+        {
+            if (done && cursor == atomic_load((_Atomic u64 *)&ring->head))
+                break;
+            st->misses++;
+            continue;
+        }
+
+        u64 lost = st->dropped - before;
+        for (size_t i = 0; i < n; i++)
+        {
+            st->reads++;
+            if (!SampleConsistent(&batch[i]))
+            {
+                st->torn++;
+                continue;
+            }
+            if (batch[i].timestampNs < expected)
+                st->backwards++;
+            else if (batch[i].timestampNs - expected > lost)
+                st->gaps++;
+            else
+                lost -= batch[i].timestampNs - expected;
+            expected = batch[i].timestampNs + 1;
+        }
+    }
+}
+
+static int Reader(int fd, size_t size, StressBlock *block, int id)
+{
+    FanShm shm;
+    ReaderStats st = { 0 };
+
+    if (FanShmMapRemote(&shm, fd, size, false) < 0)
+    {
+        perror("reader mmap");
+        return 1;
+    }
+
+    const StressBlock *view = shm.addr;
+    bool latest = (id % 2) == 0;
+
+    atomic_fetch_add(&block->readersReady, 1);
+    double start = NowNs();
+
+    if (latest)
+        ReaderLatest(&view->ring, view, &st);
+    else
+        ReaderSince(&view->ring, view, &st);
+
+    double elapsed = NowNs() - start;
+    FanShmClose(&shm);
+
+    printf("reader %2d %-6s %9llu reads %6.1f ns/read  misses %llu  dropped %llu  "
+           "torn %llu  backwards %llu  gaps %llu\n",
+           id, latest ? "latest" : "since",
+           (unsigned long long)st.reads, st.reads ? elapsed / (double)st.reads : 0.0,
+           (unsigned long long)st.misses, (unsigned long long)st.dropped,
+           (unsigned long long)st.torn, (unsigned long long)st.backwards,
+           (unsigned long long)st.gaps);
+    fflush(stdout);     /* the child leaves through _exit */
+
+    return (st.torn || st.backwards || st.gaps || st.reads == 0) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    u64 samples = DEFAULT_SAMPLES;
+    int readers = DEFAULT_READERS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1)
+    {
+        if (opt == 'n')
+            samples = strtoull(optarg, NULL, 0);
+        else if (opt == 'r')
+            readers = atoi(optarg);
+        else
+        {
+            fprintf(stderr, "usage: %s [-n samples] [-r readers]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (readers < 1 || readers > MAX_READERS || samples == 0)
+    {
+        fprintf(stderr, "need 1..%d readers and at least one sample\n", MAX_READERS);
+        return 1;
+    }
+
+    FanShm shm;
+    if (FanShmCreate(&shm, sizeof(StressBlock)) < 0)
+    {
+        perror("memfd");
+        return 1;
+    }
+
+    StressBlock *block = shm.addr;
+    FanTelemetryRingInit(&block->ring);
+    atomic_store(&block->writerDone, false);
+    atomic_store(&block->readersReady, 0);
+    fflush(stdout);
+
+    pid_t pids[MAX_READERS];
+    for (int i = 0; i < readers; i++)
+    {
+        pids[i] = fork();
+        if (pids[i] == 0)
+        {
+            /* Readers get their own read-only mapping of the same memfd. */
+            int fd = dup(shm.fd);
+            _exit(Reader(fd, shm.size, block, i));
+        }
+    }
+
+    Writer(block, samples, readers);
+
+    int failed = 0;
+    for (int i = 0; i < readers; i++)
+    {
+        int status;
+        waitpid(pids[i], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            failed++;
+    }
+
+    FanShmClose(&shm);
+    printf("telemetry_stress: %s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "trace.h"
+
+const TemperaturePoint defaultCurve[DEFAULT_CURVE_ENTRIES] =
+{
+    { 25, 0.10f }, { 30, 0.20f }, { 35, 0.30f }, { 40, 0.40f }, { 45, 0.50f },
+    { 50, 0.60f }, { 55, 0.70f }, { 60, 0.80f }, { 65, 0.90f }, { 70, 1.00f },
+};
+
+double NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int TraceLoad(Trace *trace, const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+
+    size_t capacity = 1024;
+    trace->points = malloc(capacity * sizeof(TracePoint));
+    trace->count  = 0;
+
+    char line[256];
+    while (trace->points && fgets(line, sizeof(line), f))
+    {
+        TracePoint p;
+        if (sscanf(line, "%f,%f", &p.t, &p.tempC) != 2)
+            continue;
+
+        if (trace->count == capacity)
+        {
+            capacity *= 2;
+            TracePoint *grown = realloc(trace->points, capacity * sizeof(TracePoint));
+            if (grown == NULL)
+                break;
+            trace->points = grown;
+        }
+        trace->points[trace->count++] = p;
+    }
+    fclose(f);
+
+    if (trace->count < 2)
+    {
+        fprintf(stderr, "%s: need at least two \"time_s,temp_c\" lines\n", path);
+        TraceFree(trace);
+        return -1;
+    }
+    return 0;
+}
+
+void TraceFree(Trace *trace)
+{
+    free(trace->points);
+    trace->points = NULL;
+    trace->count  = 0;
+}
+
+float TraceTempAt(const Trace *trace, double tS)
+{
+    const TracePoint *p = trace->points;
+
+    if (tS <= p[0].t)
+        return p[0].tempC;
+    for (size_t i = 1; i < trace->count; i++)
+    {
+        if (tS <= p[i].t)
+        {
+            float span = p[i].t - p[i - 1].t;
+            float f    = span > 0.0f ? ((float)tS - p[i - 1].t) / span : 1.0f;
+            return p[i - 1].tempC + f * (p[i].tempC - p[i - 1].tempC);
+        }
+    }
+    return p[trace->count - 1].tempC;
+}
+
+float TraceDuration(const Trace *trace)
+{
+    return trace->points[trace->count - 1].t;
+}
+
+float TracePower(void *user, double tS)
+{
+    const Trace *trace = user;
+    return FanSimPowerForTemp(trace->params, TraceTempAt(trace, tS));
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * Pieces shared by the bench tools: "time_s,temp_c" traces, the default
+ * curve and a clock. A trace's temperature is the one the SoC would reach
+ * with the fan stopped; TracePower turns it into a power draw for the
+ * simulated plant.
+ */
+
+#include <stddef.h>
+
+#include "controller.h"
+#include "hal_sim.h"
+
+typedef struct
+{
+    float   t;
+    float   tempC;
+} TracePoint;
+
+typedef struct
+{
+    TracePoint         *points;
+    size_t              count;
+    const FanSimParams *params;     /* plant the power is computed for */
+} Trace;
+
+/* Loads a CSV trace; lines that don't parse (headers) are skipped.
+ * Returns 0 on success. The points are heap-allocated; see TraceFree. */
+int   TraceLoad(Trace *trace, const char *path);
+void  TraceFree(Trace *trace);
+
+float TraceTempAt(const Trace *trace, double tS);
+float TraceDuration(const Trace *trace);
+
+/* FanSimPowerFn over a Trace. */
+float TracePower(void *user, double tS);
+
+/* The curve the sysmodule starts on, defaultTable in fancontrol.c. */
+#define DEFAULT_CURVE_ENTRIES  10
+
+extern const TemperaturePoint defaultCurve[DEFAULT_CURVE_ENTRIES];
+
+/* CLOCK_MONOTONIC in nanoseconds, for timing the tools themselves. */
+double NowNs(void);
@@ -0,0 +1,236 @@
+/*
+ * Converts binary thermal traces (thermal_trace.h) from
+ * sdmc:/config/NX-FanControl/ to CSV.
+ *
+ *   trace2csv [-a] trace.3.bin trace.2.bin trace.1.bin trace.bin > out.csv
+ *   trace2csv selftest
+ *
+ * Files are read in the order given, oldest first, and their records are
+ * concatenated. time_s is relative to the first record, or seconds since
+ * boot with -a; a file from a later boot continues one second after the
+ * previous one ends. The first two columns are the bench "time_s,temp_c" trace
+ * format, so the output feeds pid_replay and fanbench directly. Those take
+ * the temperature as the one the SoC would reach with the fan stopped, so
+ * a recorded trace replays a milder load than the one that produced it.
+ *
+ * selftest round-trips random samples through the encoder, truncated
+ * files included, and exits non-zero on a mismatch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "thermal_trace.h"
+
+#define SELFTEST_SAMPLES    100000
+
+static void PrintTemp(float tempC)
+{
+    if (!isnan(tempC))
+        printf("%.2f", tempC);
+}
+
+static void PrintLevel(float level)
+{
+    if (level >= 0.0f)
+        printf("%.4f", level);
+}
+
+typedef struct
+{
+    bool    absolute;
+    bool    started;
+    double  offsetS;        /* added to the seconds since boot */
+    u64     lastNs;
+    double  lastS;
+} Timeline;
+
+static int Convert(const char *path, Timeline *tl)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    u8 *data = malloc(size > 0 ? (size_t)size : 1);
+    if (data == NULL || fread(data, 1, (size_t)size, file) != (size_t)size)
+    {
+        fprintf(stderr, "%s: read failed\n", path);
+        free(data);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+
+    FanTraceCursor cursor;
+    FanTelemetrySample s;
+    size_t pos;
+
+    if (!FanTraceOpen(&cursor, data, (size_t)size, &pos))
+    {
+        fprintf(stderr, "%s: not a trace file\n", path);
+        free(data);
+        return 1;
+    }
+
+    bool firstInFile = true;
+    while (FanTraceDecode(&cursor, data, (size_t)size, &pos, &s))
+    {
+        double bootS = (double)s.timestampNs / 1e9;
+        if (!tl->started)
+            tl->offsetS = tl->absolute ? 0.0 : -bootS;
+        else if (firstInFile && s.timestampNs < tl->lastNs && !tl->absolute)
+            tl->offsetS = tl->lastS + 1.0 - bootS;
+        tl->started = true;
+        tl->lastNs  = s.timestampNs;
+        tl->lastS   = bootS + tl->offsetS;
+        firstInFile = false;
+
+        printf("%.3f,", tl->lastS);
+        PrintTemp(s.socC);      printf(",");
+        PrintTemp(s.pcbC);      printf(",");
+        PrintTemp(s.battC);     printf(",");
+        PrintTemp(s.controlC);  printf(",");
+        PrintLevel(s.targetLevel); printf(",");
+        PrintLevel(s.dutyLevel);
+        printf(",%u,0x%X,%u,%u,%u\n", s.loopLatencyNs / 1000, s.result,
+               (s.flags & FAN_TELEMETRY_READ_FAILED) ? 1 : 0,
+               (s.flags & FAN_TELEMETRY_STATE_MASK) >> FAN_TELEMETRY_STATE_SHIFT,
+               (s.flags & FAN_TELEMETRY_DUTY_MISMATCH) ? 1 : 0);
+    }
+
+    if (pos != (size_t)size)
+        fprintf(stderr, "%s: %zu trailing bytes (partial record)\n", path, (size_t)size - pos);
+    free(data);
+    return 0;
+}
+
+/* ── Self-test ────────────────────────────────────────────────────── */
+
+static float RandomTemp(void)
+{
+    return rand() % 10 == 0 ? NAN : (float)(rand() % 12000) / 100.0f - 20.0f;
+}
+
+static float RandomLevel(void)
+{
+    return rand() % 20 == 0 ? -1.0f : (float)(rand() % 10001) / 10000.0f;
+}
+
+static bool TempMatches(float a, float b)
+{
+    return isnan(a) ? isnan(b) : fabsf(a - b) <= 0.005f + 1e-4f;
+}
+
+static int SelfTest(void)
+{
+    static FanTelemetrySample in[SELFTEST_SAMPLES];
+    static u8 buf[FAN_TRACE_HEADER_SIZE + SELFTEST_SAMPLES * FAN_TRACE_RECORD_MAX];
+    static size_t ends[SELFTEST_SAMPLES];
+    FanTraceCursor cursor;
+    u64 t = 123456789000ULL;
+    size_t size, maxRecord = 0;
+    int errors = 0;
+
+    srand(1);
+    size = FanTraceBegin(&cursor, t, buf);
+    for (size_t i = 0; i < SELFTEST_SAMPLES; i++)
+    {
+        FanTelemetrySample *s = &in[i];
+        t += rand() % 4 == 0 ? (u64)(rand() % 5000) * 1000000ULL : 10000000ULL + (u64)(rand() % 1000) * 1000;
+        memset(s, 0, sizeof(*s));
+        s->timestampNs   = t;
+        s->socC          = rand() % 100 == 0 ? 70.0f : (float)(rand() % 9000) / 100.0f;
+        s->pcbC          = RandomTemp();
+        s->battC         = RandomTemp();
+        s->controlC      = RandomTemp();
+        s->targetLevel   = RandomLevel();
+        s->dutyLevel     = RandomLevel();
+        s->loopLatencyNs = (u32)(rand() % 2000000) / 1000 * 1000;
+        s->result        = rand() % 50 == 0 ? (u32)rand() : 0;
+        s->flags         = (rand() % 30 == 0 ? FAN_TELEMETRY_READ_FAILED : 0) |
+                           (rand() % 40 == 0 ? (u32)(rand() % 5) << FAN_TELEMETRY_STATE_SHIFT : 0) |
+                           (rand() % 50 == 0 ? FAN_TELEMETRY_DUTY_MISMATCH : 0);
+
+        size_t n = FanTraceEncode(&cursor, s, buf + size);
+        if (n > maxRecord)
+            maxRecord = n;
+        size += n;
+        ends[i] = size;
+    }
+
+    /* Decode the whole file and every truncation of its last records. */
+    for (size_t cut = 0; cut <= 2 * FAN_TRACE_RECORD_MAX; cut++)
+    {
+        size_t limit = size - cut, pos, count = 0;
+        FanTelemetrySample out;
+
+        if (!FanTraceOpen(&cursor, buf, limit, &pos))
+        {
+            errors++;
+            break;
+        }
+        while (FanTraceDecode(&cursor, buf, limit, &pos, &out))
+        {
+            const FanTelemetrySample *s = &in[count++];
+            if (out.timestampNs / 1000 != s->timestampNs / 1000 ||
+                !TempMatches(s->socC, out.socC) || !TempMatches(s->pcbC, out.pcbC) ||
+                !TempMatches(s->battC, out.battC) || !TempMatches(s->controlC, out.controlC) ||
+                fabsf(s->targetLevel - out.targetLevel) > 0.00006f ||
+                fabsf(s->dutyLevel - out.dutyLevel) > 0.00006f ||
+                out.loopLatencyNs != s->loopLatencyNs || out.result != s->result ||
+                out.flags != s->flags)
+            {
+                errors++;
+                break;
+            }
+        }
+        /* Exactly the records that fit before the cut come back. */
+        size_t expect = SELFTEST_SAMPLES;
+        while (expect > 0 && ends[expect - 1] > limit)
+            expect--;
+        if (count != expect || pos != (expect ? ends[expect - 1] : FAN_TRACE_HEADER_SIZE))
+            errors++;
+    }
+
+    printf("%d samples, %zu bytes (%.1f bytes/record, max %zu)\n", SELFTEST_SAMPLES, size,
+           (double)(size - FAN_TRACE_HEADER_SIZE) / SELFTEST_SAMPLES, maxRecord);
+    printf("trace2csv selftest: %s\n", errors == 0 && maxRecord <= FAN_TRACE_RECORD_MAX ? "ok" : "FAILED");
+    return errors == 0 && maxRecord <= FAN_TRACE_RECORD_MAX ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    Timeline tl = { 0 };
+    int argi = 1;
+
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0)
+        return SelfTest();
+
+    if (argi < argc && strcmp(argv[argi], "-a") == 0)
+    {
+        tl.absolute = true;
+        argi++;
+    }
+    if (argi >= argc)
+    {
+        fprintf(stderr, "usage: %s [-a] trace.bin ... | selftest\n", argv[0]);
+        return 1;
+    }
+
+    printf("time_s,temp_c,pcb_c,batt_c,control_c,target,duty,latency_us,result,read_failed,supervisor,duty_mismatch\n");
+    for (; argi < argc; argi++)
+    {
+        if (Convert(argv[argi], &tl) != 0)
+            return 1;
+    }
+    return 0;
+}
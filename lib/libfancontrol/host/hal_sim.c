@@ -0,0 +1,187 @@
+#include <math.h>
+
+#include "hal_sim.h"
+#include "controller.h"
+
+/* ── Plant ────────────────────────────────────────────────────────── */
+
+void FanSimInit(FanSim *sim, const FanSimParams *params,
+                FanSimPowerFn power, void *powerUser)
+{
+    sim->params         = *params;
+    sim->power          = power;
+    sim->powerUser      = powerUser;
+    sim->observer       = NULL;
+    sim->observerUser   = NULL;
+
+    sim->nowNs          = 0;
+    sim->socC           = params->ambientC;
+    sim->sinkC          = params->ambientC;
+    sim->fanLevel       = 0.0f;
+    sim->commandedLevel = 0.0f;
+    sim->powerW         = 0.0f;
+    sim->rng            = 0x12345678u;
+
+    sim->failWrites     = 0;
+    sim->failReopens    = 0;
+    sim->sessionBroken  = false;
+    sim->fanOpen        = true;
+    sim->firmwareLevel  = 0.5f;
+    sim->foreignLevel   = 0.0f;
+    sim->foreignPeriodNs = 0;
+    sim->foreignNextNs  = 0;
+
+    sim->sensorReads    = 0;
+    sim->fanWrites      = 0;
+    sim->failedWrites   = 0;
+    sim->reopens        = 0;
+    sim->releases       = 0;
+    sim->foreignWrites  = 0;
+}
+
+static void FanSimStep(FanSim *sim, u64 ns)
+{
+    const FanSimParams *p = &sim->params;
+    float dt = (float)ns / 1e9f;
+
+    sim->powerW = sim->power ? sim->power(sim->powerUser, (double)sim->nowNs / 1e9) : 0.0f;
+
+    if (sim->foreignPeriodNs != 0 && sim->nowNs >= sim->foreignNextNs)
+    {
+        sim->commandedLevel = sim->foreignLevel;
+        sim->foreignNextNs  = sim->nowNs + sim->foreignPeriodNs;
+        sim->foreignWrites++;
+    }
+
+    sim->fanLevel += (sim->commandedLevel - sim->fanLevel) * (1.0f - expf(-dt / p->fanTauS));
+
+    float gSink = 1.0f / p->sinkToAmbientR + p->fanConductance * sim->fanLevel;
+    float qSoc  = (sim->socC - sim->sinkC) / p->socToSinkR;
+    float qAmb  = (sim->sinkC - p->ambientC) * gSink;
+
+    sim->socC  += (sim->powerW - qSoc) * dt / p->socCap;
+    sim->sinkC += (qSoc - qAmb) * dt / p->sinkCap;
+    sim->nowNs += ns;
+
+    if (sim->observer)
+        sim->observer(sim->observerUser, sim);
+}
+
+void FanSimAdvance(FanSim *sim, u64 ns)
+{
+    while (ns > 0)
+    {
+        u64 step = ns < sim->params.stepNs ? ns : sim->params.stepNs;
+        FanSimStep(sim, step);
+        ns -= step;
+    }
+}
+
+float FanSimPowerForTemp(const FanSimParams *params, float tempC)
+{
+    return (tempC - params->ambientC) / (params->socToSinkR + params->sinkToAmbientR);
+}
+
+/* ── HAL backend ──────────────────────────────────────────────────── */
+
+static float FanSimNoise(FanSim *sim)
+{
+    /* xorshift32, deterministic across runs */
+    sim->rng ^= sim->rng << 13;
+    sim->rng ^= sim->rng >> 17;
+    sim->rng ^= sim->rng << 5;
+    return ((float)sim->rng / 4294967295.0f * 2.0f - 1.0f) * sim->params.sensorNoiseC;
+}
+
+static float FanSimQuantize(const FanSim *sim, float tempC)
+{
+    float step = sim->params.sensorStepC;
+    return step > 0.0f ? floorf(tempC / step) * step : tempC;
+}
+
+static Result FanSimReadSensors(void *ctx, u32 sensors, FanSensorSample *out)
+{
+    FanSim *sim = ctx;
+    const FanSimParams *p = &sim->params;
+
+    sim->sensorReads++;
+    out->socC  = FanSimQuantize(sim, sim->socC + FanSimNoise(sim));
+    out->pcbC  = FanSimQuantize(sim, p->ambientC + p->pcbCoupling * (sim->sinkC - p->ambientC));
+    out->battC = NAN;
+    if (sensors & (1u << FanSensor_Battery))
+        out->battC = p->ambientC + p->battCoupling * (sim->sinkC - p->ambientC);
+    return 0;
+}
+
+static Result FanSimSetFanLevel(void *ctx, float level)
+{
+    FanSim *sim = ctx;
+
+    if (!sim->fanOpen || sim->sessionBroken || sim->failWrites > 0)
+    {
+        if (sim->failWrites > 0)
+            sim->failWrites--;
+        sim->failedWrites++;
+        return FAN_SIM_FAULT_RESULT;
+    }
+
+    sim->fanWrites++;
+    sim->commandedLevel = level < 0.0f ? 0.0f : (level > 1.0f ? 1.0f : level);
+    return 0;
+}
+
+/* The PWM register holds the duty in 0.1% steps. */
+static Result FanSimReadFanLevel(void *ctx, float *level_out)
+{
+    FanSim *sim = ctx;
+    *level_out = floorf(sim->commandedLevel * 1000.0f + 0.5f) / 1000.0f;
+    return 0;
+}
+
+static Result FanSimReopenFan(void *ctx)
+{
+    FanSim *sim = ctx;
+
+    sim->reopens++;
+    if (sim->failReopens > 0)
+    {
+        sim->failReopens--;
+        sim->fanOpen = false;
+        return FAN_SIM_FAULT_RESULT;
+    }
+
+    sim->fanOpen       = true;
+    sim->sessionBroken = false;
+    return 0;
+}
+
+static void FanSimReleaseFan(void *ctx)
+{
+    FanSim *sim = ctx;
+
+    sim->releases++;
+    sim->fanOpen        = false;
+    sim->commandedLevel = sim->firmwareLevel;
+}
+
+static u64 FanSimNowNs(void *ctx)
+{
+    return ((FanSim *)ctx)->nowNs;
+}
+
+static void FanSimSleepNs(void *ctx, u64 ns)
+{
+    FanSimAdvance(ctx, ns);
+}
+
+void FanSimGetHal(FanSim *sim, FanHal *hal)
+{
+    hal->ctx         = sim;
+    hal->readSensors = FanSimReadSensors;
+    hal->setFanLevel = FanSimSetFanLevel;
+    hal->readFanLevel = FanSimReadFanLevel;
+    hal->reopenFan   = FanSimReopenFan;
+    hal->releaseFan  = FanSimReleaseFan;
+    hal->nowNs       = FanSimNowNs;
+    hal->sleepNs     = FanSimSleepNs;
+}
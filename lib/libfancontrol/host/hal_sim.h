@@ -0,0 +1,114 @@
+#pragma once
+
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Simulated thermal plant for host builds. A lumped RC model:
+ *
+ *   P(t) -> [SoC, socCap] --socToSinkR--> [heatsink, sinkCap] --R(fan)--> ambient
+ *
+ * where the heatsink-to-ambient conductance grows linearly with the actual
+ * fan level, and the actual fan level follows the commanded one with a
+ * first-order spin-up lag. The clock is virtual: sleepNs integrates the
+ * plant forward instead of blocking, so a run goes as fast as the CPU can
+ * step it.
+ *
+ * Faults can be injected into the fan session between steps to drive the
+ * supervisor's recovery paths. While the session is released the fan runs
+ * at firmwareLevel, standing in for the firmware's own policy. A foreign
+ * writer, like the stock pcv/ptm policy, can overwrite the commanded level
+ * with foreignLevel every foreignPeriodNs.
+ */
+
+typedef struct
+{
+    float   ambientC;
+    float   socCap;             /* J / C                                   */
+    float   sinkCap;            /* J / C                                   */
+    float   socToSinkR;         /* C / W                                   */
+    float   sinkToAmbientR;     /* C / W with the fan stopped              */
+    float   fanConductance;     /* W / C added at 100% fan                 */
+    float   fanTauS;            /* fan spin-up / spin-down time constant   */
+    float   pcbCoupling;        /* PCB = ambient + k * (sink - ambient)    */
+    float   battCoupling;       /* battery, same form as the PCB           */
+    float   sensorStepC;        /* TMP451 resolution                       */
+    float   sensorNoiseC;       /* peak uniform noise added to readings    */
+    u64     stepNs;             /* integration step                        */
+} FanSimParams;
+
+#define FAN_SIM_DEFAULTS                        \
+    {                                           \
+        .ambientC       = 25.0f,                \
+        .socCap         = 3.0f,                 \
+        .sinkCap        = 120.0f,               \
+        .socToSinkR     = 1.5f,                 \
+        .sinkToAmbientR = 4.0f,                 \
+        .fanConductance = 0.75f,                \
+        .fanTauS        = 1.5f,                 \
+        .pcbCoupling    = 0.5f,                 \
+        .battCoupling   = 0.3f,                 \
+        .sensorStepC    = 0.0625f,              \
+        .sensorNoiseC   = 0.0f,                 \
+        .stepNs         = 5000000ULL,           \
+    }
+
+typedef struct FanSim FanSim;
+
+/* SoC power draw in watts at simulated time tS. */
+typedef float (*FanSimPowerFn)(void *user, double tS);
+
+/* Called after every integration step. */
+typedef void (*FanSimObserverFn)(void *user, const FanSim *sim);
+
+struct FanSim
+{
+    FanSimParams        params;
+    FanSimPowerFn       power;
+    void               *powerUser;
+    FanSimObserverFn    observer;
+    void               *observerUser;
+
+    u64     nowNs;
+    float   socC;
+    float   sinkC;
+    float   fanLevel;           /* actual, lags the commanded level        */
+    float   commandedLevel;
+    float   powerW;             /* power during the last step              */
+    u32     rng;
+
+    /* Fault injection */
+    u32     failWrites;         /* the next n fan writes fail              */
+    u32     failReopens;        /* the next n reopens fail                 */
+    bool    sessionBroken;      /* writes fail until a successful reopen   */
+    bool    fanOpen;            /* false once released or a reopen failed  */
+    float   firmwareLevel;      /* fan level while the session is released */
+    float   foreignLevel;
+    u64     foreignPeriodNs;    /* 0 = no foreign writer                   */
+    u64     foreignNextNs;
+
+    u64     sensorReads;
+    u64     fanWrites;
+    u64     failedWrites;
+    u64     reopens;
+    u64     releases;
+    u64     foreignWrites;
+};
+
+void  FanSimInit(FanSim *sim, const FanSimParams *params,
+                 FanSimPowerFn power, void *powerUser);
+void  FanSimAdvance(FanSim *sim, u64 ns);
+void  FanSimGetHal(FanSim *sim, FanHal *hal);
+
+/* Result of an injected fault. */
+#define FAN_SIM_FAULT_RESULT    0xCAFE
+
+/* Power that settles the SoC at tempC with the fan stopped. */
+float FanSimPowerForTemp(const FanSimParams *params, float tempC);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,340 @@
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ipc_mock.h"
+
+#define FAN_IPC_MOCK_MAX_PAYLOAD  sizeof(FanIpcTable)
+
+typedef struct
+{
+    u32 word;       /* cmd in requests, result in replies */
+    u32 size;
+} FanIpcMockFrame;
+
+/* ── Socket helpers ───────────────────────────────────────────────── */
+
+static int FanIpcMockAddress(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+/* Reads the frame header, picking up a descriptor passed alongside it. */
+static bool FanIpcMockReadHeader(int fd, FanIpcMockFrame *frame, Handle *handle)
+{
+    u8 *p = (u8 *)frame;
+    size_t size = sizeof(*frame);
+
+    *handle = INVALID_HANDLE;
+
+    while (size > 0)
+    {
+        union
+        {
+            struct cmsghdr hdr;
+            char           buf[CMSG_SPACE(sizeof(int))];
+        } control;
+        struct iovec  iov = { .iov_base = p, .iov_len = size };
+        struct msghdr msg =
+        {
+            .msg_iov        = &iov,
+            .msg_iovlen     = 1,
+            .msg_control    = control.buf,
+            .msg_controllen = sizeof(control.buf),
+        };
+
+        ssize_t n = recvmsg(fd, &msg, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+            memcpy(handle, CMSG_DATA(cmsg), sizeof(int));
+
+        p += n;
+        size -= (size_t)n;
+    }
+
+    if (size > 0 && *handle != INVALID_HANDLE)
+    {
+        close(*handle);
+        *handle = INVALID_HANDLE;
+    }
+    return size == 0;
+}
+
+/* Sends the frame header with a descriptor attached (SCM_RIGHTS), the
+ * socket equivalent of a HIPC copy handle. */
+static bool FanIpcMockWriteHeader(int fd, const FanIpcMockFrame *frame, Handle handle)
+{
+    union
+    {
+        struct cmsghdr hdr;
+        char           buf[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct iovec  iov = { .iov_base = (void *)frame, .iov_len = sizeof(*frame) };
+    struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+
+    if (handle != INVALID_HANDLE)
+    {
+        memset(&control, 0, sizeof(control));
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type  = SCM_RIGHTS;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &handle, sizeof(int));
+    }
+
+    ssize_t n;
+    do
+        n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    while (n < 0 && errno == EINTR);
+
+    /* Datagram-sized header: a short write here means the peer is gone. */
+    return n == (ssize_t)sizeof(*frame);
+}
+
+static bool FanIpcMockReadAll(int fd, void *buf, size_t size)
+{
+    u8 *p = buf;
+    while (size > 0)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static bool FanIpcMockWriteAll(int fd, const void *buf, size_t size)
+{
+    const u8 *p = buf;
+    while (size > 0)
+    {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/* Reads a frame and its payload; payloads over cap are rejected. A passed
+ * descriptor is returned in handle, or closed if handle is NULL. */
+static bool FanIpcMockReadFrame(int fd, FanIpcMockFrame *frame, void *payload, size_t cap,
+                                Handle *handle)
+{
+    Handle received;
+
+    if (!FanIpcMockReadHeader(fd, frame, &received))
+        return false;
+
+    bool ok = frame->size <= cap && FanIpcMockReadAll(fd, payload, frame->size);
+
+    if (ok && handle != NULL)
+        *handle = received;
+    else if (received != INVALID_HANDLE)
+        close(received);
+    return ok;
+}
+
+static bool FanIpcMockWriteFrame(int fd, u32 word, const void *payload, size_t size,
+                                 Handle handle)
+{
+    FanIpcMockFrame frame = { .word = word, .size = (u32)size };
+    return FanIpcMockWriteHeader(fd, &frame, handle) &&
+           FanIpcMockWriteAll(fd, payload, size);
+}
+
+/* ── Server ───────────────────────────────────────────────────────── */
+
+int FanIpcMockServerOpen(FanIpcMockServer *server, const char *path)
+{
+    struct sockaddr_un addr;
+
+    memset(server, 0, sizeof(*server));
+    server->listenFd = -1;
+
+    if (FanIpcMockAddress(&addr, path) < 0)
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(fd, FAN_IPC_MAX_SESSIONS) < 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    server->listenFd = fd;
+    return 0;
+}
+
+void FanIpcMockServerClose(FanIpcMockServer *server, const char *path)
+{
+    for (int i = 0; i < server->count; i++)
+        close(server->clients[i]);
+    server->count = 0;
+
+    if (server->listenFd >= 0)
+    {
+        close(server->listenFd);
+        server->listenFd = -1;
+        unlink(path);
+    }
+}
+
+static void FanIpcMockDropClient(FanIpcMockServer *server, int index)
+{
+    close(server->clients[index]);
+    server->clients[index] = server->clients[--server->count];
+}
+
+static void FanIpcMockServeClient(FanIpcMockServer *server, int index, const FanIpcHandlers *h)
+{
+    int fd = server->clients[index];
+    FanIpcMockFrame frame;
+    u8 in[FAN_IPC_MOCK_MAX_PAYLOAD];
+    u8 out[FAN_IPC_MOCK_MAX_PAYLOAD];
+    size_t outSize = 0;
+    Handle handle;
+
+    if (!FanIpcMockReadFrame(fd, &frame, in, sizeof(in), NULL))
+    {
+        FanIpcMockDropClient(server, index);
+        return;
+    }
+
+    Result rc = FanIpcDispatch(h, frame.word, in, frame.size, out, sizeof(out),
+                               &outSize, &handle);
+
+    /* Like a HIPC copy handle, the server keeps its own descriptor. */
+    if (!FanIpcMockWriteFrame(fd, rc, out, R_SUCCEEDED(rc) ? outSize : 0, handle))
+        FanIpcMockDropClient(server, index);
+}
+
+int FanIpcMockServerProcess(FanIpcMockServer *server, const FanIpcHandlers *h,
+                            int timeoutMs)
+{
+    struct pollfd fds[1 + FAN_IPC_MAX_SESSIONS];
+
+    fds[0].fd     = server->listenFd;
+    fds[0].events = POLLIN;
+    for (int i = 0; i < server->count; i++)
+    {
+        fds[1 + i].fd     = server->clients[i];
+        fds[1 + i].events = POLLIN;
+    }
+
+    int n = poll(fds, 1 + server->count, timeoutMs);
+    if (n < 0)
+        return errno == EINTR ? 0 : -1;
+    if (n == 0)
+        return 0;
+
+    /* Sessions first, highest index first so drops don't shift the rest. */
+    for (int i = server->count - 1; i >= 0; i--)
+    {
+        if (fds[1 + i].revents & (POLLIN | POLLHUP | POLLERR))
+            FanIpcMockServeClient(server, i, h);
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+        int fd = accept(server->listenFd, NULL, NULL);
+        if (fd < 0)
+            return -1;
+        if (server->count < FAN_IPC_MAX_SESSIONS)
+            server->clients[server->count++] = fd;
+        else
+            close(fd);
+    }
+    return 0;
+}
+
+/* ── Client ───────────────────────────────────────────────────────── */
+
+int FanIpcMockConnect(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (FanIpcMockAddress(&addr, path) < 0)
+        return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+Result FanIpcMockCall(int fd, u32 cmd, const void *in, size_t inSize,
+                      void *out, size_t outCap, size_t *outSize, Handle *outHandle)
+{
+    FanIpcMockFrame frame;
+    u8 payload[FAN_IPC_MOCK_MAX_PAYLOAD];
+    Handle handle = INVALID_HANDLE;
+
+    if (outSize != NULL)
+        *outSize = 0;
+    if (outHandle != NULL)
+        *outHandle = INVALID_HANDLE;
+
+    if (!FanIpcMockWriteFrame(fd, cmd, in, inSize, INVALID_HANDLE) ||
+        !FanIpcMockReadFrame(fd, &frame, payload, sizeof(payload), &handle))
+        return FAN_IPC_MOCK_TRANSPORT_ERROR;
+
+    if (frame.size > outCap)
+    {
+        if (handle != INVALID_HANDLE)
+            close(handle);
+        return FAN_IPC_MOCK_TRANSPORT_ERROR;
+    }
+
+    if (outHandle != NULL)
+        *outHandle = handle;
+    else if (handle != INVALID_HANDLE)
+        close(handle);
+
+    if (frame.size > 0)
+        memcpy(out, payload, frame.size);
+    if (outSize != NULL)
+        *outSize = frame.size;
+    return frame.word;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "fan_ipc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Host stand-in for the fanctl service transport. The console uses HIPC;
+ * here the same FanIpcDispatch runs behind a Unix stream socket so clients
+ * and handlers can be exercised off-device. Frames are
+ *
+ *   request:  u32 cmd,    u32 size, size bytes of payload
+ *   reply:    u32 result, u32 size, size bytes of payload
+ *
+ * in host byte order. Handles travel as SCM_RIGHTS descriptors attached
+ * to the reply header.
+ */
+
+/* Returned by FanIpcMockCall when the socket itself failed. */
+#define FAN_IPC_MOCK_TRANSPORT_ERROR    FAN_IPC_RESULT(0x1FFF)
+
+typedef struct
+{
+    int     listenFd;
+    int     clients[FAN_IPC_MAX_SESSIONS];
+    int     count;
+} FanIpcMockServer;
+
+/* Returns 0 on success, -1 with errno set on failure. */
+int  FanIpcMockServerOpen(FanIpcMockServer *server, const char *path);
+void FanIpcMockServerClose(FanIpcMockServer *server, const char *path);
+
+/* Waits up to timeoutMs for a connection or a request and handles it.
+ * Returns 0 (including on timeout) or -1 on a listening socket error. */
+int  FanIpcMockServerProcess(FanIpcMockServer *server, const FanIpcHandlers *h,
+                             int timeoutMs);
+
+/* Returns a connected socket or -1. */
+int    FanIpcMockConnect(const char *path);
+
+/* One round trip. A descriptor passed back by the server (the HIPC copy
+ * handle equivalent) goes to outHandle, or is closed if that is NULL. */
+Result FanIpcMockCall(int fd, u32 cmd, const void *in, size_t inSize,
+                      void *out, size_t outCap, size_t *outSize, Handle *outHandle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,63 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "shm_host.h"
+
+int FanShmCreate(FanShm *shm, size_t size)
+{
+    memset(shm, 0, sizeof(*shm));
+    shm->fd = -1;
+
+    int fd = memfd_create("fancontrol-shm", MFD_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    if (ftruncate(fd, (off_t)size) < 0)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return FanShmMapRemote(shm, fd, size, true);
+}
+
+int FanShmMapRemote(FanShm *shm, int fd, size_t size, bool writable)
+{
+    int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+
+    shm->fd   = -1;
+    shm->size = 0;
+    shm->addr = NULL;
+
+    void *addr = mmap(NULL, size, prot, MAP_SHARED, fd, 0);
+
+    if (addr == MAP_FAILED)
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    shm->fd   = fd;
+    shm->size = size;
+    shm->addr = addr;
+    return 0;
+}
+
+void FanShmClose(FanShm *shm)
+{
+    if (shm->addr != NULL)
+        munmap(shm->addr, shm->size);
+    if (shm->fd >= 0)
+        close(shm->fd);
+
+    shm->addr = NULL;
+    shm->fd   = -1;
+    shm->size = 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "fancontrol_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Linux stand-in for a libnx SharedMemory block: an anonymous memfd that
+ * the owner maps read/write and hands to other processes (over the mock
+ * IPC socket, or across fork) to map read-only.
+ */
+
+typedef struct
+{
+    int     fd;
+    size_t  size;
+    void   *addr;
+} FanShm;
+
+/* Both return 0 on success, -1 with errno set on failure. */
+int  FanShmCreate(FanShm *shm, size_t size);
+
+/* Maps a block received from the owner; takes ownership of fd. */
+int  FanShmMapRemote(FanShm *shm, int fd, size_t size, bool writable);
+
+void FanShmClose(FanShm *shm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "controller.h"
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * One iteration of the fan control loop, independent of where the sensors
+ * and the fan live: read, compute the target, gate the write, schedule the
+ * next wake-up. The caller owns the thread and does the sleeping.
+ */
+
+#define FAN_LOOP_READ_RETRIES     3
+#define FAN_LOOP_FAILSAFE_C   70.0f   /* assumed temperature if reads fail */
+
+/* After a failed read the last filtered temperature is held this long
+ * before falling back to FAN_LOOP_FAILSAFE_C, so an isolated I2C hiccup
+ * doesn't spin the fan up. */
+#define FAN_LOOP_FAILSAFE_HOLD_NS   5000000000ULL
+
+typedef struct
+{
+    /* Configuration, owned by the caller and read every iteration. The
+     * caller may point curve elsewhere between steps. */
+    const FanCurve              *curve;
+    const FanWriteGateConfig    *gateCfg;
+    const FanSchedulerConfig    *schedCfg;
+    const FanControllerSettings *settings;
+
+    /* Set by the supervisor (supervisor.h). While released nothing is
+     * written; a fixedLevel >= 0 is written instead of the curve. */
+    bool            released;
+    float           fixedLevel;
+
+    /* State */
+    FanWriteGate    gate;
+    FanScheduler    sched;
+    FanPid          pid;
+    FanFilter       filter;
+    FanPredictor    predictor;
+    FanSensorSample sample;         /* last reading the target was based on */
+    float           controlC;       /* fused, filtered temperature         */
+    float           curveC;         /* what the curve saw: controlC, or the
+                                     * model's prediction if enabled        */
+    float           target;
+    u64             lastNs;
+    u64             lastReadNs;     /* time of the last successful read     */
+    bool            readFailed;     /* this iteration used the failsafe     */
+    u64             readFailures;
+    float           pwmLevel;       /* last PWM duty readback, < 0 if none  */
+    u64             verifyNs;       /* time of the last readback            */
+    u64             reassertNs;     /* time of the last re-assert           */
+    bool            dutyMismatch;   /* this iteration found it overwritten  */
+    u64             dutyMismatches;
+    u64             reasserts;
+} FanLoop;
+
+void FanLoopInit(FanLoop *loop);
+
+/* Runs one iteration and stores the time to sleep in interval_out.
+ * Returns the result of the fan write, or 0 if none was needed. */
+Result FanLoopStep(FanLoop *loop, const FanHal *hal, u64 *interval_out);
+
+#ifdef __cplusplus
+}
+#endif
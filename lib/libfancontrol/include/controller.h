@@ -0,0 +1,478 @@
+#pragma once
+
+#include "fancontrol_types.h"
+#include "log_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Platform-independent pieces of the control loop. Nothing in here talks to
+ * a service or reads the clock; callers pass timestamps in nanoseconds.
+ */
+
+typedef struct
+{
+    int     temperature_c;
+    float   fanLevel_f;
+} TemperaturePoint;
+
+/* ── Curve ────────────────────────────────────────────────────────── */
+
+float InterpolateFanLevel(const TemperaturePoint *tbl, size_t count, float tempC);
+
+/*
+ * The curve precompiled into a dense table: one Q15 fan level (32768 = 100%)
+ * every 0.25 C from 0 to 110 C. Knots sit on whole degrees, so every cell
+ * lies on a single curve segment and a lerp between the two neighbouring
+ * entries reproduces InterpolateFanLevel to within one Q15 LSB without a
+ * scan or a divide. Rebuild it whenever the curve changes.
+ */
+
+#define FAN_LUT_MIN_C          0
+#define FAN_LUT_MAX_C        110
+#define FAN_LUT_STEPS_PER_C    4
+#define FAN_LUT_ENTRIES      ((FAN_LUT_MAX_C - FAN_LUT_MIN_C) * FAN_LUT_STEPS_PER_C + 1)
+#define FAN_LUT_ONE          32768
+
+typedef struct
+{
+    u16     level[FAN_LUT_ENTRIES + 1];     /* +1 guard for the lerp */
+} FanCurveLut;
+
+void  FanCurveLutBuild(FanCurveLut *lut, const TemperaturePoint *tbl, size_t count);
+u16   FanCurveLutLookupQ15(const FanCurveLut *lut, float tempC);
+
+static inline float FanCurveLutLookup(const FanCurveLut *lut, float tempC)
+{
+    return (float)FanCurveLutLookupQ15(lut, tempC) * (1.0f / FAN_LUT_ONE);
+}
+
+/* A curve with its compiled table: what the control loop reads. Points are
+ * sorted by strictly increasing temperature. */
+
+#define FAN_CURVE_MIN_POINTS   2
+#define FAN_CURVE_MAX_POINTS  64
+
+typedef struct
+{
+    TemperaturePoint    points[FAN_CURVE_MAX_POINTS];
+    size_t              count;
+    FanCurveLut         lut;
+} FanCurve;
+
+void FanCurveBuild(FanCurve *curve, const TemperaturePoint *tbl, size_t count);
+
+/* ── Write gate ───────────────────────────────────────────────────── */
+
+/*
+ * The slew limit keeps the fan from jumping with every short burst of
+ * heat: the level sent to the gate moves towards the target by at most
+ * slewUp_f / slewDown_f per second (0 = no limit). While such a ramp is
+ * in progress the gate writes at most once per slewStepNs, so a ramp
+ * costs one write per step instead of one per loop iteration.
+ *
+ * Every verifyNs the loop reads the PWM duty back. If it is more than
+ * verifyTol_f off the level last written, something else (the stock
+ * pcv/ptm policy) has overwritten it, and the level is written again, at
+ * most once per reassertHoldNs so the two don't fight on every wake-up.
+ */
+
+typedef struct
+{
+    float   deadband_f;     /* min change in the current direction         */
+    float   hysteresis_f;   /* extra change required to reverse direction  */
+    u64     reverseHoldNs;  /* min time since the last write to reverse    */
+    float   slewUp_f;       /* max rise per second                         */
+    float   slewDown_f;     /* max fall per second                         */
+    u64     slewStepNs;     /* min time between writes while ramping       */
+    u64     verifyNs;       /* PWM readback interval, 0 = never            */
+    float   verifyTol_f;    /* readback mismatch that counts as overwritten */
+    u64     reassertHoldNs; /* min time between re-asserting the level     */
+} FanWriteGateConfig;
+
+#define FAN_WRITE_GATE_DEFAULTS                 \
+    {                                           \
+        .deadband_f     = 0.01f,                \
+        .hysteresis_f   = 0.02f,                \
+        .reverseHoldNs  = 2000000000ULL,        \
+        .slewUp_f       = 0.20f,                \
+        .slewDown_f     = 0.01f,                \
+        .slewStepNs     = 500000000ULL,         \
+        .verifyNs       = 2000000000ULL,        \
+        .verifyTol_f    = 0.02f,                \
+        .reassertHoldNs = 5000000000ULL,        \
+    }
+
+typedef struct
+{
+    float   applied;        /* last level written, < 0 before the first    */
+    s8      direction;      /* +1 rising, -1 falling, 0 unknown            */
+    u64     lastWriteNs;
+    u64     writesIssued;
+    u64     writesSuppressed;
+
+    float   slewLevel;      /* last slew-limited level, < 0 before the first */
+    u64     slewNs;
+    bool    ramping;        /* slewLevel is still short of the target      */
+    bool    retry;          /* last write failed, the next one is ungated  */
+} FanWriteGate;
+
+/* Deadband, hysteresis and readback tolerance in 0..1, slew limits finite
+ * and not negative. */
+bool FanWriteGateConfigValid(const FanWriteGateConfig *cfg);
+void FanWriteGateInit(FanWriteGate *gate);
+
+/* Returns target moved no further from the last slew-limited level than
+ * the slew limits allow for the time since the last call. */
+float FanWriteGateSlew(FanWriteGate *gate, const FanWriteGateConfig *cfg,
+                       float target, u64 nowNs);
+
+/* Returns true if target differs enough from the applied level to be worth
+ * a write; counts a suppressed write otherwise. */
+bool FanWriteGateShouldWrite(FanWriteGate *gate, const FanWriteGateConfig *cfg,
+                             float target, u64 nowNs);
+
+/* Records a level that was successfully written. */
+void FanWriteGateCommit(FanWriteGate *gate, float level, u64 nowNs);
+
+/* Records a failed write. The fan may not be where the gate thinks, so the
+ * next ShouldWrite passes regardless of the deadband. */
+void FanWriteGateFail(FanWriteGate *gate);
+
+/* ── Sampling scheduler ───────────────────────────────────────────── */
+
+/*
+ * Picks the next wake-up from the filtered temperature slope: the loop
+ * sleeps long enough for the temperature to move by about resolutionC, but
+ * never past half the time to the next curve knot in the direction of
+ * travel, clamped to [minIntervalNs, maxIntervalNs].
+ */
+
+/* Bounds on the configured intervals. The telemetry ring is sized for
+ * samples no closer than FAN_SCHEDULER_MIN_INTERVAL_NS. */
+#define FAN_SCHEDULER_MIN_INTERVAL_NS     10000000ULL
+#define FAN_SCHEDULER_MAX_INTERVAL_NS  10000000000ULL
+
+typedef struct
+{
+    u64     minIntervalNs;
+    u64     maxIntervalNs;
+    float   resolutionC;    /* temperature change worth waking up for      */
+    float   slopeAlpha;     /* EMA weight of the newest dT/dt sample       */
+} FanSchedulerConfig;
+
+#define FAN_SCHEDULER_DEFAULTS                  \
+    {                                           \
+        .minIntervalNs  = 10000000ULL,          \
+        .maxIntervalNs  = 1000000000ULL,        \
+        .resolutionC    = 0.1f,                 \
+        .slopeAlpha     = 0.3f,                 \
+    }
+
+typedef struct
+{
+    float   lastTempC;
+    u64     lastNs;
+    float   slopeCps;       /* filtered dT/dt in degrees C per second      */
+    bool    primed;
+
+    u64     windowStartNs;  /* wake-up rate over a rolling minute          */
+    u32     windowWakeups;
+    u32     wakeupsPerMinute;
+} FanScheduler;
+
+/* Intervals ordered and within the bounds above, resolutionC positive,
+ * slopeAlpha in (0, 1]. */
+bool FanSchedulerConfigValid(const FanSchedulerConfig *cfg);
+void FanSchedulerInit(FanScheduler *sched);
+
+/* Records a sample taken at nowNs and returns how long to sleep. */
+u64 FanSchedulerNext(FanScheduler *sched, const FanSchedulerConfig *cfg,
+                     const TemperaturePoint *tbl, size_t count,
+                     float tempC, u64 nowNs);
+
+/* ── Sensor fusion ────────────────────────────────────────────────── */
+
+/*
+ * Turns the sensor readings into the one temperature the curve, the PID
+ * and the scheduler work on. Sensors with a zero weight are left out (and
+ * not read at all); each reading is shifted by its offset first, so e.g.
+ * the battery can be made to look as hot as the SoC it sits next to.
+ *
+ *   Soc       SoC only, ignoring the weights
+ *   Max       hottest shifted reading
+ *   Weighted  weighted mean of the shifted readings
+ *   Curves    each shifted reading through the curve; the reading that
+ *             asks for the most fan wins. Same as Max for a rising curve.
+ *
+ * A reading that isn't finite (the sensor didn't answer) is skipped; with
+ * nothing left the SoC reading is used.
+ */
+
+typedef enum
+{
+    FanSensor_Soc       = 0,
+    FanSensor_Pcb       = 1,
+    FanSensor_Battery   = 2,
+    FanSensor_Count,
+} FanSensor;
+
+typedef enum
+{
+    FanFusionMode_Soc       = 0,
+    FanFusionMode_Max       = 1,
+    FanFusionMode_Weighted  = 2,
+    FanFusionMode_Curves    = 3,
+} FanFusionMode;
+
+#define FAN_FUSION_MAX_OFFSET_C  50.0f
+
+typedef struct
+{
+    u32     mode;                       /* FanFusionMode */
+    float   weight[FanSensor_Count];
+    float   offsetC[FanSensor_Count];
+} FanFusionConfig;
+
+#define FAN_FUSION_DEFAULTS                     \
+    {                                           \
+        .mode    = FanFusionMode_Soc,           \
+        .weight  = { 1.0f, 0.0f, 0.0f },        \
+        .offsetC = { 0.0f, 0.0f, 0.0f },        \
+    }
+
+bool  FanFusionConfigValid(const FanFusionConfig *cfg);
+
+/* Bit mask (1 << FanSensor) of the sensors cfg needs read. */
+u32   FanFusionSensors(const FanFusionConfig *cfg);
+
+float FanFusionTemp(const FanFusionConfig *cfg, const FanCurveLut *lut,
+                    const float tempC[FanSensor_Count]);
+
+/* ── Temperature filter ───────────────────────────────────────────── */
+
+/*
+ * Smooths the fused temperature before the curve, the PID and the
+ * scheduler see it, so a single bad TMP451 read doesn't move the fan.
+ * All state is fixed-size; an update never allocates.
+ *
+ *   None    pass-through
+ *   Ema     exponential moving average, emaAlpha = weight of the newest
+ *   Median  median of the last medianWindow readings (odd, at most
+ *           FAN_FILTER_MEDIAN_MAX); drops spikes shorter than half the
+ *           window at the cost of (window - 1) / 2 samples of lag
+ *   Kalman  1-D random-walk Kalman filter. kalmanQ is how far the real
+ *           temperature may wander (C^2 per second), kalmanR the sensor
+ *           noise (C^2). Readings more than outlierSigma standard
+ *           deviations from the prediction are dropped; after
+ *           FAN_FILTER_MAX_REJECTS in a row the filter takes it as a real
+ *           step and restarts from the reading.
+ */
+
+typedef enum
+{
+    FanFilterMode_None      = 0,
+    FanFilterMode_Ema       = 1,
+    FanFilterMode_Median    = 2,
+    FanFilterMode_Kalman    = 3,
+} FanFilterMode;
+
+#define FAN_FILTER_MEDIAN_MAX   9
+#define FAN_FILTER_MAX_REJECTS  3
+
+typedef struct
+{
+    u32     mode;               /* FanFilterMode */
+    float   emaAlpha;
+    u32     medianWindow;
+    float   kalmanQ;
+    float   kalmanR;
+    float   outlierSigma;
+} FanFilterConfig;
+
+#define FAN_FILTER_DEFAULTS                     \
+    {                                           \
+        .mode           = FanFilterMode_Median, \
+        .emaAlpha       = 0.5f,                 \
+        .medianWindow   = 3,                    \
+        .kalmanQ        = 0.5f,                 \
+        .kalmanR        = 0.25f,                \
+        .outlierSigma   = 4.0f,                 \
+    }
+
+typedef struct
+{
+    float   window[FAN_FILTER_MEDIAN_MAX];  /* ring of recent readings     */
+    u32     head;
+    u32     fill;
+    float   value;              /* last output; EMA / Kalman estimate      */
+    float   variance;           /* Kalman estimate variance                */
+    u64     lastNs;
+    u32     rejectRun;          /* consecutive outliers dropped            */
+    u64     outliers;           /* total outliers dropped                  */
+    bool    primed;
+} FanFilter;
+
+bool  FanFilterConfigValid(const FanFilterConfig *cfg);
+void  FanFilterInit(FanFilter *filter);
+
+/* Feeds one reading taken at nowNs and returns the filtered value. */
+float FanFilterUpdate(FanFilter *filter, const FanFilterConfig *cfg,
+                      float tempC, u64 nowNs);
+
+/* ── Thermal model lookahead ──────────────────────────────────────── */
+
+/*
+ * Lets the curve act on where the temperature is heading instead of where
+ * it is. The plant is taken as first order,
+ *
+ *   dT/dt = (T_inf(level, power) - T) / tau
+ *
+ * with the power draw unknown. Differentiating removes a constant power
+ * and whatever offset the sensor has:
+ *
+ *   ds/dt = a s + b dlevel/dt,   s = dT/dt,  tau = -1/a,  gain = -b/a
+ *
+ * and a and b are fitted by recursive least squares on the filtered
+ * temperature, once every FAN_PREDICT_SAMPLE_NS. With the fan and the load
+ * held where they are, the temperature horizonS ahead is then
+ *
+ *   T + s tau (1 - exp(-horizonS / tau))
+ *
+ * a linear extrapolation of the last slope bent over by the plant's own
+ * settling. The lead is clamped to maxLeadC either way, and is zero until
+ * the fit has FAN_PREDICT_MIN_SAMPLES samples and a tau in range. The gain
+ * is for diagnostics only: in closed loop the fan follows the heat, so it
+ * is biased towards zero or even the wrong sign.
+ */
+
+#define FAN_PREDICT_PARAMS           2
+#define FAN_PREDICT_SAMPLE_NS        2000000000ULL
+#define FAN_PREDICT_GAP_NS          10000000000ULL  /* restart the slope after this */
+#define FAN_PREDICT_MIN_SAMPLES     20
+#define FAN_PREDICT_TAU_MIN_S        1.0f
+#define FAN_PREDICT_TAU_MAX_S      600.0f
+#define FAN_PREDICT_HORIZON_MAX_S   60.0f
+#define FAN_PREDICT_MAX_LEAD_C      20.0f
+
+typedef struct
+{
+    u32     enabled;        /* 0 = the curve sees the filtered reading     */
+    float   horizonS;       /* how far ahead the curve looks               */
+    float   forgetting;     /* RLS forgetting factor per sample, [0.9, 1]  */
+    float   maxLeadC;       /* bound on |prediction - reading|             */
+} FanPredictConfig;
+
+#define FAN_PREDICT_DEFAULTS                    \
+    {                                           \
+        .enabled        = 0,                    \
+        .horizonS       = 5.0f,                 \
+        .forgetting     = 0.995f,               \
+        .maxLeadC       = 8.0f,                 \
+    }
+
+typedef struct
+{
+    double  theta[FAN_PREDICT_PARAMS];      /* a, b                        */
+    double  cov[FAN_PREDICT_PARAMS][FAN_PREDICT_PARAMS];
+    float   lastTempC;
+    float   lastLevel;
+    u64     lastNs;
+    float   slopeCps;       /* dT/dt over the last sample, NAN if none     */
+    u32     samples;        /* model updates so far                        */
+    float   tauS;           /* identified time constant, 0 until trusted   */
+    float   gainC;          /* steady-state C per 100% fan                 */
+    float   predictedC;     /* last value returned                         */
+    bool    primed;
+} FanPredictor;
+
+bool  FanPredictConfigValid(const FanPredictConfig *cfg);
+void  FanPredictorInit(FanPredictor *pred);
+
+/* Feeds the filtered temperature at nowNs and the fan level in effect
+ * (< 0 if unknown, which skips the model update) and returns the
+ * temperature predicted horizonS ahead. */
+float FanPredictorUpdate(FanPredictor *pred, const FanPredictConfig *cfg,
+                         float tempC, float level, u64 nowNs);
+
+/* ── PID ──────────────────────────────────────────────────────────── */
+
+/*
+ * Closed-loop alternative to the curve: drives the fan so the temperature
+ * settles on setpointC. The curve level can be mixed in as feed-forward
+ * (feedForward_f = 0 disables it, 1 adds it in full). Integration stops
+ * while the output is saturated in the direction of the error.
+ */
+
+typedef enum
+{
+    FanControlMode_Curve = 0,
+    FanControlMode_Pid   = 1,
+} FanControlMode;
+
+typedef struct
+{
+    float   setpointC;
+    float   kp;             /* level per degree C                          */
+    float   ki;             /* level per degree C second                   */
+    float   kd;             /* level per degree C per second               */
+    float   feedForward_f;
+    float   outMin_f;
+    float   outMax_f;
+} FanPidConfig;
+
+#define FAN_PID_DEFAULTS                        \
+    {                                           \
+        .setpointC      = 60.0f,                \
+        .kp             = 0.05f,                \
+        .ki             = 0.005f,               \
+        .kd             = 0.02f,                \
+        .feedForward_f  = 0.5f,                 \
+        .outMin_f       = 0.0f,                 \
+        .outMax_f       = 1.0f,                 \
+    }
+
+typedef struct
+{
+    float   integral;
+    float   lastTempC;
+    bool    primed;
+} FanPid;
+
+typedef struct
+{
+    u32             mode;       /* FanControlMode */
+    FanPidConfig    pid;
+    FanFusionConfig fusion;
+    FanFilterConfig filter;
+    FanPredictConfig predict;
+    FanWriteGateConfig gate;
+    FanSchedulerConfig sched;
+    u32             logLevel;   /* FanLogLevel, lower lines are dropped */
+} FanControllerSettings;
+
+#define FAN_CONTROLLER_SETTINGS_DEFAULTS        \
+    {                                           \
+        .mode    = FanControlMode_Curve,        \
+        .pid     = FAN_PID_DEFAULTS,            \
+        .fusion  = FAN_FUSION_DEFAULTS,         \
+        .filter  = FAN_FILTER_DEFAULTS,         \
+        .predict = FAN_PREDICT_DEFAULTS,        \
+        .gate    = FAN_WRITE_GATE_DEFAULTS,     \
+        .sched   = FAN_SCHEDULER_DEFAULTS,      \
+        .logLevel = FanLogLevel_Info,           \
+    }
+
+/* Finite setpoint, gains and feed-forward; 0 <= outMin_f < outMax_f <= 1. */
+bool  FanPidConfigValid(const FanPidConfig *cfg);
+void  FanPidInit(FanPid *pid);
+/* holdIntegral freezes the integral, e.g. while the slew limit keeps the
+ * fan from following the output. */
+float FanPidUpdate(FanPid *pid, const FanPidConfig *cfg,
+                   float tempC, float feedForward, float dtS, bool holdIntegral);
+
+#ifdef __cplusplus
+}
+#endif
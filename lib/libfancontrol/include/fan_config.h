@@ -0,0 +1,223 @@
+#pragma once
+
+#include "controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * On-disk format of config.dat. The file is a fixed header followed by a
+ * payload of tagged records:
+ *
+ *   header:  u32 magic, u16 version, u16 headerSize, u32 payloadSize,
+ *            u32 crc32 (of the payload)
+ *   record:  u16 tag, u16 size, size bytes of data
+ *
+ * All fields are little-endian, which is what both the console and the
+ * host tools are. Readers skip records with tags they don't know, so new
+ * fields can be added as records without a version bump; the version only
+ * changes if existing records change meaning. headerSize lets a later
+ * version grow the header without breaking older readers' bounds checks.
+ *
+ * Files from before the header existed are a bare dump of ten
+ * TemperaturePoints; FanConfigParse recognises them by size, sorts them
+ * (the old overlay didn't enforce an order) and reports
+ * FanConfigResult_Legacy so the caller can rewrite them.
+ */
+
+#define FAN_CONFIG_MAGIC        0x4346584E  /* "NXFC" */
+#define FAN_CONFIG_VERSION      1
+
+/* Read buffer size; anything larger is rejected without parsing. */
+#define FAN_CONFIG_MAX_SIZE     8192
+
+#define FAN_CONFIG_LEGACY_POINTS  10
+
+typedef struct
+{
+    u32     magic;
+    u16     version;
+    u16     headerSize;
+    u32     payloadSize;
+    u32     crc32;
+} FanConfigHeader;
+
+typedef struct
+{
+    u16     tag;
+    u16     size;
+} FanConfigRecord;
+
+/*
+ * Profile 0 is stored as a plain Curve record, so readers that predate
+ * profiles still find a usable curve; its name and every other profile
+ * are extra records those readers skip.
+ */
+typedef enum
+{
+    FanConfigTag_Curve       = 1,   /* s32 temperature_c, f32 fanLevel_f per point */
+    FanConfigTag_Profile     = 2,   /* name[FAN_PROFILE_NAME_MAX], then a curve    */
+    FanConfigTag_ProfileName = 3,   /* name[FAN_PROFILE_NAME_MAX] of profile 0     */
+    FanConfigTag_Rule        = 4,   /* FanProfileRule                              */
+    FanConfigTag_Title       = 5,   /* FanTitleRule                                */
+} FanConfigTag;
+
+/* ── Profiles ─────────────────────────────────────────────────────── */
+
+#define FAN_PROFILE_MAX         8
+#define FAN_PROFILE_NAME_MAX    16      /* including the terminating NUL */
+#define FAN_PROFILE_RULE_MAX    16
+#define FAN_PROFILE_DEFAULT_NAME "Default"
+
+typedef struct
+{
+    char                name[FAN_PROFILE_NAME_MAX];
+    TemperaturePoint    points[FAN_CURVE_MAX_POINTS];
+    size_t              count;
+} FanProfile;
+
+typedef enum
+{
+    FanProfileMatch_Any = 0,
+    FanProfileMatch_Yes = 1,
+    FanProfileMatch_No  = 2,
+} FanProfileMatch;
+
+/* Rules are tried in order and the first match picks the profile; with no
+ * match profile 0 is used. */
+typedef struct
+{
+    u8      profile;            /* index into FanConfig.profiles           */
+    u8      docked;             /* FanProfileMatch                         */
+    u8      charging;           /* FanProfileMatch                         */
+    u8      batteryMax;         /* matches at or below this %, 100 = any   */
+} FanProfileRule;
+
+/* A running application with this title ID uses the given profile,
+ * regardless of the power state rules. */
+#define FAN_TITLE_RULE_MAX      64
+
+typedef struct
+{
+    u64     titleId;            /* program ID, never 0                     */
+    u8      profile;
+    u8      reserved[7];
+} FanTitleRule;
+
+typedef struct
+{
+    FanProfile          profiles[FAN_PROFILE_MAX];
+    size_t              profileCount;
+    FanProfileRule      rules[FAN_PROFILE_RULE_MAX];
+    size_t              ruleCount;
+    FanTitleRule        titles[FAN_TITLE_RULE_MAX];
+    size_t              titleCount;
+} FanConfig;
+
+typedef struct
+{
+    bool    docked;
+    bool    charging;
+    u32     batteryPercent;
+} FanPowerState;
+
+size_t FanProfileSelect(const FanConfig *cfg, const FanPowerState *power);
+
+/* Title rules hashed by title ID: linear probing in a table kept at most
+ * half full, so a lookup touches one or two slots. Rebuilt whenever the
+ * config changes. */
+#define FAN_TITLE_INDEX_BITS    7
+#define FAN_TITLE_INDEX_SIZE    (1 << FAN_TITLE_INDEX_BITS)
+
+typedef struct
+{
+    u64     titleIds[FAN_TITLE_INDEX_SIZE];     /* 0 = empty slot */
+    u8      profiles[FAN_TITLE_INDEX_SIZE];
+} FanTitleIndex;
+
+void   FanTitleIndexBuild(FanTitleIndex *index, const FanConfig *cfg);
+
+/* Returns the profile for titleId, or -1 if it has no rule. */
+int    FanTitleIndexLookup(const FanTitleIndex *index, u64 titleId);
+
+/* Single-profile config named FAN_PROFILE_DEFAULT_NAME. */
+void   FanConfigInitSingle(FanConfig *cfg, const TemperaturePoint *tbl, size_t count);
+
+/* Compares the parts that are stored, ignoring unused entries. */
+bool   FanConfigEqual(const FanConfig *a, const FanConfig *b);
+
+/* ── File format ──────────────────────────────────────────────────── */
+
+typedef enum
+{
+    FanConfigResult_Ok = 0,
+    FanConfigResult_Legacy,         /* parsed, but from a pre-header file */
+    FanConfigResult_Truncated,
+    FanConfigResult_BadMagic,
+    FanConfigResult_BadVersion,
+    FanConfigResult_BadChecksum,
+    FanConfigResult_BadRecord,
+    FanConfigResult_BadCurve,
+    FanConfigResult_NoCurve,
+    FanConfigResult_BadProfile,
+} FanConfigResult;
+
+/* Parses a whole file image. out is only written when the result is Ok or
+ * Legacy. */
+FanConfigResult FanConfigParse(const void *data, size_t size, FanConfig *out);
+
+/* Returns the number of bytes written, or 0 if cfg is invalid or cap is
+ * too small. Unused entries in cfg don't affect the output. */
+size_t      FanConfigSerialize(const FanConfig *cfg, void *buf, size_t cap);
+
+/* FAN_CURVE_MIN_POINTS..FAN_CURVE_MAX_POINTS points with strictly
+ * increasing temperatures inside the LUT range and levels in 0..1. */
+bool        FanConfigCurveValid(const TemperaturePoint *tbl, size_t count);
+
+/* Every curve valid, names NUL-terminated, rules pointing at profiles
+ * that exist, title IDs non-zero and unique. */
+bool        FanConfigValid(const FanConfig *cfg);
+u32         FanConfigCrc32(const void *data, size_t size);
+const char *FanConfigResultString(FanConfigResult result);
+
+/* ── Settings file ────────────────────────────────────────────────── */
+
+/*
+ * settings.dat uses the same header and record layout as config.dat, with
+ * its own magic. Each block of FanControllerSettings is one record; blocks
+ * without a record keep their defaults, and unknown tags are skipped.
+ */
+
+#define FAN_SETTINGS_MAGIC      0x5346584E  /* "NXFS" */
+#define FAN_SETTINGS_VERSION    1
+#define FAN_SETTINGS_MAX_SIZE   512
+
+typedef enum
+{
+    FanSettingsTag_Mode    = 1,     /* u32 FanControlMode  */
+    FanSettingsTag_Pid     = 2,     /* FanPidConfig        */
+    FanSettingsTag_Fusion  = 3,     /* FanFusionConfig     */
+    FanSettingsTag_Filter  = 4,     /* FanFilterConfig     */
+    FanSettingsTag_Predict = 5,     /* FanPredictConfig    */
+    FanSettingsTag_Gate    = 6,     /* FanWriteGateConfig  */
+    FanSettingsTag_Sched   = 7,     /* FanSchedulerConfig  */
+    FanSettingsTag_Log     = 8,     /* u32 FanLogLevel     */
+} FanSettingsTag;
+
+/* Mode and log level known, every block passing its *ConfigValid check, and a ramp step
+ * no shorter than the scheduler's minimum interval, since the loop wakes
+ * up once per step while ramping. */
+bool            FanSettingsValid(const FanControllerSettings *settings);
+
+/* Parses a whole file image on top of the defaults. out is only written
+ * when the result is Ok; invalid settings are FanConfigResult_BadRecord. */
+FanConfigResult FanSettingsParse(const void *data, size_t size, FanControllerSettings *out);
+
+/* Returns the number of bytes written, or 0 if settings is invalid or cap
+ * is too small. */
+size_t          FanSettingsSerialize(const FanControllerSettings *settings, void *buf, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
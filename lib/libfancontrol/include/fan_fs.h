@@ -0,0 +1,42 @@
+#pragma once
+
+#include <switch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Whole-file SD card access straight through the fs service. Unlike stdio
+ * and the fsdev devoptab underneath it, nothing here touches the heap: no
+ * FILE structs or stdio buffers, no devoptab handles, no working
+ * directory. Paths are absolute from the root of the SD card. The SD card
+ * file system is opened on first use and stays open until FanFsClose.
+ */
+
+bool   FanFsExists(const char *path);
+
+/* Creates path and any missing parents. */
+Result FanFsCreateDir(const char *path);
+
+/* Size and modification time, to tell whether a file changed without
+ * reading it. modified is 0 if the file system keeps no time stamp. */
+Result FanFsStat(const char *path, u64 *size_out, u64 *modified_out);
+
+/* Reads up to size bytes from the start of the file. */
+Result FanFsRead(const char *path, void *buf, size_t size, size_t *read_out);
+
+/* Replaces the file's contents, creating it if needed. */
+Result FanFsWrite(const char *path, const void *buf, size_t size);
+
+/* Appends to the file, creating it if needed. */
+Result FanFsAppend(const char *path, const void *buf, size_t size);
+
+Result FanFsRemove(const char *path);
+Result FanFsRename(const char *from, const char *to);
+
+void   FanFsClose(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "fancontrol_types.h"
+#include "controller.h"
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * "fanctl" service exposed by the sysmodule. Clients (the overlay) read the
+ * loop state and change the curve or mode through it instead of touching
+ * the sensors or restarting the sysmodule.
+ *
+ * Every command carries its arguments as plain data: the request payload
+ * is the command's input struct (or nothing) and the reply payload is its
+ * output struct (or nothing). FanIpcDispatch decodes and validates that
+ * payload; the transport (HIPC on the console, a Unix socket on the host)
+ * only moves bytes. Over HIPC, inputs too large for the inline data words
+ * (SetTable) travel in a single map-alias In buffer instead.
+ */
+
+#define FAN_IPC_SERVICE_NAME    "fanctl"
+#define FAN_IPC_MAX_SESSIONS    4
+
+typedef enum
+{
+    FanIpcCmd_GetState      = 0,    /* -> FanIpcState                      */
+    FanIpcCmd_SetTable      = 1,    /* FanIpcTable (count points) ->       */
+    FanIpcCmd_SetMode       = 2,    /* u32 FanControlMode ->               */
+    FanIpcCmd_Pause         = 3,    /* stop writing the fan level          */
+    FanIpcCmd_Resume        = 4,
+    FanIpcCmd_GetTelemetry  = 5,    /* -> FanIpcTelemetryInfo + handle     */
+} FanIpcCmd;
+
+/* Results returned to the client, same layout as MAKERESULT. */
+#define FAN_IPC_MODULE          428
+#define FAN_IPC_RESULT(desc)    ((FAN_IPC_MODULE & 0x1FF) | ((desc) << 9))
+
+typedef enum
+{
+    FanIpcError_UnknownCommand  = 1,
+    FanIpcError_BadSize         = 2,
+    FanIpcError_BadTable        = 3,
+    FanIpcError_BadMode         = 4,
+    FanIpcError_Busy            = 5,
+    FanIpcError_Unavailable     = 6,
+} FanIpcError;
+
+typedef struct
+{
+    float   socC;
+    float   pcbC;
+    float   targetLevel;        /* level the controller asked for       */
+    float   appliedLevel;       /* last level written, < 0 if none yet  */
+    u32     mode;               /* FanControlMode                       */
+    u32     paused;
+    u64     writesIssued;
+    u64     writesSuppressed;
+    u64     readFailures;
+    u64     lastIntervalNs;
+    u32     wakeupsPerMinute;
+    u32     profile;            /* index of the active profile          */
+    float   battC;              /* NAN unless the fusion reads it       */
+    float   controlC;           /* fused temperature the curve saw      */
+    u32     supervisorState;    /* FanSupervisorState                   */
+    u32     handbacks;          /* times the fan went back to firmware  */
+    u64     writeFaults;        /* failed fan writes and reopens        */
+    u64     recoveries;
+    u64     lastRecoveryNs;     /* first failure to first good write    */
+    u64     maxRecoveryNs;
+    float   pwmLevel;           /* last PWM duty readback, < 0 if none  */
+    u32     reserved;
+    u64     dutyMismatches;     /* readbacks that found the level overwritten */
+    u64     reasserts;
+} FanIpcState;
+
+/* Replaces the curve of one profile. Only the first count points are sent,
+ * see FAN_IPC_TABLE_SIZE. */
+typedef struct
+{
+    u32                 count;
+    u32                 profile;
+    TemperaturePoint    points[FAN_CURVE_MAX_POINTS];
+} FanIpcTable;
+
+#define FAN_IPC_TABLE_SIZE(count) \
+    (offsetof(FanIpcTable, points) + (count) * sizeof(TemperaturePoint))
+
+/* The telemetry ring is shared memory; the reply carries its handle (a
+ * file descriptor on the host) and this struct. */
+typedef struct
+{
+    u64     size;
+} FanIpcTelemetryInfo;
+
+/* What the server side plugs in behind the commands. */
+typedef struct
+{
+    void   *ctx;
+    void   (*getState)(void *ctx, FanIpcState *out);
+    Result (*setTable)(void *ctx, u32 profile, const TemperaturePoint *tbl, size_t count);
+    Result (*setMode)(void *ctx, u32 mode);
+    void   (*setPaused)(void *ctx, bool paused);
+    Result (*getTelemetry)(void *ctx, FanIpcTelemetryInfo *out, Handle *handle);
+} FanIpcHandlers;
+
+/* Runs one request. The reply payload goes to out (up to outCap bytes) and
+ * its size to outSize, a handle to copy to the client (or INVALID_HANDLE)
+ * to outHandle; the return value is the result for the client. */
+Result FanIpcDispatch(const FanIpcHandlers *h, u32 cmd,
+                      const void *in, size_t inSize,
+                      void *out, size_t outCap, size_t *outSize,
+                      Handle *outHandle);
+
+#ifndef FANCONTROL_HOST
+
+/* ── Server (sysmodule) ───────────────────────────────────────────── */
+
+typedef struct
+{
+    Handle  handles[1 + FAN_IPC_MAX_SESSIONS];  /* port, then sessions */
+    s32     count;
+    SmServiceName name;
+} FanIpcServer;
+
+Result FanIpcServerOpen(FanIpcServer *server);
+void   FanIpcServerClose(FanIpcServer *server);
+
+#define FAN_IPC_MAX_EXTRA_HANDLES   4
+
+/* Waits up to timeoutNs for a client message, or for one of the extraCount
+ * handles in extra to be signalled, and handles whatever arrived. Returns
+ * KERNELRESULT(TimedOut) on timeout and 0 otherwise, with *extraIndex set
+ * to the extra handle that fired or -1. */
+Result FanIpcServerProcess(FanIpcServer *server, const FanIpcHandlers *h,
+                           const Handle *extra, s32 extraCount, u64 timeoutNs,
+                           s32 *extraIndex);
+
+/* ── Client (overlay) ─────────────────────────────────────────────── */
+
+Result FanIpcClientOpen(void);
+void   FanIpcClientClose(void);
+bool   FanIpcClientIsOpen(void);
+
+Result FanIpcGetState(FanIpcState *out);
+Result FanIpcSetTable(u32 profile, const TemperaturePoint *tbl, size_t count);
+Result FanIpcSetMode(u32 mode);
+Result FanIpcPause(void);
+Result FanIpcResume(void);
+
+/* Maps the telemetry ring read-only on first use; stays mapped until
+ * FanIpcClientClose. */
+Result FanIpcGetTelemetry(const FanTelemetryRing **ring_out);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,28 +14,85 @@ extern "C" {
 
 #include <switch.h>
 
-#define LOG_DIR "./config/NX-FanControl/"
-#define LOG_FILE "./config/NX-FanControl/log.txt"
-#define CONFIG_DIR "./config/NX-FanControl/"
-#define CONFIG_FILE "./config/NX-FanControl/config.dat"
-#define TABLE_SIZE sizeof(TemperaturePoint) * 10
+#include "controller.h"
+#include "control_loop.h"
+#include "fan_config.h"
+#include "fan_ipc.h"
+#include "log_ring.h"
+#include "supervisor.h"
 
+#define LOG_DIR "/config/NX-FanControl"
+#define LOG_FILE "/config/NX-FanControl/log.txt"
+#define LOG_FILE_PREVIOUS "/config/NX-FanControl/log.1.txt"
+#define CONFIG_DIR "/config/NX-FanControl"
+#define CONFIG_FILE "/config/NX-FanControl/config.dat"
+#define SETTINGS_FILE "/config/NX-FanControl/settings.dat"
+#define TRACE_FILE "/config/NX-FanControl/trace.bin"
+#define TRACE_FILE_ROTATED "/config/NX-FanControl/trace.%d.bin"
+
+/* Static control thread stack. stack_report.py puts the deepest path at
+ * about 3.4 KB; libnx keeps the thread's TLS and reent block at the top. */
+#define FAN_CONTROLLER_STACK_SIZE 0x2000
 
 typedef struct
 {
-    int     temperature_c;
-    float   fanLevel_f;
-} TemperaturePoint;
+    float   tempC;              /* last SoC reading                     */
+    float   pcbC;
+    float   battC;              /* NAN unless the fusion reads it       */
+    float   controlC;           /* fused, filtered temperature          */
+    float   curveC;             /* what the curve saw: controlC, or the
+                                 * thermal model's prediction           */
+    float   modelTauS;          /* identified time constant, 0 if none  */
+    float   modelGainC;
+    float   targetLevel;        /* last interpolated target             */
+    float   appliedLevel;       /* last level written, < 0 if none yet  */
+    u64     writesIssued;
+    u64     writesSuppressed;
+    u64     lastIntervalNs;     /* sleep chosen by the scheduler        */
+    u32     wakeupsPerMinute;   /* loop iterations over the last minute */
+    u64     readFailures;
+    u32     supervisorState;    /* FanSupervisorState                   */
+    u32     handbacks;
+    u64     writeFaults;
+    u64     recoveries;
+    u64     lastRecoveryNs;
+    u64     maxRecoveryNs;
+    float   pwmLevel;           /* last PWM duty readback, < 0 if none  */
+    u64     dutyMismatches;
+    u64     reasserts;
+    u32     stackPeak;          /* control thread stack high-water mark */
+    u32     stackSize;
+    u64     firstWriteUs;       /* launch to first fan write, 0 if none */
+} FanControllerStats;
+
+void WriteConfigFile(const FanConfig *config);
+void ReadConfigFile(FanConfig *config_out);
+void WriteSettingsFile(const FanControllerSettings *settings);
+void ReadSettingsFile(FanControllerSettings *settings_out);
 
-void WriteConfigFile(const TemperaturePoint *table);
-void ReadConfigFile(TemperaturePoint **table_out);
+void SetFanControllerSettings(const FanControllerSettings *settings);
 
-void InitFanController(TemperaturePoint *table);
+/* Startup runs in two stages so the fan is under control before the SD
+ * card is touched: InitFanController and StartFanControllerThread on the
+ * built-in curve, then LoadFanControllerConfig once fs and pm are up.
+ * MarkFanControllerLaunch, first thing in __appInit, starts the clock for
+ * firstWriteUs. */
+void MarkFanControllerLaunch(void);
+void InitFanController(void);
+void LoadFanControllerConfig(void);
 void FanControllerThreadFunction(void*);
 void StartFanControllerThread();
 void CloseFanControllerThread();
 void WaitFanController();
-void WriteLog(const char *buffer);
+void GetFanControllerStats(FanControllerStats *out);
+
+/* Queues a line for log.txt without blocking; safe on any thread. Lines
+ * below the logLevel in settings.dat (default Info) are discarded. */
+void WriteLog(FanLogLevel level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/* Writes queued lines out in one batch. Called on the housekeeping tick,
+ * at shutdown and before aborting. */
+void FlushLog(void);
 
 #ifdef __cplusplus
 }
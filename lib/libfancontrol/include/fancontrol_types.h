@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * Basic libnx types for the platform-independent parts of libfancontrol.
+ * On the console these come straight from <switch.h>; host builds
+ * (-DFANCONTROL_HOST) get minimal equivalents so the control logic can be
+ * compiled and exercised off-device.
+ */
+
+#ifdef FANCONTROL_HOST
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef u32 Result;
+
+/* Kernel handles become file descriptors on the host. */
+typedef int Handle;
+#define INVALID_HANDLE    (-1)
+
+#define R_SUCCEEDED(res)  ((res) == 0)
+#define R_FAILED(res)     ((res) != 0)
+
+#else
+
+#include <switch.h>
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "fancontrol_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sensor / actuator / clock interface used by the control loop. The console
+ * backend (hal_switch.c) wraps TMP451 and the fan service; host builds use
+ * the simulated thermal plant in host/hal_sim.c.
+ */
+
+/* Readings that weren't asked for or didn't answer are NAN; socC is
+ * always read. */
+typedef struct
+{
+    float   socC;
+    float   pcbC;
+    float   battC;
+} FanSensorSample;
+
+typedef struct
+{
+    void   *ctx;
+    /* sensors is a FanFusionSensors mask. Everything is read in one call
+     * so extra sensors share the loop's wake-up instead of adding their
+     * own. */
+    Result (*readSensors)(void *ctx, u32 sensors, FanSensorSample *out);
+    Result (*setFanLevel)(void *ctx, float level);
+    /* Level the fan is actually driven at, from the PWM duty readback.
+     * NULL if the backend can't read it. */
+    Result (*readFanLevel)(void *ctx, float *level_out);
+    /* Recovery hooks for the supervisor: reopenFan drops the fan session
+     * and opens a new one, releaseFan closes it so the firmware's own
+     * policy drives the fan again. */
+    Result (*reopenFan)(void *ctx);
+    void   (*releaseFan)(void *ctx);
+    u64    (*nowNs)(void *ctx);
+    void   (*sleepNs)(void *ctx, u64 ns);
+} FanHal;
+
+#ifndef FANCONTROL_HOST
+Result FanHalSwitchOpen(FanHal *hal);
+void   FanHalSwitchClose(FanHal *hal);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
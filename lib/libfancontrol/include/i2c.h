@@ -3,80 +3,38 @@
 
 #include <switch.h>
 
-Result I2cReadRegHandler16(u8 reg, I2cDevice dev, u16 *out)
-{
-	struct readReg {
-        u8 send;
-        u8 sendLength;
-        u8 sendData;
-        u8 receive;
-        u8 receiveLength;
-    };
-
-	I2cSession _session;
-
-	Result res = i2cOpenSession(&_session, dev);
-	if (res)
-		return res;
-
-	u16 val;
-
-    struct readReg readRegister = {
-        .send = 0 | (I2cTransactionOption_Start << 6),
-        .sendLength = sizeof(reg),
-        .sendData = reg,
-        .receive = 1 | (I2cTransactionOption_All << 6),
-        .receiveLength = sizeof(val),
-    };
+#ifdef __cplusplus
+extern "C" {
+#endif
 
-	res = i2csessionExecuteCommandList(&_session, &val, sizeof(val), &readRegister, sizeof(readRegister));
-	if (res)
-	{
-		i2csessionClose(&_session);
-		return res;
-	}
+/*
+ * Register reads go through a small pool of I2C sessions keyed by
+ * I2cDevice. A session is opened on first use (or by I2cSessionPoolOpen),
+ * kept open across reads and reopened once if a command list fails.
+ */
 
-	*out = val;
-	i2csessionClose(&_session);
-	return 0;
-}
-
-Result I2cReadRegHandler8(u8 reg, I2cDevice dev, u8 *out)
+typedef struct
 {
-	struct readReg {
-        u8 send;
-        u8 sendLength;
-        u8 sendData;
-        u8 receive;
-        u8 receiveLength;
-    };
-
-	I2cSession _session;
-
-	Result res = i2cOpenSession(&_session, dev);
-	if (res)
-		return res;
+    u64 reads;          /* command lists executed                      */
+    u64 failures;       /* reads that still failed after a reopen      */
+    u64 sessionOpens;   /* i2cOpenSession calls, including reopens     */
+    u64 totalTicks;     /* summed i2csessionExecuteCommandList latency */
+    u64 maxTicks;       /* worst single command list latency           */
+} I2cReadStats;
 
-	u8 val;
+Result I2cSessionPoolOpen(I2cDevice dev);
+void   I2cSessionPoolClose(void);
+void   I2cGetReadStats(I2cReadStats *out);
 
-    struct readReg readRegister = {
-        .send = 0 | (I2cTransactionOption_Start << 6),
-        .sendLength = sizeof(reg),
-        .sendData = reg,
-        .receive = 1 | (I2cTransactionOption_All << 6),
-        .receiveLength = sizeof(val),
-    };
+Result I2cReadRegHandler16(u8 reg, I2cDevice dev, u16 *out);
+Result I2cReadRegHandler8(u8 reg, I2cDevice dev, u8 *out);
 
-	res = i2csessionExecuteCommandList(&_session, &val, sizeof(val), &readRegister, sizeof(readRegister));
-	if (res)
-	{
-		i2csessionClose(&_session);
-		return res;
-	}
+/* Reads up to I2C_MAX_BATCH_REGS 8-bit registers in one command list. */
+#define I2C_MAX_BATCH_REGS 8
+Result I2cReadRegsHandler8(const u8 *regs, size_t count, I2cDevice dev, u8 *out);
 
-	*out = val;
-	i2csessionClose(&_session);
-	return 0;
+#ifdef __cplusplus
 }
+#endif
 
-#endif
\ No newline at end of file
+#endif
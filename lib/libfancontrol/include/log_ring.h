@@ -0,0 +1,75 @@
+#pragma once
+
+#include "fancontrol_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#define FAN_LOG_ATOMIC(T) T
+#else
+#include <stdatomic.h>
+#define FAN_LOG_ATOMIC(T) _Atomic(T)
+#endif
+
+/*
+ * Bounded log queue between the threads that log and the one that writes
+ * log.txt. Pushing never blocks and never touches the SD card: any thread,
+ * including the control thread, claims a slot with one compare-and-swap
+ * and copies its line in. When the ring is full the line is dropped and
+ * counted instead. A single consumer pops lines oldest first and writes
+ * them out in batches.
+ *
+ * Each slot's sequence number says whose turn it is, as in D. Vyukov's
+ * bounded MPMC queue. For line i, with base = i rounded down to a multiple
+ * of FAN_LOG_RING_SLOTS: base while the slot is free for it, base+1 once
+ * the line is complete, base+FAN_LOG_RING_SLOTS after it has been popped.
+ * An all-zero ring is therefore empty and ready, so lines can be pushed
+ * before anything has been initialised.
+ */
+
+#define FAN_LOG_RING_SLOTS  64          /* power of two */
+#define FAN_LOG_LINE_MAX    112         /* including the terminating NUL */
+
+typedef enum
+{
+    FanLogLevel_Debug   = 0,
+    FanLogLevel_Info    = 1,
+    FanLogLevel_Warn    = 2,
+    FanLogLevel_Error   = 3,
+} FanLogLevel;
+
+typedef struct
+{
+    u64     timestampNs;
+    u32     level;              /* FanLogLevel */
+    char    text[FAN_LOG_LINE_MAX];
+} FanLogLine;
+
+typedef struct
+{
+    FAN_LOG_ATOMIC(u32) seq;
+    FanLogLine          line;
+} FanLogSlot;
+
+typedef struct
+{
+    FanLogSlot          slots[FAN_LOG_RING_SLOTS];
+    FAN_LOG_ATOMIC(u32) head;       /* next line to push */
+    u32                 tail;       /* next line to pop, consumer only */
+    FAN_LOG_ATOMIC(u64) dropped;    /* lines lost to a full ring */
+} FanLogRing;
+
+void FanLogRingInit(FanLogRing *ring);
+
+/* Copies text (truncated to FAN_LOG_LINE_MAX - 1 bytes) into the ring.
+ * Returns false and counts a drop if the ring is full. */
+bool FanLogPush(FanLogRing *ring, FanLogLevel level, u64 timestampNs, const char *text);
+
+/* Consumer side: the oldest complete line, or false if there is none. */
+bool FanLogPop(FanLogRing *ring, FanLogLine *out);
+
+/* Single-letter tag for a level: D, I, W or E. */
+char FanLogLevelChar(FanLogLevel level);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <switch.h>
+#include "fan_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Dock and power state used to pick the fan profile. Changes arrive as
+ * events: omm signals dock/undock, psm signals charger and battery state
+ * changes. The caller waits on the handles from FanPowerStateHandles and
+ * calls FanPowerStateRead after one of them fired.
+ */
+
+#define FAN_POWER_MAX_HANDLES   2
+
+/* Whatever can't be opened is left out; Read then reports it as
+ * undocked / not charging / full. */
+Result FanPowerStateOpen(void);
+void   FanPowerStateClose(void);
+
+/* Returns the number of handles written to out. */
+s32    FanPowerStateHandles(Handle *out, s32 max);
+
+/* Clears every event and reads the current state. */
+void   FanPowerStateRead(FanPowerState *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,22 +1,28 @@
-// pwm.h
-#pragma once
-#include <switch.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-typedef struct {
-    Service s;
-} PwmChannelSession;
-
-Result pwmInitialize(void);
-void pwmExit(void);
-Service* pwmGetServiceSession(void);
-Result pwmOpenSession2(PwmChannelSession *out, u32 device_code);
-Result pwmChannelSessionGetDutyCycle(PwmChannelSession *c, double* out);
-void pwmChannelSessionClose(PwmChannelSession *c);
-
-#ifdef __cplusplus
-} // extern "C"
-#endif
\ No newline at end of file
+#pragma once
+
+#include <switch.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Minimal client for the "pwm" service (6.0.0+), used to read back the fan
+ * PWM duty cycle. The fan line is active-low: the duty cycle, in percent,
+ * is the time the fan is off, so the fan level is (100 - duty) / 100.
+ */
+
+typedef struct {
+    Service s;
+} PwmChannelSession;
+
+Result pwmInitialize(void);
+void pwmExit(void);
+Service* pwmGetServiceSession(void);
+Result pwmOpenSession2(PwmChannelSession *out, u32 device_code);
+Result pwmChannelSessionGetDutyCycle(PwmChannelSession *c, double* out);
+void pwmChannelSessionClose(PwmChannelSession *c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "control_loop.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Recovery from fan write faults. The supervisor runs the control loop and
+ * escalates on failed writes instead of giving up on the first one:
+ *
+ *   Normal     the loop follows the curve
+ *   Retry      the failed write is repeated with exponential backoff
+ *   Reopen     the fan session is dropped and reopened before each retry
+ *   SafeLevel  a fixed level is written instead of the curve, held for
+ *              safeHoldNs once it sticks, then the curve gets another go
+ *   Handback   the session is closed so the firmware's own policy drives
+ *              the fan; every probeNs a reopen tries to take it back
+ *
+ * A successful write from Retry, Reopen or a Handback probe returns to
+ * Normal. Sensors are read and the target computed in every state, so
+ * telemetry keeps flowing throughout.
+ */
+
+typedef enum
+{
+    FanSupervisorState_Normal       = 0,
+    FanSupervisorState_Retry        = 1,
+    FanSupervisorState_Reopen       = 2,
+    FanSupervisorState_SafeLevel    = 3,
+    FanSupervisorState_Handback     = 4,
+} FanSupervisorState;
+
+typedef struct
+{
+    u32     retries;        /* failed retries before reopening             */
+    u64     backoffNs;      /* first retry delay, doubled per attempt      */
+    u64     backoffMaxNs;
+    u32     reopens;        /* failed reopens before the safe level        */
+    float   safeLevel;
+    u32     safeRetries;    /* failed safe-level writes before handing back */
+    u64     safeHoldNs;     /* time at the safe level before the curve     */
+    u64     probeNs;        /* interval of takeover attempts after handback */
+} FanSupervisorConfig;
+
+#define FAN_SUPERVISOR_DEFAULTS                 \
+    {                                           \
+        .retries        = 3,                    \
+        .backoffNs      = 100000000ULL,         \
+        .backoffMaxNs   = 2000000000ULL,        \
+        .reopens        = 2,                    \
+        .safeLevel      = 1.0f,                 \
+        .safeRetries    = 3,                    \
+        .safeHoldNs     = 30000000000ULL,       \
+        .probeNs        = 60000000000ULL,       \
+    }
+
+typedef struct
+{
+    FanSupervisorState state;
+    u32     attempts;       /* failed attempts in this state               */
+    u64     enteredNs;
+    bool    recovering;     /* no good write since faultNs                 */
+    u64     faultNs;        /* first failure of the current episode        */
+    Result  lastError;
+
+    u64     faults;         /* failed writes and reopens                   */
+    u64     recoveries;     /* episodes ended by a good write              */
+    u64     reopens;
+    u64     handbacks;
+    u64     lastRecoveryNs; /* first failure to first good write           */
+    u64     maxRecoveryNs;
+} FanSupervisor;
+
+void FanSupervisorInit(FanSupervisor *sup);
+
+/* Runs one loop iteration under supervision and stores the time to sleep
+ * in interval_out, the backoff delay while recovering. Returns the result
+ * of the fan write or reopen, 0 if neither was needed. */
+Result FanSupervisorStep(FanSupervisor *sup, const FanSupervisorConfig *cfg,
+                         FanLoop *loop, const FanHal *hal, u64 *interval_out);
+
+const char *FanSupervisorStateName(FanSupervisorState state);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "fancontrol_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+/* C++ clients only hand the ring to the functions below, which do the
+ * atomic accesses; the plain types have the same layout. */
+#define FAN_TELEMETRY_ATOMIC(T) T
+#else
+#include <stdatomic.h>
+#define FAN_TELEMETRY_ATOMIC(T) _Atomic(T)
+#endif
+
+/*
+ * Telemetry ring shared read-only with clients. The control thread is the
+ * only writer; any number of readers in other processes poll it without
+ * syscalls or locks.
+ *
+ * Every slot is a seqlock whose sequence number also names the sample it
+ * holds: 2*i+1 while sample i is being written, 2*i+2 once it is complete.
+ * A reader copies the slot between two loads of the sequence and keeps the
+ * copy only if both match the sample it wanted, so torn or overwritten
+ * slots are detected rather than returned. Sample words are copied with
+ * relaxed atomics so the protocol is race-free under the C11 model.
+ */
+
+#define FAN_TELEMETRY_MAGIC         0x4C455446  /* "FTEL" */
+#define FAN_TELEMETRY_VERSION       6
+
+/* The sysmodule copies the ring into trace.bin once a second. 256 slots
+ * hold 2.5 s of samples at FAN_SCHEDULER_MIN_INTERVAL_NS, the shortest
+ * interval settings.dat allows, so a late housekeeping tick during a
+ * steep ramp still loses nothing. */
+#define FAN_TELEMETRY_SLOTS         256         /* power of two */
+#define FAN_TELEMETRY_READ_RETRIES  4
+
+/* FanTelemetrySample.flags */
+#define FAN_TELEMETRY_READ_FAILED   (1u << 0)   /* sensors failed, held or failsafe temperature */
+#define FAN_TELEMETRY_STATE_SHIFT   1           /* bits 1-3: FanSupervisorState */
+#define FAN_TELEMETRY_STATE_MASK    (7u << FAN_TELEMETRY_STATE_SHIFT)
+#define FAN_TELEMETRY_DUTY_MISMATCH (1u << 4)   /* PWM readback found the level overwritten */
+
+typedef struct
+{
+    u64     timestampNs;
+    float   socC;
+    float   pcbC;
+    float   targetLevel;
+    float   dutyLevel;          /* level last written to the fan        */
+    u32     loopLatencyNs;      /* time spent in the loop iteration     */
+    u32     result;             /* result of the fan write, 0 if none   */
+    float   battC;              /* NAN unless the fusion reads it       */
+    float   controlC;           /* fused, filtered temperature          */
+    u32     flags;
+    u32     faults;             /* failed fan writes and reopens so far */
+    u32     recoveryUs;         /* first failure to first good write in
+                                 * the last fault episode               */
+    float   pwmLevel;           /* last PWM duty readback, < 0 if none  */
+} FanTelemetrySample;
+
+#define FAN_TELEMETRY_SAMPLE_WORDS  (sizeof(FanTelemetrySample) / sizeof(u32))
+
+typedef struct
+{
+    FAN_TELEMETRY_ATOMIC(u32) seq;
+    FAN_TELEMETRY_ATOMIC(u32) words[FAN_TELEMETRY_SAMPLE_WORDS];
+} FanTelemetrySlot;
+
+typedef struct
+{
+    u32                 magic;
+    u32                 version;
+    u32                 slotCount;
+    FAN_TELEMETRY_ATOMIC(u32) firstWriteUs; /* launch to first fan write */
+    FAN_TELEMETRY_ATOMIC(u64) head;     /* samples published so far */
+    FanTelemetrySlot    slots[FAN_TELEMETRY_SLOTS];
+} FanTelemetryRing;
+
+/* Writer side. */
+void FanTelemetryRingInit(FanTelemetryRing *ring);
+void FanTelemetryPublish(FanTelemetryRing *ring, const FanTelemetrySample *sample);
+
+/* Records the time from launch to the first fan write; only the first
+ * call counts. */
+void FanTelemetrySetFirstWrite(FanTelemetryRing *ring, u64 us);
+
+/* Reader side. True if the ring header matches this build. */
+bool FanTelemetryRingValid(const FanTelemetryRing *ring);
+
+/* Microseconds from launch to the first fan write, 0 until it happened. */
+u32 FanTelemetryFirstWriteUs(const FanTelemetryRing *ring);
+
+/* Newest sample; false if nothing was published yet or the writer kept
+ * lapping the reader for FAN_TELEMETRY_READ_RETRIES attempts. */
+bool FanTelemetryReadLatest(const FanTelemetryRing *ring, FanTelemetrySample *out);
+
+/* Samples published since *cursor, oldest first, up to max. Advances the
+ * cursor past what was returned and adds samples the writer overwrote
+ * before they could be read to *dropped (may be NULL). */
+size_t FanTelemetryReadSince(const FanTelemetryRing *ring, u64 *cursor,
+                             FanTelemetrySample *out, size_t max, u64 *dropped);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact binary trace of control loop iterations, kept on the SD card
+ * for post-mortem analysis. A trace file is a header followed by records:
+ *
+ *   header:  u32 magic, u16 version, u16 headerSize, u64 startNs
+ *   record:  varint  dtUs       time since the previous record (startNs
+ *                               for the first)
+ *            u8      flags      FAN_TELEMETRY_* flags
+ *            varint  result     fan write result
+ *            varint  latencyUs  time spent in the iteration
+ *            s16 x4  socC, pcbC, battC, controlC in 1/100 C,
+ *                    FAN_TRACE_NO_TEMP if not read
+ *            u16 x2  target and duty level in 1/10000,
+ *                    FAN_TRACE_NO_LEVEL before the first write
+ *
+ * Varints are LEB128; everything else little-endian. A typical record is
+ * 17 or 18 bytes. Timestamps keep microsecond resolution. A file cut short by
+ * a crash ends in a partial record, which the decoder stops at.
+ */
+
+#define FAN_TRACE_MAGIC         0x43525446  /* "FTRC" */
+#define FAN_TRACE_VERSION       1
+#define FAN_TRACE_HEADER_SIZE   16
+#define FAN_TRACE_RECORD_MAX    40          /* worst-case encoded record */
+
+#define FAN_TRACE_NO_TEMP       INT16_MIN
+#define FAN_TRACE_NO_LEVEL      0xFFFF
+
+typedef struct
+{
+    u64     lastUs;
+} FanTraceCursor;
+
+/* Writes a file header into out (FAN_TRACE_HEADER_SIZE bytes) and starts
+ * the delta chain at startNs. */
+size_t FanTraceBegin(FanTraceCursor *cursor, u64 startNs, u8 *out);
+
+/* Appends one record to out (at least FAN_TRACE_RECORD_MAX bytes) and
+ * returns its size. Samples must come in timestamp order. */
+size_t FanTraceEncode(FanTraceCursor *cursor, const FanTelemetrySample *sample, u8 *out);
+
+/* Decoder side. FanTraceOpen checks the header and leaves *pos after it;
+ * FanTraceDecode returns false at the end of the data or at a partial or
+ * malformed record. Samples come back with loopLatencyNs rounded to
+ * microseconds, the fault counters, which the trace leaves to the result
+ * and flags, zero and pwmLevel -1. */
+bool FanTraceOpen(FanTraceCursor *cursor, const u8 *data, size_t size, size_t *pos);
+bool FanTraceDecode(FanTraceCursor *cursor, const u8 *data, size_t size, size_t *pos,
+                    FanTelemetrySample *out);
+
+#ifdef __cplusplus
+}
+#endif
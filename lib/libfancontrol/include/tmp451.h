@@ -68,35 +68,44 @@ Result Tmp451ReadReg(u8 reg, u8 *out)
 	return res;
 }
 
-Result Tmp451GetSocTemp(float* temperature) {
-    u8 integer = 0;
-    u8 decimals = 0;
+static inline float Tmp451DecodeTemp(u8 integer, u8 decimals)
+{
+    decimals = ((u16)(decimals >> 4) * 625) / 100;
+    return (float)(integer) + ((float)(decimals) / 100);
+}
 
-    Result rc = Tmp451ReadReg(TMP451_SOC_TEMP_REG, &integer);
-    if (R_FAILED(rc))
-        return rc;
-    rc = Tmp451ReadReg(TMP451_SOC_TEMP_DEC_REG, &decimals);
+// Reads the integer and fraction registers of both channels in a single
+// command list, so each pair comes from the same conversion. pcb may be NULL.
+Result Tmp451GetTemps(float* soc, float* pcb) {
+    const u8 regs[] = {
+        TMP451_SOC_TEMP_REG, TMP451_SOC_TEMP_DEC_REG,
+        TMP451_PCB_TEMP_REG, TMP451_PCB_TEMP_DEC_REG,
+    };
+    u8 data[sizeof(regs)] = {0};
+
+    Result rc = I2cReadRegsHandler8(regs, pcb ? 4 : 2, I2cDevice_Tmp451, data);
     if (R_FAILED(rc))
         return rc;
-    
-    decimals = ((u16)(decimals >> 4) * 625) / 100;
-    *temperature = (float)(integer) + ((float)(decimals) / 100);
+
+    *soc = Tmp451DecodeTemp(data[0], data[1]);
+    if (pcb)
+        *pcb = Tmp451DecodeTemp(data[2], data[3]);
     return rc;
 }
 
+Result Tmp451GetSocTemp(float* temperature) {
+    return Tmp451GetTemps(temperature, NULL);
+}
+
 Result Tmp451GetPcbTemp(float* temperature) {
-    u8 integer = 0;
-    u8 decimals = 0;
+    const u8 regs[] = { TMP451_PCB_TEMP_REG, TMP451_PCB_TEMP_DEC_REG };
+    u8 data[sizeof(regs)] = {0};
 
-    Result rc = Tmp451ReadReg(TMP451_PCB_TEMP_REG, &integer);
+    Result rc = I2cReadRegsHandler8(regs, 2, I2cDevice_Tmp451, data);
     if (R_FAILED(rc))
         return rc;
-    rc = Tmp451ReadReg(TMP451_PCB_TEMP_DEC_REG, &decimals);
-    if (R_FAILED(rc))
-        return rc;
-    
-    decimals = ((u16)(decimals >> 4) * 625) / 100;
-    *temperature = (float)(integer) + ((float)(decimals) / 100);
+
+    *temperature = Tmp451DecodeTemp(data[0], data[1]);
     return rc;
 }
 
@@ -0,0 +1,168 @@
+#include <math.h>
+#include "control_loop.h"
+
+void FanLoopInit(FanLoop *loop)
+{
+    FanWriteGateInit(&loop->gate);
+    FanSchedulerInit(&loop->sched);
+    FanPidInit(&loop->pid);
+    FanFilterInit(&loop->filter);
+    FanPredictorInit(&loop->predictor);
+
+    loop->released      = false;
+    loop->fixedLevel    = -1.0f;
+
+    loop->sample.socC   = 0.0f;
+    loop->sample.pcbC   = 0.0f;
+    loop->sample.battC  = NAN;
+    loop->controlC      = 0.0f;
+    loop->curveC        = 0.0f;
+    loop->target        = 0.0f;
+    loop->lastNs        = 0;
+    loop->lastReadNs    = 0;
+    loop->readFailed    = false;
+    loop->readFailures  = 0;
+    loop->pwmLevel      = -1.0f;
+    loop->verifyNs      = 0;
+    loop->reassertNs    = 0;
+    loop->dutyMismatch  = false;
+    loop->dutyMismatches = 0;
+    loop->reasserts     = 0;
+}
+
+Result FanLoopStep(FanLoop *loop, const FanHal *hal, u64 *interval_out)
+{
+    Result rs = 0;
+
+    const FanCurve *curve = loop->curve;
+    const FanFusionConfig *fusion = &loop->settings->fusion;
+
+    /* ── Read temperatures with retry ───────────────────────────── */
+    u32 sensors = FanFusionSensors(fusion);
+    loop->readFailed = true;
+    for (int retry = 0; retry < FAN_LOOP_READ_RETRIES; retry++)
+    {
+        if (R_SUCCEEDED(hal->readSensors(hal->ctx, sensors, &loop->sample)))
+        {
+            loop->readFailed = false;
+            break;
+        }
+    }
+
+    u64 now = hal->nowNs(hal->ctx);
+    float tempC;
+    bool  failsafe = false;
+    if (loop->readFailed)
+    {
+        /* Hold the last good value for a while. Once that runs out the
+         * filter's history is stale, so it restarts from the next real
+         * reading instead of averaging against it. */
+        loop->readFailures++;
+        if (loop->filter.primed && now - loop->lastReadNs < FAN_LOOP_FAILSAFE_HOLD_NS)
+        {
+            tempC = loop->controlC;
+        }
+        else
+        {
+            FanFilterInit(&loop->filter);
+            loop->sample.socC = FAN_LOOP_FAILSAFE_C;
+            tempC = FAN_LOOP_FAILSAFE_C;
+            failsafe = true;
+        }
+    }
+    else
+    {
+        const float temps[FanSensor_Count] =
+            { loop->sample.socC, loop->sample.pcbC, loop->sample.battC };
+        tempC = FanFusionTemp(fusion, &curve->lut, temps);
+        tempC = FanFilterUpdate(&loop->filter, &loop->settings->filter, tempC, now);
+        loop->lastReadNs = now;
+    }
+    loop->controlC = tempC;
+
+    /* ── Compute target fan level ───────────────────────────────── */
+    float curveC = tempC;
+    const FanPredictConfig *predict = &loop->settings->predict;
+    if (predict->enabled && !loop->readFailed)
+        curveC = FanPredictorUpdate(&loop->predictor, predict, tempC, loop->gate.applied, now);
+    loop->curveC = curveC;
+
+    float target = FanCurveLutLookup(&curve->lut, curveC);
+
+    if (loop->settings->mode == FanControlMode_Pid)
+    {
+        float dtS = loop->lastNs ? (float)(now - loop->lastNs) / 1e9f : 0.0f;
+        target = FanPidUpdate(&loop->pid, &loop->settings->pid, tempC, target, dtS,
+                              loop->gate.ramping);
+    }
+    loop->lastNs = now;
+    loop->target = target;
+
+    /* ── Slew-limit, then only write past the deadband ──────────── */
+    float level;
+    if (loop->fixedLevel >= 0.0f || failsafe || target >= 1.0f)
+    {
+        /* Fallback level, failsafe temperature or full speed: go straight
+         * there, and ramp from it once the curve takes over again. */
+        level = loop->fixedLevel >= 0.0f ? loop->fixedLevel : target;
+        loop->gate.slewLevel = level;
+        loop->gate.slewNs    = now;
+        loop->gate.ramping   = false;
+    }
+    else
+    {
+        level = FanWriteGateSlew(&loop->gate, loop->gateCfg, target, now);
+    }
+
+    if (!loop->released && FanWriteGateShouldWrite(&loop->gate, loop->gateCfg, level, now))
+    {
+        rs = hal->setFanLevel(hal->ctx, level);
+        if (R_SUCCEEDED(rs))
+            FanWriteGateCommit(&loop->gate, level, now);
+        else
+            FanWriteGateFail(&loop->gate);
+    }
+
+    /* ── Check the level stuck, at a low rate ───────────────────── */
+    loop->dutyMismatch = false;
+    const FanWriteGateConfig *gateCfg = loop->gateCfg;
+    if (hal->readFanLevel != NULL && gateCfg->verifyNs != 0 &&
+        now - loop->verifyNs >= gateCfg->verifyNs)
+    {
+        float pwmLevel;
+        loop->verifyNs = now;
+        if (R_SUCCEEDED(hal->readFanLevel(hal->ctx, &pwmLevel)))
+        {
+            /* Also read while released, to show what the firmware does. */
+            loop->pwmLevel = pwmLevel;
+            float applied = loop->gate.applied;
+            if (!loop->released && R_SUCCEEDED(rs) && applied >= 0.0f &&
+                fabsf(pwmLevel - applied) > gateCfg->verifyTol_f)
+            {
+                loop->dutyMismatch = true;
+                loop->dutyMismatches++;
+                if (loop->reassertNs == 0 || now - loop->reassertNs >= gateCfg->reassertHoldNs)
+                {
+                    loop->reassertNs = now;
+                    loop->reasserts++;
+                    rs = hal->setFanLevel(hal->ctx, applied);
+                    if (R_SUCCEEDED(rs))
+                        FanWriteGateCommit(&loop->gate, applied, now);
+                    else
+                        FanWriteGateFail(&loop->gate);
+                }
+            }
+        }
+    }
+
+    /* ── Adaptive sleep from dT/dt and distance to next knot ────── */
+    u64 interval = FanSchedulerNext(&loop->sched, loop->schedCfg,
+                                    curve->points, curve->count,
+                                    tempC, now);
+
+    /* A ramp in progress needs a wake-up every step to continue. */
+    if (loop->gate.ramping && interval > loop->gateCfg->slewStepNs)
+        interval = loop->gateCfg->slewStepNs;
+    *interval_out = interval;
+    return rs;
+}
@@ -0,0 +1,672 @@
+#include <math.h>
+#include "controller.h"
+
+/* ── Curve ────────────────────────────────────────────────────────── */
+
+float InterpolateFanLevel(const TemperaturePoint *tbl, size_t count, float tempC)
+{
+    if (tempC <= tbl[0].temperature_c)
+        return tbl[0].fanLevel_f;
+
+    for (size_t i = 0; i < count - 1; i++)
+    {
+        if (tempC <= tbl[i + 1].temperature_c)
+        {
+            float dT = tbl[i + 1].temperature_c - tbl[i].temperature_c;
+            float dF = tbl[i + 1].fanLevel_f    - tbl[i].fanLevel_f;
+            float t  = (tempC - tbl[i].temperature_c) / dT;
+            return tbl[i].fanLevel_f + dF * t;
+        }
+    }
+
+    return tbl[count - 1].fanLevel_f;
+}
+
+/* ── Curve lookup table ───────────────────────────────────────────── */
+
+#define FAN_LUT_FRAC_BITS   15
+
+static inline u16 LevelToQ15(float level)
+{
+    if (level <= 0.0f)
+        return 0;
+    if (level >= 1.0f)
+        return FAN_LUT_ONE;
+    return (u16)(level * FAN_LUT_ONE + 0.5f);
+}
+
+void FanCurveLutBuild(FanCurveLut *lut, const TemperaturePoint *tbl, size_t count)
+{
+    for (size_t i = 0; i < FAN_LUT_ENTRIES; i++)
+    {
+        float tempC = FAN_LUT_MIN_C + (float)i / FAN_LUT_STEPS_PER_C;
+        lut->level[i] = LevelToQ15(InterpolateFanLevel(tbl, count, tempC));
+    }
+    lut->level[FAN_LUT_ENTRIES] = lut->level[FAN_LUT_ENTRIES - 1];
+}
+
+u16 FanCurveLutLookupQ15(const FanCurveLut *lut, float tempC)
+{
+    if (tempC <= FAN_LUT_MIN_C)
+        return lut->level[0];
+    if (tempC >= FAN_LUT_MAX_C)
+        return lut->level[FAN_LUT_ENTRIES - 1];
+
+    /* Position in cells with FAN_LUT_FRAC_BITS of sub-cell fraction. */
+    s32 pos  = (s32)((tempC - FAN_LUT_MIN_C) *
+                     (FAN_LUT_STEPS_PER_C << FAN_LUT_FRAC_BITS) + 0.5f);
+    s32 idx  = pos >> FAN_LUT_FRAC_BITS;
+    s32 frac = pos & ((1 << FAN_LUT_FRAC_BITS) - 1);
+
+    s32 a = lut->level[idx];
+    s32 b = lut->level[idx + 1];
+    return (u16)(a + (((b - a) * frac + (1 << (FAN_LUT_FRAC_BITS - 1))) >> FAN_LUT_FRAC_BITS));
+}
+
+void FanCurveBuild(FanCurve *curve, const TemperaturePoint *tbl, size_t count)
+{
+    if (count > FAN_CURVE_MAX_POINTS)
+        count = FAN_CURVE_MAX_POINTS;
+
+    for (size_t i = 0; i < count; i++)
+        curve->points[i] = tbl[i];
+    curve->count = count;
+    FanCurveLutBuild(&curve->lut, curve->points, count);
+}
+
+/* ── Write gate ───────────────────────────────────────────────────── */
+
+static inline s8 Sign(float v)
+{
+    return v > 0.0f ? 1 : (v < 0.0f ? -1 : 0);
+}
+
+bool FanWriteGateConfigValid(const FanWriteGateConfig *cfg)
+{
+    return cfg->deadband_f >= 0.0f && cfg->deadband_f <= 1.0f &&
+           cfg->hysteresis_f >= 0.0f && cfg->hysteresis_f <= 1.0f &&
+           isfinite(cfg->slewUp_f) && cfg->slewUp_f >= 0.0f &&
+           isfinite(cfg->slewDown_f) && cfg->slewDown_f >= 0.0f &&
+           cfg->verifyTol_f >= 0.0f && cfg->verifyTol_f <= 1.0f;
+}
+
+void FanWriteGateInit(FanWriteGate *gate)
+{
+    gate->applied          = -1.0f;
+    gate->direction        = 0;
+    gate->lastWriteNs      = 0;
+    gate->writesIssued     = 0;
+    gate->writesSuppressed = 0;
+    gate->slewLevel        = -1.0f;
+    gate->slewNs           = 0;
+    gate->ramping          = false;
+    gate->retry            = false;
+}
+
+float FanWriteGateSlew(FanWriteGate *gate, const FanWriteGateConfig *cfg,
+                       float target, u64 nowNs)
+{
+    float level = target;
+
+    if (gate->slewLevel >= 0.0f)
+    {
+        float dtS   = (float)(nowNs - gate->slewNs) / 1e9f;
+        float delta = target - gate->slewLevel;
+
+        if (cfg->slewUp_f > 0.0f && delta > cfg->slewUp_f * dtS)
+            level = gate->slewLevel + cfg->slewUp_f * dtS;
+        else if (cfg->slewDown_f > 0.0f && -delta > cfg->slewDown_f * dtS)
+            level = gate->slewLevel - cfg->slewDown_f * dtS;
+    }
+
+    gate->slewLevel = level;
+    gate->slewNs    = nowNs;
+    gate->ramping   = level != target;
+    return level;
+}
+
+bool FanWriteGateShouldWrite(FanWriteGate *gate, const FanWriteGateConfig *cfg,
+                             float target, u64 nowNs)
+{
+    if (gate->applied < 0.0f || gate->retry)
+        return true;
+
+    float delta     = target - gate->applied;
+    float magnitude = delta < 0.0f ? -delta : delta;
+    s8    direction = Sign(delta);
+    bool  write;
+
+    if (direction == 0)
+        write = false;
+    /* Coalesce the small steps of a ramp. */
+    else if (gate->ramping && nowNs - gate->lastWriteNs < cfg->slewStepNs)
+        write = false;
+    /* Always let the fan reach the ends of its range exactly. */
+    else if (target <= 0.0f || target >= 1.0f)
+        write = true;
+    else if (gate->direction == 0 || direction == gate->direction)
+        write = magnitude > cfg->deadband_f;
+    else
+        write = magnitude > cfg->deadband_f + cfg->hysteresis_f &&
+                nowNs - gate->lastWriteNs >= cfg->reverseHoldNs;
+
+    if (!write)
+        gate->writesSuppressed++;
+    return write;
+}
+
+void FanWriteGateCommit(FanWriteGate *gate, float level, u64 nowNs)
+{
+    if (gate->applied >= 0.0f)
+    {
+        s8 direction = Sign(level - gate->applied);
+        if (direction != 0)
+            gate->direction = direction;
+    }
+
+    gate->applied     = level;
+    gate->lastWriteNs = nowNs;
+    gate->retry       = false;
+    gate->writesIssued++;
+}
+
+void FanWriteGateFail(FanWriteGate *gate)
+{
+    gate->retry = true;
+}
+
+/* ── Sampling scheduler ───────────────────────────────────────────── */
+
+#define NS_PER_SECOND       1000000000ULL
+#define NS_PER_MINUTE      60000000000ULL
+#define SLOPE_EPSILON_CPS       0.001f
+
+bool FanSchedulerConfigValid(const FanSchedulerConfig *cfg)
+{
+    return cfg->minIntervalNs >= FAN_SCHEDULER_MIN_INTERVAL_NS &&
+           cfg->minIntervalNs <= cfg->maxIntervalNs &&
+           cfg->maxIntervalNs <= FAN_SCHEDULER_MAX_INTERVAL_NS &&
+           isfinite(cfg->resolutionC) && cfg->resolutionC > 0.0f &&
+           cfg->slopeAlpha > 0.0f && cfg->slopeAlpha <= 1.0f;
+}
+
+void FanSchedulerInit(FanScheduler *sched)
+{
+    sched->lastTempC        = 0.0f;
+    sched->lastNs           = 0;
+    sched->slopeCps         = 0.0f;
+    sched->primed           = false;
+    sched->windowStartNs    = 0;
+    sched->windowWakeups    = 0;
+    sched->wakeupsPerMinute = 0;
+}
+
+/* Distance from tempC to the next knot in the direction of travel, or to
+ * the closest knot when the temperature is flat. Knots closer than
+ * minDistance count as already reached. Negative if none. */
+static float DistanceToKnot(const TemperaturePoint *tbl, size_t count,
+                            float tempC, float slope, float minDistance)
+{
+    float best = -1.0f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float d = (float)tbl[i].temperature_c - tempC;
+
+        if (slope > SLOPE_EPSILON_CPS && d <= 0.0f)
+            continue;
+        if (slope < -SLOPE_EPSILON_CPS && d >= 0.0f)
+            continue;
+
+        if (d < 0.0f)
+            d = -d;
+        if (d < minDistance)
+            continue;
+        if (best < 0.0f || d < best)
+            best = d;
+    }
+    return best;
+}
+
+u64 FanSchedulerNext(FanScheduler *sched, const FanSchedulerConfig *cfg,
+                     const TemperaturePoint *tbl, size_t count,
+                     float tempC, u64 nowNs)
+{
+    /* ── Wake-up accounting ─────────────────────────────────────── */
+    if (sched->windowStartNs == 0)
+        sched->windowStartNs = nowNs;
+    sched->windowWakeups++;
+    if (nowNs - sched->windowStartNs >= NS_PER_MINUTE)
+    {
+        sched->wakeupsPerMinute = (u32)((u64)sched->windowWakeups * NS_PER_MINUTE
+                                        / (nowNs - sched->windowStartNs));
+        sched->windowStartNs    = nowNs;
+        sched->windowWakeups    = 0;
+    }
+
+    /* ── Slope estimate ─────────────────────────────────────────── */
+    if (sched->primed && nowNs > sched->lastNs)
+    {
+        float dt    = (float)(nowNs - sched->lastNs) / (float)NS_PER_SECOND;
+        float slope = (tempC - sched->lastTempC) / dt;
+        sched->slopeCps += cfg->slopeAlpha * (slope - sched->slopeCps);
+    }
+    sched->lastTempC = tempC;
+    sched->lastNs    = nowNs;
+
+    if (!sched->primed)
+    {
+        sched->primed = true;
+        return cfg->minIntervalNs;
+    }
+
+    /* ── Interval from slope and knot distance ──────────────────── */
+    float speed = sched->slopeCps < 0.0f ? -sched->slopeCps : sched->slopeCps;
+    if (speed < SLOPE_EPSILON_CPS)
+        return cfg->maxIntervalNs;
+
+    float seconds = cfg->resolutionC / speed;
+    float knot    = DistanceToKnot(tbl, count, tempC, sched->slopeCps,
+                                   cfg->resolutionC);
+    if (knot >= 0.0f && 0.5f * knot / speed < seconds)
+        seconds = 0.5f * knot / speed;
+
+    float ns = seconds * (float)NS_PER_SECOND;
+    if (ns <= (float)cfg->minIntervalNs)
+        return cfg->minIntervalNs;
+    if (ns >= (float)cfg->maxIntervalNs)
+        return cfg->maxIntervalNs;
+    return (u64)ns;
+}
+
+/* ── Sensor fusion ────────────────────────────────────────────────── */
+
+bool FanFusionConfigValid(const FanFusionConfig *cfg)
+{
+    if (cfg->mode > FanFusionMode_Curves)
+        return false;
+
+    for (int s = 0; s < FanSensor_Count; s++)
+    {
+        if (!isfinite(cfg->weight[s]) || cfg->weight[s] < 0.0f ||
+            !isfinite(cfg->offsetC[s]) || fabsf(cfg->offsetC[s]) > FAN_FUSION_MAX_OFFSET_C)
+            return false;
+    }
+    return true;
+}
+
+u32 FanFusionSensors(const FanFusionConfig *cfg)
+{
+    u32 mask = 1u << FanSensor_Soc;
+
+    if (cfg->mode == FanFusionMode_Soc)
+        return mask;
+
+    for (int s = 0; s < FanSensor_Count; s++)
+        if (cfg->weight[s] > 0.0f)
+            mask |= 1u << s;
+    return mask;
+}
+
+float FanFusionTemp(const FanFusionConfig *cfg, const FanCurveLut *lut,
+                    const float tempC[FanSensor_Count])
+{
+    float best      = -INFINITY;
+    u16   bestLevel = 0;
+    float sum       = 0.0f;
+    float weights   = 0.0f;
+    bool  any       = false;
+
+    if (cfg->mode == FanFusionMode_Soc)
+        return tempC[FanSensor_Soc];
+
+    for (int s = 0; s < FanSensor_Count; s++)
+    {
+        if (cfg->weight[s] <= 0.0f || !isfinite(tempC[s]))
+            continue;
+
+        float t = tempC[s] + cfg->offsetC[s];
+        any = true;
+
+        switch (cfg->mode)
+        {
+        case FanFusionMode_Max:
+            if (t > best)
+                best = t;
+            break;
+
+        case FanFusionMode_Weighted:
+            sum     += cfg->weight[s] * t;
+            weights += cfg->weight[s];
+            break;
+
+        case FanFusionMode_Curves:
+        {
+            /* Ties go to the hotter reading, it keeps the scheduler alert. */
+            u16 level = FanCurveLutLookupQ15(lut, t);
+            if (level > bestLevel || (level == bestLevel && t > best))
+            {
+                bestLevel = level;
+                best      = t;
+            }
+            break;
+        }
+        }
+    }
+
+    if (!any)
+        return tempC[FanSensor_Soc];
+    return cfg->mode == FanFusionMode_Weighted ? sum / weights : best;
+}
+
+/* ── Temperature filter ───────────────────────────────────────────── */
+
+bool FanFilterConfigValid(const FanFilterConfig *cfg)
+{
+    switch (cfg->mode)
+    {
+    case FanFilterMode_None:
+        return true;
+    case FanFilterMode_Ema:
+        return cfg->emaAlpha > 0.0f && cfg->emaAlpha <= 1.0f;
+    case FanFilterMode_Median:
+        return cfg->medianWindow >= 1 && cfg->medianWindow <= FAN_FILTER_MEDIAN_MAX &&
+               (cfg->medianWindow & 1) == 1;
+    case FanFilterMode_Kalman:
+        return isfinite(cfg->kalmanQ) && cfg->kalmanQ > 0.0f &&
+               isfinite(cfg->kalmanR) && cfg->kalmanR > 0.0f &&
+               isfinite(cfg->outlierSigma) && cfg->outlierSigma > 0.0f;
+    default:
+        return false;
+    }
+}
+
+void FanFilterInit(FanFilter *filter)
+{
+    filter->head      = 0;
+    filter->fill      = 0;
+    filter->value     = 0.0f;
+    filter->variance  = 0.0f;
+    filter->lastNs    = 0;
+    filter->rejectRun = 0;
+    filter->outliers  = 0;
+    filter->primed    = false;
+}
+
+/* Insertion sort of at most FAN_FILTER_MEDIAN_MAX values: cheaper than
+ * anything cleverer at this size. */
+static float FilterMedian(FanFilter *filter, const FanFilterConfig *cfg, float tempC)
+{
+    float sorted[FAN_FILTER_MEDIAN_MAX];
+
+    /* The window may have shrunk since the last reading. */
+    if (filter->fill > cfg->medianWindow || filter->head >= cfg->medianWindow)
+    {
+        filter->head = 0;
+        filter->fill = 0;
+    }
+
+    filter->window[filter->head] = tempC;
+    filter->head = (filter->head + 1) % cfg->medianWindow;
+    if (filter->fill < cfg->medianWindow)
+        filter->fill++;
+
+    for (u32 i = 0; i < filter->fill; i++)
+    {
+        float v = filter->window[i];
+        u32 j = i;
+        while (j > 0 && sorted[j - 1] > v)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    /* Until the window fills, the lower median of what is there. */
+    return sorted[(filter->fill - 1) / 2];
+}
+
+static float FilterKalman(FanFilter *filter, const FanFilterConfig *cfg,
+                          float tempC, u64 nowNs)
+{
+    float dtS = (float)(nowNs - filter->lastNs) / (float)NS_PER_SECOND;
+    float p   = filter->variance + cfg->kalmanQ * dtS;
+    float s   = p + cfg->kalmanR;
+    float y   = tempC - filter->value;
+
+    if (y * y > cfg->outlierSigma * cfg->outlierSigma * s &&
+        filter->rejectRun < FAN_FILTER_MAX_REJECTS)
+    {
+        /* Keep the grown variance: if the jump is real, the next
+         * readings are less surprising and get through. */
+        filter->rejectRun++;
+        filter->outliers++;
+        filter->variance = p;
+        return filter->value;
+    }
+
+    if (filter->rejectRun >= FAN_FILTER_MAX_REJECTS)
+    {
+        /* Too many outliers in a row: the temperature really moved, so
+         * restart from the reading instead of creeping towards it. */
+        filter->rejectRun = 0;
+        filter->value     = tempC;
+        filter->variance  = cfg->kalmanR;
+        return filter->value;
+    }
+
+    float k = p / s;
+    filter->rejectRun = 0;
+    filter->value    += k * y;
+    filter->variance  = (1.0f - k) * p;
+    return filter->value;
+}
+
+float FanFilterUpdate(FanFilter *filter, const FanFilterConfig *cfg,
+                      float tempC, u64 nowNs)
+{
+    if (!filter->primed && cfg->mode != FanFilterMode_Median)
+    {
+        filter->primed   = true;
+        filter->value    = tempC;
+        filter->variance = cfg->kalmanR;
+        filter->lastNs   = nowNs;
+        return tempC;
+    }
+
+    switch (cfg->mode)
+    {
+    case FanFilterMode_Ema:
+        filter->value += cfg->emaAlpha * (tempC - filter->value);
+        break;
+    case FanFilterMode_Median:
+        filter->primed = true;
+        filter->value  = FilterMedian(filter, cfg, tempC);
+        break;
+    case FanFilterMode_Kalman:
+        filter->value  = FilterKalman(filter, cfg, tempC, nowNs);
+        break;
+    default:
+        filter->value  = tempC;
+        break;
+    }
+
+    filter->lastNs = nowNs;
+    return filter->value;
+}
+
+/* ── Thermal model lookahead ──────────────────────────────────────── */
+
+#define PREDICT_COV_INIT    1000.0
+#define PREDICT_COV_MAX     1e6     /* stop forgetting past this trace */
+
+bool FanPredictConfigValid(const FanPredictConfig *cfg)
+{
+    if (cfg->enabled > 1)
+        return false;
+    return !cfg->enabled ||
+           (isfinite(cfg->horizonS) && cfg->horizonS > 0.0f &&
+            cfg->horizonS <= FAN_PREDICT_HORIZON_MAX_S &&
+            cfg->forgetting >= 0.9f && cfg->forgetting <= 1.0f &&
+            isfinite(cfg->maxLeadC) && cfg->maxLeadC > 0.0f &&
+            cfg->maxLeadC <= FAN_PREDICT_MAX_LEAD_C);
+}
+
+void FanPredictorInit(FanPredictor *pred)
+{
+    for (int i = 0; i < FAN_PREDICT_PARAMS; i++)
+    {
+        pred->theta[i] = 0.0;
+        for (int j = 0; j < FAN_PREDICT_PARAMS; j++)
+            pred->cov[i][j] = i == j ? PREDICT_COV_INIT : 0.0;
+    }
+    pred->lastTempC  = 0.0f;
+    pred->lastLevel  = -1.0f;
+    pred->lastNs     = 0;
+    pred->slopeCps   = NAN;
+    pred->samples    = 0;
+    pred->tauS       = 0.0f;
+    pred->gainC      = 0.0f;
+    pred->predictedC = 0.0f;
+    pred->primed     = false;
+}
+
+/* One RLS step towards y = theta . phi. With a steady temperature and fan
+ * the regressors carry no new information and forgetting alone would
+ * inflate the covariance without bound, so it pauses once that is large. */
+static void PredictorFit(FanPredictor *pred, const FanPredictConfig *cfg,
+                         const double phi[FAN_PREDICT_PARAMS], double y)
+{
+    double pphi[FAN_PREDICT_PARAMS], gain[FAN_PREDICT_PARAMS];
+    double trace = 0.0;
+
+    for (int i = 0; i < FAN_PREDICT_PARAMS; i++)
+        trace += pred->cov[i][i];
+    double lambda = trace > PREDICT_COV_MAX ? 1.0 : (double)cfg->forgetting;
+    double denom = lambda, err = y;
+
+    for (int i = 0; i < FAN_PREDICT_PARAMS; i++)
+    {
+        pphi[i] = 0.0;
+        for (int j = 0; j < FAN_PREDICT_PARAMS; j++)
+            pphi[i] += pred->cov[i][j] * phi[j];
+        denom += phi[i] * pphi[i];
+        err   -= pred->theta[i] * phi[i];
+    }
+
+    for (int i = 0; i < FAN_PREDICT_PARAMS; i++)
+    {
+        gain[i] = pphi[i] / denom;
+        pred->theta[i] += gain[i] * err;
+    }
+    for (int i = 0; i < FAN_PREDICT_PARAMS; i++)
+        for (int j = 0; j < FAN_PREDICT_PARAMS; j++)
+            pred->cov[i][j] = (pred->cov[i][j] - gain[i] * pphi[j]) / lambda;
+}
+
+float FanPredictorUpdate(FanPredictor *pred, const FanPredictConfig *cfg,
+                         float tempC, float level, u64 nowNs)
+{
+    if (!pred->primed || nowNs - pred->lastNs > FAN_PREDICT_GAP_NS)
+    {
+        /* First reading, or the loop stalled: start a new slope. The fit
+         * itself is kept. */
+        pred->primed    = true;
+        pred->lastTempC = tempC;
+        pred->lastLevel = level;
+        pred->lastNs    = nowNs;
+        pred->slopeCps  = NAN;
+    }
+    else if (nowNs - pred->lastNs >= FAN_PREDICT_SAMPLE_NS)
+    {
+        double dtS   = (double)(nowNs - pred->lastNs) / (double)NS_PER_SECOND;
+        double slope = (double)(tempC - pred->lastTempC) / dtS;
+
+        if (!isnan(pred->slopeCps) && pred->lastLevel >= 0.0f && level >= 0.0f)
+        {
+            const double phi[FAN_PREDICT_PARAMS] =
+            {
+                (double)pred->slopeCps,
+                (double)(level - pred->lastLevel) / dtS,
+            };
+            PredictorFit(pred, cfg, phi, (slope - (double)pred->slopeCps) / dtS);
+            pred->samples++;
+        }
+        pred->slopeCps  = (float)slope;
+        pred->lastTempC = tempC;
+        pred->lastLevel = level;
+        pred->lastNs    = nowNs;
+
+        double a = pred->theta[0];
+        double tau = a < 0.0 ? -1.0 / a : 0.0;
+        if (pred->samples >= FAN_PREDICT_MIN_SAMPLES &&
+            tau >= FAN_PREDICT_TAU_MIN_S && tau <= FAN_PREDICT_TAU_MAX_S)
+        {
+            pred->tauS  = (float)tau;
+            pred->gainC = (float)(-pred->theta[1] / a);
+        }
+        else
+        {
+            pred->tauS  = 0.0f;
+            pred->gainC = 0.0f;
+        }
+    }
+
+    float lead = 0.0f;
+    if (pred->tauS > 0.0f && !isnan(pred->slopeCps))
+    {
+        lead = pred->slopeCps * pred->tauS * (1.0f - expf(-cfg->horizonS / pred->tauS));
+        lead = fminf(fmaxf(lead, -cfg->maxLeadC), cfg->maxLeadC);
+    }
+    pred->predictedC = tempC + lead;
+    return pred->predictedC;
+}
+
+/* ── PID ──────────────────────────────────────────────────────────── */
+
+bool FanPidConfigValid(const FanPidConfig *cfg)
+{
+    return isfinite(cfg->setpointC) && isfinite(cfg->kp) && isfinite(cfg->ki) &&
+           isfinite(cfg->kd) && isfinite(cfg->feedForward_f) &&
+           cfg->outMin_f >= 0.0f && cfg->outMin_f < cfg->outMax_f && cfg->outMax_f <= 1.0f;
+}
+
+void FanPidInit(FanPid *pid)
+{
+    pid->integral  = 0.0f;
+    pid->lastTempC = 0.0f;
+    pid->primed    = false;
+}
+
+float FanPidUpdate(FanPid *pid, const FanPidConfig *cfg,
+                   float tempC, float feedForward, float dtS, bool holdIntegral)
+{
+    float error = tempC - cfg->setpointC;
+
+    /* Derivative on measurement so setpoint changes don't kick the fan. */
+    float derivative = 0.0f;
+    if (pid->primed && dtS > 0.0f)
+        derivative = (tempC - pid->lastTempC) / dtS;
+    pid->lastTempC = tempC;
+    pid->primed    = true;
+
+    float base = cfg->feedForward_f * feedForward + cfg->kp * error + cfg->kd * derivative;
+    float out  = base + pid->integral;
+
+    /* Anti-windup: only integrate when it doesn't push further into a limit
+     * and the fan is actually following the output. */
+    bool saturatedHigh = out >= cfg->outMax_f && error > 0.0f;
+    bool saturatedLow  = out <= cfg->outMin_f && error < 0.0f;
+    if (!saturatedHigh && !saturatedLow && !holdIntegral && dtS > 0.0f)
+    {
+        pid->integral += cfg->ki * error * dtS;
+        out = base + pid->integral;
+    }
+
+    if (out > cfg->outMax_f)
+        out = cfg->outMax_f;
+    if (out < cfg->outMin_f)
+        out = cfg->outMin_f;
+    return out;
+}
@@ -0,0 +1,598 @@
+#include <math.h>
+#include <string.h>
+#include "fan_config.h"
+
+_Static_assert(sizeof(FanConfigHeader) == 16, "FanConfigHeader must stay 16 bytes");
+_Static_assert(sizeof(FanConfigRecord) == 4, "FanConfigRecord must stay 4 bytes");
+_Static_assert(sizeof(TemperaturePoint) == 8, "curve records store 8-byte points");
+_Static_assert(sizeof(FanProfileRule) == 4, "rule records store 4-byte rules");
+_Static_assert(sizeof(FanTitleRule) == 16, "title records store 16-byte rules");
+_Static_assert(FAN_TITLE_INDEX_SIZE >= 2 * FAN_TITLE_RULE_MAX,
+               "the title index must stay at most half full");
+
+#define FAN_CONFIG_LEGACY_SIZE  (FAN_CONFIG_LEGACY_POINTS * sizeof(TemperaturePoint))
+
+/* One record per block of FanControllerSettings. */
+#define FAN_SETTINGS_RECORDS    8
+
+_Static_assert(sizeof(FanConfigHeader) + FAN_SETTINGS_RECORDS * sizeof(FanConfigRecord) +
+               sizeof(FanControllerSettings) <= FAN_SETTINGS_MAX_SIZE,
+               "settings.dat must fit FAN_SETTINGS_MAX_SIZE");
+
+/* ── CRC32 ────────────────────────────────────────────────────────── */
+
+/* IEEE 802.3 CRC32, a nibble at a time: the file is a few hundred bytes
+ * at most, so the 64-byte table beats a 1 KiB one. */
+static const u32 fanConfigCrcNibble[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+u32 FanConfigCrc32(const void *data, size_t size)
+{
+    const u8 *p = data;
+    u32 crc = 0xFFFFFFFF;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ fanConfigCrcNibble[crc & 0xF];
+        crc = (crc >> 4) ^ fanConfigCrcNibble[crc & 0xF];
+    }
+    return ~crc;
+}
+
+/* ── Validation ───────────────────────────────────────────────────── */
+
+bool FanConfigCurveValid(const TemperaturePoint *tbl, size_t count)
+{
+    if (count < FAN_CURVE_MIN_POINTS || count > FAN_CURVE_MAX_POINTS)
+        return false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (tbl[i].temperature_c < FAN_LUT_MIN_C || tbl[i].temperature_c > FAN_LUT_MAX_C)
+            return false;
+        if (i > 0 && tbl[i].temperature_c <= tbl[i - 1].temperature_c)
+            return false;
+        if (!isfinite(tbl[i].fanLevel_f) || tbl[i].fanLevel_f < 0.0f || tbl[i].fanLevel_f > 1.0f)
+            return false;
+    }
+    return true;
+}
+
+static bool RuleValid(const FanProfileRule *rule, size_t profileCount)
+{
+    return rule->profile < profileCount &&
+           rule->docked <= FanProfileMatch_No &&
+           rule->charging <= FanProfileMatch_No &&
+           rule->batteryMax <= 100;
+}
+
+static bool TitlesValid(const FanTitleRule *titles, size_t count, size_t profileCount)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (titles[i].titleId == 0 || titles[i].profile >= profileCount)
+            return false;
+        for (size_t j = 0; j < i; j++)
+            if (titles[j].titleId == titles[i].titleId)
+                return false;
+    }
+    return true;
+}
+
+bool FanConfigValid(const FanConfig *cfg)
+{
+    if (cfg->profileCount < 1 || cfg->profileCount > FAN_PROFILE_MAX ||
+        cfg->ruleCount > FAN_PROFILE_RULE_MAX || cfg->titleCount > FAN_TITLE_RULE_MAX)
+        return false;
+
+    for (size_t i = 0; i < cfg->profileCount; i++)
+    {
+        const FanProfile *p = &cfg->profiles[i];
+        if (memchr(p->name, '\0', sizeof(p->name)) == NULL ||
+            !FanConfigCurveValid(p->points, p->count))
+            return false;
+    }
+
+    for (size_t i = 0; i < cfg->ruleCount; i++)
+        if (!RuleValid(&cfg->rules[i], cfg->profileCount))
+            return false;
+    return TitlesValid(cfg->titles, cfg->titleCount, cfg->profileCount);
+}
+
+/* ── Profiles ─────────────────────────────────────────────────────── */
+
+static bool MatchFlag(u8 match, bool value)
+{
+    return match == FanProfileMatch_Any || (match == FanProfileMatch_Yes) == value;
+}
+
+size_t FanProfileSelect(const FanConfig *cfg, const FanPowerState *power)
+{
+    for (size_t i = 0; i < cfg->ruleCount; i++)
+    {
+        const FanProfileRule *rule = &cfg->rules[i];
+
+        if (MatchFlag(rule->docked, power->docked) &&
+            MatchFlag(rule->charging, power->charging) &&
+            (rule->batteryMax >= 100 || power->batteryPercent <= rule->batteryMax))
+            return rule->profile;
+    }
+    return 0;
+}
+
+/* Fibonacci hashing: title IDs share their high bits, the multiply mixes
+ * the low ones up into the bits that are kept. */
+static size_t TitleSlot(u64 titleId)
+{
+    return (size_t)((titleId * 0x9E3779B97F4A7C15ULL) >> (64 - FAN_TITLE_INDEX_BITS));
+}
+
+void FanTitleIndexBuild(FanTitleIndex *index, const FanConfig *cfg)
+{
+    memset(index->titleIds, 0, sizeof(index->titleIds));
+
+    for (size_t i = 0; i < cfg->titleCount; i++)
+    {
+        size_t slot = TitleSlot(cfg->titles[i].titleId);
+        while (index->titleIds[slot] != 0)
+            slot = (slot + 1) & (FAN_TITLE_INDEX_SIZE - 1);
+
+        index->titleIds[slot] = cfg->titles[i].titleId;
+        index->profiles[slot] = cfg->titles[i].profile;
+    }
+}
+
+int FanTitleIndexLookup(const FanTitleIndex *index, u64 titleId)
+{
+    if (titleId == 0)
+        return -1;
+
+    for (size_t slot = TitleSlot(titleId); index->titleIds[slot] != 0;
+         slot = (slot + 1) & (FAN_TITLE_INDEX_SIZE - 1))
+    {
+        if (index->titleIds[slot] == titleId)
+            return index->profiles[slot];
+    }
+    return -1;
+}
+
+void FanConfigInitSingle(FanConfig *cfg, const TemperaturePoint *tbl, size_t count)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    strcpy(cfg->profiles[0].name, FAN_PROFILE_DEFAULT_NAME);
+    memcpy(cfg->profiles[0].points, tbl, count * sizeof(TemperaturePoint));
+    cfg->profiles[0].count = count;
+    cfg->profileCount = 1;
+}
+
+bool FanConfigEqual(const FanConfig *a, const FanConfig *b)
+{
+    if (a->profileCount != b->profileCount || a->ruleCount != b->ruleCount ||
+        a->titleCount != b->titleCount)
+        return false;
+
+    for (size_t i = 0; i < a->profileCount; i++)
+    {
+        const FanProfile *pa = &a->profiles[i];
+        const FanProfile *pb = &b->profiles[i];
+
+        if (strncmp(pa->name, pb->name, FAN_PROFILE_NAME_MAX) != 0 || pa->count != pb->count ||
+            memcmp(pa->points, pb->points, pa->count * sizeof(TemperaturePoint)) != 0)
+            return false;
+    }
+    for (size_t i = 0; i < a->titleCount; i++)
+    {
+        if (a->titles[i].titleId != b->titles[i].titleId ||
+            a->titles[i].profile != b->titles[i].profile)
+            return false;
+    }
+    return memcmp(a->rules, b->rules, a->ruleCount * sizeof(FanProfileRule)) == 0;
+}
+
+/* ── Parser ───────────────────────────────────────────────────────── */
+
+static FanConfigResult ParseCurve(const u8 *data, size_t size, FanProfile *out)
+{
+    size_t count = size / sizeof(TemperaturePoint);
+    TemperaturePoint tmp[FAN_CURVE_MAX_POINTS];
+
+    if (size % sizeof(TemperaturePoint) != 0 ||
+        count < FAN_CURVE_MIN_POINTS || count > FAN_CURVE_MAX_POINTS)
+        return FanConfigResult_BadCurve;
+
+    memcpy(tmp, data, size);
+    if (!FanConfigCurveValid(tmp, count))
+        return FanConfigResult_BadCurve;
+
+    memcpy(out->points, tmp, size);
+    out->count = count;
+    return FanConfigResult_Ok;
+}
+
+static FanConfigResult ParseName(const u8 *data, size_t size, FanProfile *out)
+{
+    if (size < FAN_PROFILE_NAME_MAX || memchr(data, '\0', FAN_PROFILE_NAME_MAX) == NULL)
+        return FanConfigResult_BadProfile;
+
+    memcpy(out->name, data, FAN_PROFILE_NAME_MAX);
+    return FanConfigResult_Ok;
+}
+
+/* Old files may hold points in any order and repeat temperatures: sort
+ * them and keep the last point for each temperature, which is the one the
+ * old scan-based lookup followed above that temperature. */
+static FanConfigResult ParseLegacy(const u8 *data, FanConfig *out)
+{
+    TemperaturePoint tmp[FAN_CONFIG_LEGACY_POINTS];
+    size_t count = 0;
+
+    memcpy(tmp, data, sizeof(tmp));
+    for (size_t i = 1; i < FAN_CONFIG_LEGACY_POINTS; i++)
+    {
+        TemperaturePoint p = tmp[i];
+        size_t j = i;
+        while (j > 0 && tmp[j - 1].temperature_c > p.temperature_c)
+        {
+            tmp[j] = tmp[j - 1];
+            j--;
+        }
+        tmp[j] = p;
+    }
+
+    for (size_t i = 0; i < FAN_CONFIG_LEGACY_POINTS; i++)
+    {
+        if (count > 0 && tmp[count - 1].temperature_c == tmp[i].temperature_c)
+            count--;
+        tmp[count++] = tmp[i];
+    }
+
+    if (!FanConfigCurveValid(tmp, count))
+        return FanConfigResult_BadCurve;
+
+    FanConfigInitSingle(out, tmp, count);
+    return FanConfigResult_Legacy;
+}
+
+static FanConfigResult ParseRecord(const FanConfigRecord *record, const u8 *data,
+                                   FanConfig *cfg, bool *haveCurve, bool *haveName)
+{
+    FanConfigResult result;
+
+    switch (record->tag)
+    {
+    case FanConfigTag_Curve:
+        if (*haveCurve)
+            return FanConfigResult_BadRecord;
+        *haveCurve = true;
+        return ParseCurve(data, record->size, &cfg->profiles[0]);
+
+    case FanConfigTag_ProfileName:
+        if (*haveName || record->size != FAN_PROFILE_NAME_MAX)
+            return FanConfigResult_BadRecord;
+        *haveName = true;
+        return ParseName(data, record->size, &cfg->profiles[0]);
+
+    case FanConfigTag_Profile:
+    {
+        /* Slot 0 belongs to the Curve record. */
+        size_t index = cfg->profileCount == 0 ? 1 : cfg->profileCount;
+        if (index >= FAN_PROFILE_MAX)
+            return FanConfigResult_BadProfile;
+
+        FanProfile *profile = &cfg->profiles[index];
+        result = ParseName(data, record->size, profile);
+        if (result != FanConfigResult_Ok)
+            return result;
+        result = ParseCurve(data + FAN_PROFILE_NAME_MAX, record->size - FAN_PROFILE_NAME_MAX,
+                            profile);
+        if (result != FanConfigResult_Ok)
+            return result;
+
+        cfg->profileCount = index + 1;
+        return FanConfigResult_Ok;
+    }
+
+    case FanConfigTag_Rule:
+        if (record->size != sizeof(FanProfileRule) || cfg->ruleCount >= FAN_PROFILE_RULE_MAX)
+            return FanConfigResult_BadRecord;
+        memcpy(&cfg->rules[cfg->ruleCount++], data, sizeof(FanProfileRule));
+        return FanConfigResult_Ok;
+
+    case FanConfigTag_Title:
+        if (record->size != sizeof(FanTitleRule) || cfg->titleCount >= FAN_TITLE_RULE_MAX)
+            return FanConfigResult_BadRecord;
+        memcpy(&cfg->titles[cfg->titleCount++], data, sizeof(FanTitleRule));
+        return FanConfigResult_Ok;
+
+    default:
+        return FanConfigResult_Ok;
+    }
+}
+
+/* Checks the header and the payload checksum of a file image; shared by
+ * config.dat and settings.dat. */
+static FanConfigResult CheckHeader(const u8 *bytes, size_t size, u32 magic, u16 version,
+                                   FanConfigHeader *header)
+{
+    if (size < sizeof(*header))
+        return FanConfigResult_Truncated;
+    memcpy(header, bytes, sizeof(*header));
+
+    if (header->magic != magic)
+        return FanConfigResult_BadMagic;
+    if (header->version == 0 || header->version > version)
+        return FanConfigResult_BadVersion;
+    if (header->headerSize < sizeof(*header) || header->headerSize > size ||
+        header->payloadSize != size - header->headerSize)
+        return FanConfigResult_Truncated;
+    if (FanConfigCrc32(bytes + header->headerSize, header->payloadSize) != header->crc32)
+        return FanConfigResult_BadChecksum;
+    return FanConfigResult_Ok;
+}
+
+FanConfigResult FanConfigParse(const void *data, size_t size, FanConfig *out)
+{
+    const u8 *bytes = data;
+    FanConfigHeader header;
+    FanConfig cfg;
+
+    FanConfigResult check = CheckHeader(bytes, size, FAN_CONFIG_MAGIC, FAN_CONFIG_VERSION, &header);
+    if (check == FanConfigResult_BadMagic && size == FAN_CONFIG_LEGACY_SIZE)
+        return ParseLegacy(bytes, out);
+    if (check != FanConfigResult_Ok)
+        return check;
+
+    const u8 *payload = bytes + header.headerSize;
+
+    memset(&cfg, 0, sizeof(cfg));
+    bool haveCurve = false;
+    bool haveName = false;
+    size_t offset = 0;
+    while (offset < header.payloadSize)
+    {
+        FanConfigRecord record;
+
+        if (header.payloadSize - offset < sizeof(record))
+            return FanConfigResult_BadRecord;
+        memcpy(&record, payload + offset, sizeof(record));
+        offset += sizeof(record);
+
+        if (record.size > header.payloadSize - offset)
+            return FanConfigResult_BadRecord;
+
+        FanConfigResult result = ParseRecord(&record, payload + offset, &cfg,
+                                             &haveCurve, &haveName);
+        if (result != FanConfigResult_Ok)
+            return result;
+        offset += record.size;
+    }
+
+    if (!haveCurve)
+        return FanConfigResult_NoCurve;
+
+    if (cfg.profileCount == 0)
+        cfg.profileCount = 1;
+    if (!haveName)
+        strcpy(cfg.profiles[0].name, FAN_PROFILE_DEFAULT_NAME);
+
+    for (size_t i = 0; i < cfg.ruleCount; i++)
+        if (!RuleValid(&cfg.rules[i], cfg.profileCount))
+            return FanConfigResult_BadProfile;
+    if (!TitlesValid(cfg.titles, cfg.titleCount, cfg.profileCount))
+        return FanConfigResult_BadProfile;
+
+    *out = cfg;
+    return FanConfigResult_Ok;
+}
+
+/* ── Writer ───────────────────────────────────────────────────────── */
+
+static u8 *PutRecord(u8 *p, u16 tag, const void *a, size_t aSize,
+                     const void *b, size_t bSize)
+{
+    FanConfigRecord record =
+    {
+        .tag  = tag,
+        .size = (u16)(aSize + bSize),
+    };
+    memcpy(p, &record, sizeof(record));
+    p += sizeof(record);
+    memcpy(p, a, aSize);
+    p += aSize;
+    if (bSize > 0)
+        memcpy(p, b, bSize);
+    return p + bSize;
+}
+
+size_t FanConfigSerialize(const FanConfig *cfg, void *buf, size_t cap)
+{
+    u8 *bytes = buf;
+
+    if (!FanConfigValid(cfg))
+        return 0;
+
+    const FanProfile *first = &cfg->profiles[0];
+    size_t payloadSize = 2 * sizeof(FanConfigRecord) + FAN_PROFILE_NAME_MAX +
+                         first->count * sizeof(TemperaturePoint);
+    for (size_t i = 1; i < cfg->profileCount; i++)
+        payloadSize += sizeof(FanConfigRecord) + FAN_PROFILE_NAME_MAX +
+                       cfg->profiles[i].count * sizeof(TemperaturePoint);
+    payloadSize += cfg->ruleCount * (sizeof(FanConfigRecord) + sizeof(FanProfileRule));
+    payloadSize += cfg->titleCount * (sizeof(FanConfigRecord) + sizeof(FanTitleRule));
+
+    size_t total = sizeof(FanConfigHeader) + payloadSize;
+    if (total > cap)
+        return 0;
+
+    u8 *payload = bytes + sizeof(FanConfigHeader);
+    u8 *p = payload;
+    char name[FAN_PROFILE_NAME_MAX];
+
+    p = PutRecord(p, FanConfigTag_Curve, first->points,
+                  first->count * sizeof(TemperaturePoint), NULL, 0);
+
+    memset(name, 0, sizeof(name));
+    strcpy(name, first->name);
+    p = PutRecord(p, FanConfigTag_ProfileName, name, sizeof(name), NULL, 0);
+
+    for (size_t i = 1; i < cfg->profileCount; i++)
+    {
+        const FanProfile *profile = &cfg->profiles[i];
+        memset(name, 0, sizeof(name));
+        strcpy(name, profile->name);
+        p = PutRecord(p, FanConfigTag_Profile, name, sizeof(name),
+                      profile->points, profile->count * sizeof(TemperaturePoint));
+    }
+
+    for (size_t i = 0; i < cfg->ruleCount; i++)
+        p = PutRecord(p, FanConfigTag_Rule, &cfg->rules[i], sizeof(FanProfileRule), NULL, 0);
+
+    for (size_t i = 0; i < cfg->titleCount; i++)
+    {
+        FanTitleRule title = { .titleId = cfg->titles[i].titleId, .profile = cfg->titles[i].profile };
+        p = PutRecord(p, FanConfigTag_Title, &title, sizeof(title), NULL, 0);
+    }
+
+    FanConfigHeader header =
+    {
+        .magic       = FAN_CONFIG_MAGIC,
+        .version     = FAN_CONFIG_VERSION,
+        .headerSize  = sizeof(FanConfigHeader),
+        .payloadSize = (u32)payloadSize,
+        .crc32       = FanConfigCrc32(payload, payloadSize),
+    };
+    memcpy(bytes, &header, sizeof(header));
+    return total;
+}
+
+/* ── Settings file ────────────────────────────────────────────────── */
+
+bool FanSettingsValid(const FanControllerSettings *settings)
+{
+    return settings->mode <= FanControlMode_Pid &&
+           settings->logLevel <= FanLogLevel_Error &&
+           FanPidConfigValid(&settings->pid) &&
+           FanFusionConfigValid(&settings->fusion) &&
+           FanFilterConfigValid(&settings->filter) &&
+           FanPredictConfigValid(&settings->predict) &&
+           FanWriteGateConfigValid(&settings->gate) &&
+           FanSchedulerConfigValid(&settings->sched) &&
+           settings->gate.slewStepNs >= settings->sched.minIntervalNs;
+}
+
+static const FanControllerSettings fanSettingsDefaults = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+
+FanConfigResult FanSettingsParse(const void *data, size_t size, FanControllerSettings *out)
+{
+    const u8 *bytes = data;
+    FanConfigHeader header;
+    FanControllerSettings settings = fanSettingsDefaults;
+
+    FanConfigResult check = CheckHeader(bytes, size, FAN_SETTINGS_MAGIC, FAN_SETTINGS_VERSION, &header);
+    if (check != FanConfigResult_Ok)
+        return check;
+
+    const u8 *payload = bytes + header.headerSize;
+    size_t offset = 0;
+    while (offset < header.payloadSize)
+    {
+        FanConfigRecord record;
+
+        if (header.payloadSize - offset < sizeof(record))
+            return FanConfigResult_BadRecord;
+        memcpy(&record, payload + offset, sizeof(record));
+        offset += sizeof(record);
+        if (record.size > header.payloadSize - offset)
+            return FanConfigResult_BadRecord;
+
+        void  *field = NULL;
+        size_t fieldSize = 0;
+        switch (record.tag)
+        {
+            case FanSettingsTag_Mode:    field = &settings.mode;    fieldSize = sizeof(settings.mode);    break;
+            case FanSettingsTag_Pid:     field = &settings.pid;     fieldSize = sizeof(settings.pid);     break;
+            case FanSettingsTag_Fusion:  field = &settings.fusion;  fieldSize = sizeof(settings.fusion);  break;
+            case FanSettingsTag_Filter:  field = &settings.filter;  fieldSize = sizeof(settings.filter);  break;
+            case FanSettingsTag_Predict: field = &settings.predict; fieldSize = sizeof(settings.predict); break;
+            case FanSettingsTag_Gate:    field = &settings.gate;    fieldSize = sizeof(settings.gate);    break;
+            case FanSettingsTag_Sched:   field = &settings.sched;   fieldSize = sizeof(settings.sched);   break;
+            case FanSettingsTag_Log:     field = &settings.logLevel; fieldSize = sizeof(settings.logLevel); break;
+            default:                     break;
+        }
+        if (field != NULL)
+        {
+            if (record.size != fieldSize)
+                return FanConfigResult_BadRecord;
+            memcpy(field, payload + offset, fieldSize);
+        }
+        offset += record.size;
+    }
+
+    if (!FanSettingsValid(&settings))
+        return FanConfigResult_BadRecord;
+    *out = settings;
+    return FanConfigResult_Ok;
+}
+
+size_t FanSettingsSerialize(const FanControllerSettings *settings, void *buf, size_t cap)
+{
+    u8 *bytes = buf;
+
+    if (!FanSettingsValid(settings))
+        return 0;
+
+    size_t payloadSize = FAN_SETTINGS_RECORDS * sizeof(FanConfigRecord) + sizeof(settings->mode) +
+                         sizeof(settings->pid) + sizeof(settings->fusion) +
+                         sizeof(settings->filter) + sizeof(settings->predict) +
+                         sizeof(settings->gate) + sizeof(settings->sched) +
+                         sizeof(settings->logLevel);
+    size_t total = sizeof(FanConfigHeader) + payloadSize;
+    if (total > cap)
+        return 0;
+
+    u8 *payload = bytes + sizeof(FanConfigHeader);
+    u8 *p = payload;
+    p = PutRecord(p, FanSettingsTag_Mode, &settings->mode, sizeof(settings->mode), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Pid, &settings->pid, sizeof(settings->pid), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Fusion, &settings->fusion, sizeof(settings->fusion), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Filter, &settings->filter, sizeof(settings->filter), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Predict, &settings->predict, sizeof(settings->predict), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Gate, &settings->gate, sizeof(settings->gate), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Sched, &settings->sched, sizeof(settings->sched), NULL, 0);
+    p = PutRecord(p, FanSettingsTag_Log, &settings->logLevel, sizeof(settings->logLevel), NULL, 0);
+
+    FanConfigHeader header =
+    {
+        .magic       = FAN_SETTINGS_MAGIC,
+        .version     = FAN_SETTINGS_VERSION,
+        .headerSize  = sizeof(FanConfigHeader),
+        .payloadSize = (u32)payloadSize,
+        .crc32       = FanConfigCrc32(payload, payloadSize),
+    };
+    memcpy(bytes, &header, sizeof(header));
+    return total;
+}
+
+const char *FanConfigResultString(FanConfigResult result)
+{
+    switch (result)
+    {
+        case FanConfigResult_Ok:            return "ok";
+        case FanConfigResult_Legacy:        return "legacy format";
+        case FanConfigResult_Truncated:     return "truncated";
+        case FanConfigResult_BadMagic:      return "bad magic";
+        case FanConfigResult_BadVersion:    return "unsupported version";
+        case FanConfigResult_BadChecksum:   return "checksum mismatch";
+        case FanConfigResult_BadRecord:     return "malformed record";
+        case FanConfigResult_BadCurve:      return "invalid curve";
+        case FanConfigResult_NoCurve:       return "no curve";
+        case FanConfigResult_BadProfile:    return "invalid profile or rule";
+    }
+    return "unknown";
+}
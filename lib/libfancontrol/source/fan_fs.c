@@ -0,0 +1,168 @@
+#include <string.h>
+#include "fan_fs.h"
+
+#define FAN_FS_NOT_MOUNTED  MAKERESULT(Module_Libnx, LibnxError_NotInitialized)
+
+static FsFileSystem g_fanFs;
+static bool         g_fanFsOpen;
+static Mutex        g_fanFsMutex;
+
+static FsFileSystem *FanFsGet(void)
+{
+    mutexLock(&g_fanFsMutex);
+    if (!g_fanFsOpen && R_SUCCEEDED(fsOpenSdCardFileSystem(&g_fanFs)))
+        g_fanFsOpen = true;
+    mutexUnlock(&g_fanFsMutex);
+    return g_fanFsOpen ? &g_fanFs : NULL;
+}
+
+void FanFsClose(void)
+{
+    mutexLock(&g_fanFsMutex);
+    if (g_fanFsOpen)
+        fsFsClose(&g_fanFs);
+    g_fanFsOpen = false;
+    mutexUnlock(&g_fanFsMutex);
+}
+
+bool FanFsExists(const char *path)
+{
+    FsFileSystem *fs = FanFsGet();
+    FsDirEntryType type;
+
+    return fs != NULL && R_SUCCEEDED(fsFsGetEntryType(fs, path, &type));
+}
+
+Result FanFsCreateDir(const char *path)
+{
+    FsFileSystem *fs = FanFsGet();
+    char buf[FS_MAX_PATH];
+    size_t len = strlen(path);
+    Result rs = 0;
+
+    if (fs == NULL)
+        return FAN_FS_NOT_MOUNTED;
+    if (len >= sizeof(buf))
+        len = sizeof(buf) - 1;
+    memcpy(buf, path, len);
+    buf[len] = '\0';
+
+    /* Every prefix ending at a '/' or the end, skipping the root. */
+    for (size_t i = 1; i <= len; i++)
+    {
+        if (buf[i] != '/' && buf[i] != '\0')
+            continue;
+
+        FsDirEntryType type;
+        char saved = buf[i];
+        buf[i] = '\0';
+        if (R_FAILED(fsFsGetEntryType(fs, buf, &type)))
+            rs = fsFsCreateDirectory(fs, buf);
+        buf[i] = saved;
+    }
+    return rs;
+}
+
+Result FanFsStat(const char *path, u64 *size_out, u64 *modified_out)
+{
+    FsFileSystem *fs = FanFsGet();
+    FsTimeStampRaw stamp;
+    FsFile file;
+    s64 size = 0;
+
+    if (fs == NULL)
+        return FAN_FS_NOT_MOUNTED;
+
+    Result rs = fsFsOpenFile(fs, path, FsOpenMode_Read, &file);
+    if (R_FAILED(rs))
+        return rs;
+    rs = fsFileGetSize(&file, &size);
+    fsFileClose(&file);
+    if (R_FAILED(rs))
+        return rs;
+
+    *size_out     = (u64)size;
+    *modified_out = R_SUCCEEDED(fsFsGetFileTimeStampRaw(fs, path, &stamp)) && stamp.is_valid
+                  ? stamp.modified : 0;
+    return 0;
+}
+
+/* ── Whole-file I/O ───────────────────────────────────────────────── */
+
+Result FanFsRead(const char *path, void *buf, size_t size, size_t *read_out)
+{
+    FsFileSystem *fs = FanFsGet();
+    FsFile file;
+    u64 read = 0;
+
+    *read_out = 0;
+    if (fs == NULL)
+        return FAN_FS_NOT_MOUNTED;
+
+    Result rs = fsFsOpenFile(fs, path, FsOpenMode_Read, &file);
+    if (R_FAILED(rs))
+        return rs;
+    rs = fsFileRead(&file, 0, buf, size, FsReadOption_None, &read);
+    fsFileClose(&file);
+
+    *read_out = (size_t)read;
+    return rs;
+}
+
+/* Opens path for writing, creating it first if it doesn't exist. */
+static Result FanFsOpenForWrite(FsFileSystem *fs, const char *path, FsFile *file)
+{
+    Result rs = fsFsOpenFile(fs, path, FsOpenMode_Write | FsOpenMode_Append, file);
+    if (R_FAILED(rs) && R_SUCCEEDED(fsFsCreateFile(fs, path, 0, 0)))
+        rs = fsFsOpenFile(fs, path, FsOpenMode_Write | FsOpenMode_Append, file);
+    return rs;
+}
+
+Result FanFsWrite(const char *path, const void *buf, size_t size)
+{
+    FsFileSystem *fs = FanFsGet();
+    FsFile file;
+
+    if (fs == NULL)
+        return FAN_FS_NOT_MOUNTED;
+
+    Result rs = FanFsOpenForWrite(fs, path, &file);
+    if (R_FAILED(rs))
+        return rs;
+    rs = fsFileSetSize(&file, 0);
+    if (R_SUCCEEDED(rs))
+        rs = fsFileWrite(&file, 0, buf, size, FsWriteOption_Flush);
+    fsFileClose(&file);
+    return rs;
+}
+
+Result FanFsAppend(const char *path, const void *buf, size_t size)
+{
+    FsFileSystem *fs = FanFsGet();
+    FsFile file;
+    s64 offset = 0;
+
+    if (fs == NULL)
+        return FAN_FS_NOT_MOUNTED;
+
+    Result rs = FanFsOpenForWrite(fs, path, &file);
+    if (R_FAILED(rs))
+        return rs;
+    rs = fsFileGetSize(&file, &offset);
+    if (R_SUCCEEDED(rs))
+        rs = fsFileWrite(&file, offset, buf, size, FsWriteOption_Flush);
+    fsFileClose(&file);
+    return rs;
+}
+
+Result FanFsRemove(const char *path)
+{
+    FsFileSystem *fs = FanFsGet();
+    return fs != NULL ? fsFsDeleteFile(fs, path) : FAN_FS_NOT_MOUNTED;
+}
+
+Result FanFsRename(const char *from, const char *to)
+{
+    FsFileSystem *fs = FanFsGet();
+    return fs != NULL ? fsFsRenameFile(fs, from, to) : FAN_FS_NOT_MOUNTED;
+}
@@ -0,0 +1,90 @@
+#include <string.h>
+#include "fan_ipc.h"
+#include "fan_config.h"
+
+/* ── Dispatch ─────────────────────────────────────────────────────── */
+
+Result FanIpcDispatch(const FanIpcHandlers *h, u32 cmd,
+                      const void *in, size_t inSize,
+                      void *out, size_t outCap, size_t *outSize,
+                      Handle *outHandle)
+{
+    *outSize   = 0;
+    *outHandle = INVALID_HANDLE;
+
+    switch (cmd)
+    {
+    case FanIpcCmd_GetState:
+    {
+        FanIpcState state;
+
+        if (inSize != 0 || outCap < sizeof(state))
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+
+        memset(&state, 0, sizeof(state));
+        h->getState(h->ctx, &state);
+        memcpy(out, &state, sizeof(state));
+        *outSize = sizeof(state);
+        return 0;
+    }
+
+    case FanIpcCmd_SetTable:
+    {
+        FanIpcTable table;
+
+        if (inSize < FAN_IPC_TABLE_SIZE(0) || inSize > sizeof(table))
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+
+        memcpy(&table, in, inSize);
+        if (table.count > FAN_CURVE_MAX_POINTS || inSize != FAN_IPC_TABLE_SIZE(table.count))
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+        if (table.profile >= FAN_PROFILE_MAX || !FanConfigCurveValid(table.points, table.count))
+            return FAN_IPC_RESULT(FanIpcError_BadTable);
+
+        return h->setTable(h->ctx, table.profile, table.points, table.count);
+    }
+
+    case FanIpcCmd_SetMode:
+    {
+        u32 mode;
+
+        if (inSize != sizeof(mode))
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+
+        memcpy(&mode, in, sizeof(mode));
+        if (mode != FanControlMode_Curve && mode != FanControlMode_Pid)
+            return FAN_IPC_RESULT(FanIpcError_BadMode);
+
+        return h->setMode(h->ctx, mode);
+    }
+
+    case FanIpcCmd_Pause:
+    case FanIpcCmd_Resume:
+        if (inSize != 0)
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+
+        h->setPaused(h->ctx, cmd == FanIpcCmd_Pause);
+        return 0;
+
+    case FanIpcCmd_GetTelemetry:
+    {
+        FanIpcTelemetryInfo info;
+        Handle handle = INVALID_HANDLE;
+
+        if (inSize != 0 || outCap < sizeof(info))
+            return FAN_IPC_RESULT(FanIpcError_BadSize);
+
+        Result rc = h->getTelemetry(h->ctx, &info, &handle);
+        if (R_FAILED(rc))
+            return rc;
+
+        memcpy(out, &info, sizeof(info));
+        *outSize   = sizeof(info);
+        *outHandle = handle;
+        return 0;
+    }
+
+    default:
+        return FAN_IPC_RESULT(FanIpcError_UnknownCommand);
+    }
+}
@@ -0,0 +1,134 @@
+#include <string.h>
+#include "fan_ipc.h"
+
+/* ── Client ───────────────────────────────────────────────────────── */
+
+static Service      g_fanIpcService;
+static bool         g_fanIpcOpen;
+static SharedMemory g_fanTelemetryShm;
+static bool         g_fanTelemetryMapped;
+
+Result FanIpcClientOpen(void)
+{
+    if (g_fanIpcOpen)
+        return 0;
+
+    Result rc = smInitialize();
+    if (R_FAILED(rc))
+        return rc;
+
+    rc = smGetService(&g_fanIpcService, FAN_IPC_SERVICE_NAME);
+    smExit();
+
+    g_fanIpcOpen = R_SUCCEEDED(rc);
+    return rc;
+}
+
+void FanIpcClientClose(void)
+{
+    if (!g_fanIpcOpen)
+        return;
+
+    if (g_fanTelemetryMapped)
+    {
+        shmemClose(&g_fanTelemetryShm);
+        g_fanTelemetryMapped = false;
+    }
+
+    serviceClose(&g_fanIpcService);
+    g_fanIpcOpen = false;
+}
+
+bool FanIpcClientIsOpen(void)
+{
+    return g_fanIpcOpen;
+}
+
+Result FanIpcGetState(FanIpcState *out)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    return serviceDispatchOut(&g_fanIpcService, FanIpcCmd_GetState, *out);
+}
+
+Result FanIpcSetTable(u32 profile, const TemperaturePoint *tbl, size_t count)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+    if (count > FAN_CURVE_MAX_POINTS)
+        return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+
+    /* Up to 520 bytes, too much for the inline data words. */
+    FanIpcTable table;
+    memset(&table, 0, sizeof(table));
+    table.count   = count;
+    table.profile = profile;
+    memcpy(table.points, tbl, count * sizeof(TemperaturePoint));
+
+    return serviceDispatch(&g_fanIpcService, FanIpcCmd_SetTable,
+        .buffer_attrs = { SfBufferAttr_HipcMapAlias | SfBufferAttr_In },
+        .buffers      = { { &table, FAN_IPC_TABLE_SIZE(count) } },
+    );
+}
+
+Result FanIpcSetMode(u32 mode)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    return serviceDispatchIn(&g_fanIpcService, FanIpcCmd_SetMode, mode);
+}
+
+Result FanIpcPause(void)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    return serviceDispatch(&g_fanIpcService, FanIpcCmd_Pause);
+}
+
+Result FanIpcResume(void)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    return serviceDispatch(&g_fanIpcService, FanIpcCmd_Resume);
+}
+
+Result FanIpcGetTelemetry(const FanTelemetryRing **ring_out)
+{
+    if (!g_fanIpcOpen)
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    if (!g_fanTelemetryMapped)
+    {
+        FanIpcTelemetryInfo info;
+        Handle handle = INVALID_HANDLE;
+
+        Result rc = serviceDispatchOut(&g_fanIpcService, FanIpcCmd_GetTelemetry, info,
+            .out_handle_attrs = { SfOutHandleAttr_HipcCopy },
+            .out_handles = &handle,
+        );
+        if (R_FAILED(rc))
+            return rc;
+
+        shmemLoadRemote(&g_fanTelemetryShm, handle, info.size, Perm_R);
+        rc = shmemMap(&g_fanTelemetryShm);
+        if (R_FAILED(rc))
+        {
+            shmemClose(&g_fanTelemetryShm);
+            return rc;
+        }
+
+        if (!FanTelemetryRingValid(shmemGetAddr(&g_fanTelemetryShm)))
+        {
+            shmemClose(&g_fanTelemetryShm);
+            return FAN_IPC_RESULT(FanIpcError_Unavailable);
+        }
+        g_fanTelemetryMapped = true;
+    }
+
+    *ring_out = shmemGetAddr(&g_fanTelemetryShm);
+    return 0;
+}
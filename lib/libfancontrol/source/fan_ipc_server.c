@@ -0,0 +1,212 @@
+#include <string.h>
+#include "fan_ipc.h"
+
+/*
+ * Minimal CMIF server on top of raw HIPC: one named port, up to
+ * FAN_IPC_MAX_SESSIONS sessions, inline data plus at most one map-alias In
+ * buffer per request. Requests are handled synchronously on the thread
+ * that calls FanIpcServerProcess.
+ */
+
+#define FAN_IPC_MAX_PAYLOAD  0x100
+#define FAN_IPC_MAX_BUFFER   sizeof(FanIpcTable)
+
+/* ── Sessions ─────────────────────────────────────────────────────── */
+
+static void FanIpcServerAddSession(FanIpcServer *server, Handle session)
+{
+    if (server->count >= (s32)(sizeof(server->handles) / sizeof(server->handles[0])))
+    {
+        svcCloseHandle(session);
+        return;
+    }
+    server->handles[server->count++] = session;
+}
+
+static void FanIpcServerRemoveSession(FanIpcServer *server, s32 index)
+{
+    svcCloseHandle(server->handles[index]);
+    server->handles[index] = server->handles[--server->count];
+}
+
+Result FanIpcServerOpen(FanIpcServer *server)
+{
+    memset(server, 0, sizeof(*server));
+    server->name = smEncodeName(FAN_IPC_SERVICE_NAME);
+
+    Result rc = smInitialize();
+    if (R_FAILED(rc))
+        return rc;
+
+    rc = smRegisterService(&server->handles[0], server->name, false, FAN_IPC_MAX_SESSIONS);
+    smExit();
+
+    if (R_SUCCEEDED(rc))
+        server->count = 1;
+    return rc;
+}
+
+void FanIpcServerClose(FanIpcServer *server)
+{
+    if (server->count == 0)
+        return;
+
+    while (server->count > 1)
+        FanIpcServerRemoveSession(server, server->count - 1);
+
+    svcCloseHandle(server->handles[0]);
+    server->count = 0;
+
+    if (R_SUCCEEDED(smInitialize()))
+    {
+        smUnregisterService(server->name);
+        smExit();
+    }
+}
+
+/* ── Messages ─────────────────────────────────────────────────────── */
+
+static void FanIpcServerPrepareReply(Result result, const void *data, size_t size,
+                                     Handle copyHandle)
+{
+    void *base = armGetTls();
+
+    HipcRequest hipc = hipcMakeRequestInline(base,
+        .type             = CmifCommandType_Request,
+        .num_data_words   = (sizeof(CmifOutHeader) + 0x10 + size + 3) / 4,
+        .num_copy_handles = copyHandle != INVALID_HANDLE ? 1 : 0,
+    );
+
+    if (copyHandle != INVALID_HANDLE)
+        hipc.copy_handles[0] = copyHandle;
+
+    CmifOutHeader *header = cmifGetAlignedDataStart(hipc.data_words, base);
+    header->magic   = CMIF_OUT_HEADER_MAGIC;
+    header->version = 0;
+    header->result  = result;
+    header->token   = 0;
+
+    if (size > 0)
+        memcpy(header + 1, data, size);
+}
+
+/* Handles the message sitting in TLS; returns false if the session should
+ * be closed instead of replied to. */
+static bool FanIpcServerHandleMessage(const FanIpcHandlers *h)
+{
+    void *base = armGetTls();
+    HipcParsedRequest req = hipcParseRequest(base);
+
+    if (req.meta.type == CmifCommandType_Close)
+        return false;
+
+    if (req.meta.type != CmifCommandType_Request)
+    {
+        FanIpcServerPrepareReply(FAN_IPC_RESULT(FanIpcError_UnknownCommand), NULL, 0, INVALID_HANDLE);
+        return true;
+    }
+
+    CmifInHeader *header = cmifGetAlignedDataStart(req.data.data_words, base);
+    size_t words = req.meta.num_data_words * 4;
+
+    if (words < sizeof(CmifInHeader) + 0x10 || header->magic != CMIF_IN_HEADER_MAGIC)
+    {
+        FanIpcServerPrepareReply(FAN_IPC_RESULT(FanIpcError_BadSize), NULL, 0, INVALID_HANDLE);
+        return true;
+    }
+
+    /* Copy out of TLS first, the reply is built in the same buffer. A
+     * request with an In buffer carries its payload there instead. */
+    u8 in[FAN_IPC_MAX_BUFFER];
+    u8 out[FAN_IPC_MAX_PAYLOAD];
+    size_t inSize = words - sizeof(CmifInHeader) - 0x10;
+    const void *src = header + 1;
+    size_t outSize = 0;
+    Handle handle = INVALID_HANDLE;
+    Result rc;
+
+    bool buffered = req.meta.num_send_buffers == 1 && inSize == 0;
+    if (buffered)
+    {
+        src    = hipcGetBufferAddress(&req.data.send_buffers[0]);
+        inSize = hipcGetBufferSize(&req.data.send_buffers[0]);
+    }
+
+    if (req.meta.num_send_buffers != (buffered ? 1 : 0) ||
+        req.meta.num_recv_buffers != 0 || req.meta.num_exch_buffers != 0 ||
+        inSize > (buffered ? FAN_IPC_MAX_BUFFER : FAN_IPC_MAX_PAYLOAD))
+    {
+        rc = FAN_IPC_RESULT(FanIpcError_BadSize);
+    }
+    else
+    {
+        memcpy(in, src, inSize);
+        rc = FanIpcDispatch(h, header->command_id, in, inSize, out, sizeof(out),
+                            &outSize, &handle);
+    }
+
+    FanIpcServerPrepareReply(rc, out, R_SUCCEEDED(rc) ? outSize : 0, handle);
+    return true;
+}
+
+static void FanIpcServerServeSession(FanIpcServer *server, s32 index, const FanIpcHandlers *h)
+{
+    Handle session = server->handles[index];
+    s32 unused;
+
+    Result rc = svcReplyAndReceive(&unused, &session, 1, INVALID_HANDLE, 0);
+    if (R_FAILED(rc))
+    {
+        /* Client went away (or sent garbage); drop the session. */
+        FanIpcServerRemoveSession(server, index);
+        return;
+    }
+
+    if (!FanIpcServerHandleMessage(h))
+    {
+        FanIpcServerRemoveSession(server, index);
+        return;
+    }
+
+    /* Reply only: with no handles to wait on this returns TimedOut. */
+    rc = svcReplyAndReceive(&unused, NULL, 0, session, 0);
+    if (R_FAILED(rc) && R_VALUE(rc) != KERNELRESULT(TimedOut))
+        FanIpcServerRemoveSession(server, index);
+}
+
+Result FanIpcServerProcess(FanIpcServer *server, const FanIpcHandlers *h,
+                           const Handle *extra, s32 extraCount, u64 timeoutNs,
+                           s32 *extraIndex)
+{
+    Handle handles[1 + FAN_IPC_MAX_SESSIONS + FAN_IPC_MAX_EXTRA_HANDLES];
+    s32 count = server->count;
+    s32 index = -1;
+
+    *extraIndex = -1;
+    if (extraCount > FAN_IPC_MAX_EXTRA_HANDLES)
+        extraCount = FAN_IPC_MAX_EXTRA_HANDLES;
+
+    memcpy(handles, server->handles, count * sizeof(Handle));
+    memcpy(handles + count, extra, extraCount * sizeof(Handle));
+    count += extraCount;
+
+    Result rc = svcWaitSynchronization(&index, handles, count, timeoutNs);
+    if (R_FAILED(rc))
+        return rc;
+
+    if (index >= server->count)
+    {
+        *extraIndex = index - server->count;
+    }
+    else if (index == 0)
+    {
+        Handle session;
+        if (R_SUCCEEDED(svcAcceptSession(&session, server->handles[0])))
+            FanIpcServerAddSession(server, session);
+    }
+    else
+    {
+        FanIpcServerServeSession(server, index, h);
+    }
+    return 0;
+}
@@ -1,9 +1,14 @@
 #include "fancontrol.h"
-#include "tmp451.h"
+#include "fan_fs.h"
+#include "i2c.h"
+#include "power_state.h"
+#include "log_ring.h"
+#include "thermal_trace.h"
 #include <stdatomic.h>
+#include <stdarg.h>
 #include <math.h>
 
-/* ── Fan curve table (10 presets) ─────────────────────────────────── */
+/* ── Default fan curve ────────────────────────────────────────────── */
 
 const TemperaturePoint defaultTable[] =
 {
@@ -19,221 +24,948 @@ const TemperaturePoint defaultTable[] =
     { .temperature_c = 70,  .fanLevel_f = 1.00f },
 };
 
-#define TABLE_ENTRIES  (sizeof(defaultTable) / sizeof(defaultTable[0]))
+#define DEFAULT_TABLE_ENTRIES  (sizeof(defaultTable) / sizeof(defaultTable[0]))
+
+const FanControllerSettings defaultSettings = FAN_CONTROLLER_SETTINGS_DEFAULTS;
 
 /* ── State ────────────────────────────────────────────────────────── */
 
-TemperaturePoint     *fanControllerTable;
 Thread                FanControllerThread;
 static atomic_bool    fanControllerThreadExit = false;
+static const FanSupervisorConfig fanSupervisorConfig = FAN_SUPERVISOR_DEFAULTS;
+static FanControllerSettings fanControllerSettings = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+static FanControllerStats fanControllerStats;
+static Mutex              fanControllerStatsMutex;
 
-/* ── Tuning constants ─────────────────────────────────────────────── */
+/* Settings from SetFanControllerSettings, taken over by the control thread
+ * at the start of its next iteration. */
+static FanControllerSettings fanSettingsUpdate = FAN_CONTROLLER_SETTINGS_DEFAULTS;
+static atomic_bool        fanSettingsPending = false;
+static Mutex              fanSettingsMutex;
 
-#define POLL_NORMAL_NS     50000000ULL   /*  50 ms – normal rate          */
-#define POLL_FAST_NS       25000000ULL   /*  25 ms – when temp is high    */
-#define TEMP_FAST_THRESH        55.0f    /* switch to fast poll above this */
-#define TEMP_READ_RETRIES         3
+/* Launch tick from MarkFanControllerLaunch, for the time to the first
+ * fan write. */
+static u64                fanLaunchTick;
 
-/* ── CreateDir ────────────────────────────────────────────────────── */
+/* Telemetry ring, shared read-only with fanctl clients. NULL if the
+ * shared memory block couldn't be created. */
+#define TELEMETRY_SHM_SIZE  ((sizeof(FanTelemetryRing) + 0xFFF) & ~(size_t)0xFFF)
 
-void CreateDir(char *dir)
-{
-    char buf[PATH_MAX];
-    size_t len = strlen(dir);
+static SharedMemory       fanTelemetryShm;
+static FanTelemetryRing  *fanTelemetry;
 
-    if (len == 0)
-        return;
-    if (len >= PATH_MAX)
-        len = PATH_MAX - 1;
+/* Requests from the fanctl service, applied by the control thread. */
+static _Atomic u32        fanRequestedMode;
+static atomic_bool        fanControllerPaused = false;
+
+/*
+ * The control thread reads the curve through fanActiveCurve. Every profile
+ * of the loaded config is compiled up front into one of two curve sets, so
+ * a profile switch is just a pointer store into the active set. A reload
+ * builds the other set and swaps the pointer over to it; the old set is
+ * only reused once fanLoopEpoch shows that the iteration which might still
+ * have been reading it has finished.
+ */
+static FanCurve                 fanCurveSets[2][FAN_PROFILE_MAX];
+static u32                      fanCurveSet;
+static _Atomic(const FanCurve *) fanActiveCurve;
+static _Atomic u64              fanLoopEpoch;
+static u64                      fanCurveRetireEpoch;
+
+/* Config the active set was built from, and the profile picked from it.
+ * Main thread only. */
+static FanConfig                fanConfig;
+static FanTitleIndex            fanTitleIndex;
+static FanPowerState            fanPowerState;
+static size_t                   fanActiveProfile;
+
+/* Foreground application, 0 when none is running. Main thread only. */
+static u64                      fanAppPid;
+static u64                      fanAppTitleId;
+
+#define CONFIG_POLL_NS   1000000000ULL
+#define PAUSE_POLL_NS    100000000ULL
+
+/* ── Logging ──────────────────────────────────────────────────────── */
 
-    memcpy(buf, dir, len);
-    buf[len] = '\0';
+/* Until InitLog has rotated the previous boot's log, lines stay queued.
+ * Only the sysmodule calls it; the overlay also reads the config through
+ * this library and must not rotate the running sysmodule's log. */
+static bool            fanLogReady;
 
-    for (size_t i = 1; i <= len; i++)
+static void InitLog(void)
+{
+    if (!FanFsExists(LOG_DIR))
+        FanFsCreateDir(LOG_DIR);
+
+    /* Keep the previous boot's log for post-mortems. */
+    if (FanFsExists(LOG_FILE))
     {
-        if (buf[i] == '/' || buf[i] == '\0')
-        {
-            char saved = buf[i];
-            buf[i] = '\0';
-            if (access(buf, F_OK) == -1)
-                mkdir(buf, 0777);
-            buf[i] = saved;
-        }
+        FanFsRemove(LOG_FILE_PREVIOUS);
+        FanFsRename(LOG_FILE, LOG_FILE_PREVIOUS);
     }
+    fanLogReady = true;
 }
 
-/* ── Logging ──────────────────────────────────────────────────────── */
+/* Lines wait in fanLogRing until FlushLog writes them out, so logging from
+ * the control thread never waits for the SD card. fanLogFlushMutex only
+ * serialises the consumer side and fanLogChunk; pushing takes no lock.
+ * Log lines carry no floating point: newlib formats those through heap
+ * allocated bignums. */
+#define LOG_CHUNK_SIZE      2048
+#define LOG_FILE_LINE_MAX   (sizeof("[123456.789] W \n") - 1 + FAN_LOG_LINE_MAX)
+
+_Static_assert(LOG_CHUNK_SIZE >= LOG_FILE_LINE_MAX, "a log chunk must hold the longest line");
 
-void InitLog(void)
+static FanLogRing      fanLogRing;
+static Mutex           fanLogFlushMutex;
+static char            fanLogChunk[LOG_CHUNK_SIZE];
+static size_t          fanLogFill;
+static u64             fanLogDroppedReported;
+static _Atomic u32     fanLogLevel = FanLogLevel_Info;
+
+/* Set from settings.dat by LoadFanControllerConfig. */
+static void SetLogLevel(FanLogLevel level)
 {
-    if (access(LOG_DIR, F_OK) == -1)
-        CreateDir(LOG_DIR);
+    atomic_store(&fanLogLevel, level);
+}
 
-    if (access(LOG_FILE, F_OK) != -1)
-        remove(LOG_FILE);
+void WriteLog(FanLogLevel level, const char *fmt, ...)
+{
+    char buf[FAN_LOG_LINE_MAX];
+    va_list args;
+
+    if (level < atomic_load_explicit(&fanLogLevel, memory_order_relaxed))
+        return;
+
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    FanLogPush(&fanLogRing, level, armTicksToNs(armGetSystemTick()), buf);
+}
+
+/* Caller holds fanLogFlushMutex. */
+static void AppendLogLine(u64 timestampNs, char level, const char *text)
+{
+    if (fanLogFill + LOG_FILE_LINE_MAX > sizeof(fanLogChunk))
+    {
+        FanFsAppend(LOG_FILE, fanLogChunk, fanLogFill);
+        fanLogFill = 0;
+    }
+
+    u64 ms = timestampNs / 1000000;
+    int n = snprintf(fanLogChunk + fanLogFill, sizeof(fanLogChunk) - fanLogFill,
+                     "[%6lu.%03lu] %c %s\n", ms / 1000, ms % 1000, level, text);
+    if (n > 0)
+        fanLogFill += (size_t)n < sizeof(fanLogChunk) - fanLogFill ? (size_t)n
+                                                                   : sizeof(fanLogChunk) - fanLogFill - 1;
 }
 
-void WriteLog(const char *buffer)
+void FlushLog(void)
 {
-    FILE *log = fopen(LOG_FILE, "a");
-    if (log == NULL)
+    FanLogLine line;
+    char text[FAN_LOG_LINE_MAX];
+
+    if (!fanLogReady)
         return;
-    fprintf(log, "%s\n", buffer);
-    fclose(log);
+
+    mutexLock(&fanLogFlushMutex);
+    while (FanLogPop(&fanLogRing, &line))
+        AppendLogLine(line.timestampNs, FanLogLevelChar(line.level), line.text);
+
+    u64 dropped = atomic_load(&fanLogRing.dropped);
+    if (dropped != fanLogDroppedReported)
+    {
+        snprintf(text, sizeof(text), "%lu log lines dropped", dropped - fanLogDroppedReported);
+        AppendLogLine(armTicksToNs(armGetSystemTick()), 'W', text);
+        fanLogDroppedReported = dropped;
+    }
+
+    if (fanLogFill > 0)
+        FanFsAppend(LOG_FILE, fanLogChunk, fanLogFill);
+    fanLogFill = 0;
+    mutexUnlock(&fanLogFlushMutex);
 }
 
 /* ── Config persistence ───────────────────────────────────────────── */
 
-void WriteConfigFile(const TemperaturePoint *table)
-{
-    const TemperaturePoint *src = table ? table : defaultTable;
+/* The config functions keep their buffers in static storage: a FanConfig
+ * is several KiB and the sysmodule's main thread has a 12 KiB stack. They
+ * are only called from one thread. */
+static u8 fanConfigBuffer[FAN_CONFIG_MAX_SIZE + 1];
 
-    if (access(CONFIG_DIR, F_OK) == -1)
-        CreateDir(CONFIG_DIR);
+void WriteConfigFile(const FanConfig *config)
+{
+    static FanConfig defaults;
+    u8 *buf = fanConfigBuffer;
 
-    FILE *config = fopen(CONFIG_FILE, "w");
     if (config == NULL)
     {
-        WriteLog("WriteConfigFile: fopen failed");
+        FanConfigInitSingle(&defaults, defaultTable, DEFAULT_TABLE_ENTRIES);
+        config = &defaults;
+    }
+
+    size_t size = FanConfigSerialize(config, buf, FAN_CONFIG_MAX_SIZE);
+    if (size == 0)
+    {
+        WriteLog(FanLogLevel_Error, "WriteConfigFile: invalid config");
         return;
     }
-    fwrite(src, 1, TABLE_SIZE, config);
-    fclose(config);
+
+    if (!FanFsExists(CONFIG_DIR))
+        FanFsCreateDir(CONFIG_DIR);
+
+    Result rs = FanFsWrite(CONFIG_FILE, buf, size);
+    if (R_FAILED(rs))
+        WriteLog(FanLogLevel_Error, "WriteConfigFile: write failed 0x%X", rs);
 }
 
-void ReadConfigFile(TemperaturePoint **table_out)
+/* The reload poll re-reads a broken file every second; only log it once. */
+static char fanConfigProblem[96];
+
+static void LogConfigProblem(const char *msg)
 {
-    InitLog();
+    if (strcmp(msg, fanConfigProblem) == 0)
+        return;
+    snprintf(fanConfigProblem, sizeof(fanConfigProblem), "%s", msg);
+    WriteLog(FanLogLevel_Warn, "%s", msg);
+}
 
-    *table_out = malloc(sizeof(defaultTable));
-    if (*table_out == NULL)
+/* Reads and parses config.dat in one go, rewriting files in the old raw
+ * format. Returns false (leaving config untouched) on failure. */
+static bool LoadConfig(FanConfig *config)
+{
+    u8 *buf = fanConfigBuffer;
+    char msg[sizeof(fanConfigProblem)];
+
+    size_t size;
+    if (R_FAILED(FanFsRead(CONFIG_FILE, buf, sizeof(fanConfigBuffer), &size)))
+        return false;
+    if (size > FAN_CONFIG_MAX_SIZE)
     {
-        WriteLog("ReadConfigFile: malloc failed");
-        diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+        LogConfigProblem("config.dat: file too large");
+        return false;
+    }
+
+    FanConfigResult result = FanConfigParse(buf, size, config);
+    if (result != FanConfigResult_Ok && result != FanConfigResult_Legacy)
+    {
+        snprintf(msg, sizeof(msg), "config.dat: %s", FanConfigResultString(result));
+        LogConfigProblem(msg);
+        return false;
+    }
+
+    fanConfigProblem[0] = '\0';
+    if (result == FanConfigResult_Legacy)
+    {
+        WriteConfigFile(config);
+        WriteLog(FanLogLevel_Info, "config.dat migrated to the versioned format");
     }
-    memcpy(*table_out, defaultTable, sizeof(defaultTable));
+    return true;
+}
+
+void ReadConfigFile(FanConfig *config_out)
+{
+    FanConfigInitSingle(config_out, defaultTable, DEFAULT_TABLE_ENTRIES);
 
-    if (access(CONFIG_DIR, F_OK) == -1)
+    if (!FanFsExists(CONFIG_DIR))
     {
-        CreateDir(CONFIG_DIR);
+        FanFsCreateDir(CONFIG_DIR);
         WriteConfigFile(NULL);
-        WriteLog("Missing config dir");
+        WriteLog(FanLogLevel_Info, "Missing config dir");
         return;
     }
 
-    if (access(CONFIG_FILE, F_OK) == -1)
+    if (!FanFsExists(CONFIG_FILE))
     {
         WriteConfigFile(NULL);
-        WriteLog("Missing config file");
+        WriteLog(FanLogLevel_Info, "Missing config file");
         return;
     }
 
-    FILE *config = fopen(CONFIG_FILE, "r");
-    if (config == NULL)
+    if (!LoadConfig(config_out))
     {
-        WriteLog("ReadConfigFile: fopen failed, using defaults");
+        WriteLog(FanLogLevel_Warn, "ReadConfigFile: read failed, using defaults");
         return;
     }
+    WriteLog(FanLogLevel_Info, "config file exist");
+}
+
+/* ── Settings persistence ─────────────────────────────────────────── */
+
+/* Main thread only, like the config buffers. */
+static u8 fanSettingsBuffer[FAN_SETTINGS_MAX_SIZE + 1];
 
-    if (fread(*table_out, 1, TABLE_SIZE, config) != TABLE_SIZE)
+void WriteSettingsFile(const FanControllerSettings *settings)
+{
+    const FanControllerSettings *src = settings ? settings : &defaultSettings;
+
+    size_t size = FanSettingsSerialize(src, fanSettingsBuffer, FAN_SETTINGS_MAX_SIZE);
+    if (size == 0)
     {
-        WriteLog("ReadConfigFile: short read, using defaults");
-        memcpy(*table_out, defaultTable, sizeof(defaultTable));
+        WriteLog(FanLogLevel_Error, "WriteSettingsFile: invalid settings");
+        return;
     }
-    fclose(config);
-    WriteLog("config file exist");
+
+    if (!FanFsExists(CONFIG_DIR))
+        FanFsCreateDir(CONFIG_DIR);
+
+    Result rs = FanFsWrite(SETTINGS_FILE, fanSettingsBuffer, size);
+    if (R_FAILED(rs))
+        WriteLog(FanLogLevel_Error, "WriteSettingsFile: write failed 0x%X", rs);
+}
+
+void ReadSettingsFile(FanControllerSettings *settings_out)
+{
+    *settings_out = defaultSettings;
+
+    size_t size;
+    if (R_FAILED(FanFsRead(SETTINGS_FILE, fanSettingsBuffer, sizeof(fanSettingsBuffer), &size)))
+        return;
+
+    FanConfigResult result = size > FAN_SETTINGS_MAX_SIZE ? FanConfigResult_BadRecord
+                           : FanSettingsParse(fanSettingsBuffer, size, settings_out);
+    if (result != FanConfigResult_Ok)
+        WriteLog(FanLogLevel_Warn, "settings.dat: %s, using defaults", FanConfigResultString(result));
+}
+
+/* ── Fan controller ───────────────────────────────────────────────── */
+
+void SetFanControllerSettings(const FanControllerSettings *settings)
+{
+    mutexLock(&fanSettingsMutex);
+    fanSettingsUpdate = *settings;
+    atomic_store(&fanRequestedMode, settings->mode);
+    atomic_store(&fanSettingsPending, true);
+    mutexUnlock(&fanSettingsMutex);
+}
+
+/* Control thread. The filter, PID and model start over from the next
+ * reading, but the write gate keeps the level the fan is at, so the new
+ * settings ramp in like any other target change. */
+static void TakeFanControllerSettings(FanLoop *loop)
+{
+    mutexLock(&fanSettingsMutex);
+    fanControllerSettings = fanSettingsUpdate;
+    atomic_store(&fanSettingsPending, false);
+    mutexUnlock(&fanSettingsMutex);
+
+    FanFilterInit(&loop->filter);
+    FanPidInit(&loop->pid);
+    FanPredictorInit(&loop->predictor);
+}
+
+void MarkFanControllerLaunch(void)
+{
+    fanLaunchTick = armGetSystemTick();
+}
+
+void GetFanControllerStats(FanControllerStats *out)
+{
+    mutexLock(&fanControllerStatsMutex);
+    *out = fanControllerStats;
+    mutexUnlock(&fanControllerStatsMutex);
+}
+
+static void PublishFanControllerStats(const FanLoop *loop, const FanSupervisor *sup, u64 interval)
+{
+    mutexLock(&fanControllerStatsMutex);
+    fanControllerStats.tempC            = loop->sample.socC;
+    fanControllerStats.pcbC             = loop->sample.pcbC;
+    fanControllerStats.battC            = loop->sample.battC;
+    fanControllerStats.controlC         = loop->controlC;
+    fanControllerStats.curveC           = loop->curveC;
+    fanControllerStats.modelTauS        = loop->predictor.tauS;
+    fanControllerStats.modelGainC       = loop->predictor.gainC;
+    fanControllerStats.targetLevel      = loop->target;
+    fanControllerStats.appliedLevel     = loop->gate.applied;
+    fanControllerStats.writesIssued     = loop->gate.writesIssued;
+    fanControllerStats.writesSuppressed = loop->gate.writesSuppressed;
+    fanControllerStats.lastIntervalNs   = interval;
+    fanControllerStats.wakeupsPerMinute = loop->sched.wakeupsPerMinute;
+    fanControllerStats.readFailures     = loop->readFailures;
+    fanControllerStats.supervisorState  = sup->state;
+    fanControllerStats.handbacks        = sup->handbacks;
+    fanControllerStats.writeFaults      = sup->faults;
+    fanControllerStats.recoveries       = sup->recoveries;
+    fanControllerStats.lastRecoveryNs   = sup->lastRecoveryNs;
+    fanControllerStats.maxRecoveryNs    = sup->maxRecoveryNs;
+    fanControllerStats.pwmLevel         = loop->pwmLevel;
+    fanControllerStats.dutyMismatches   = loop->dutyMismatches;
+    fanControllerStats.reasserts        = loop->reasserts;
+    mutexUnlock(&fanControllerStatsMutex);
+}
+
+static void PublishFanTelemetry(const FanLoop *loop, const FanSupervisor *sup,
+                                u64 latencyNs, Result rs)
+{
+    if (fanTelemetry == NULL)
+        return;
+
+    FanTelemetrySample sample =
+    {
+        .timestampNs   = loop->lastNs,
+        .socC          = loop->sample.socC,
+        .pcbC          = loop->sample.pcbC,
+        .targetLevel   = loop->target,
+        .dutyLevel     = loop->gate.applied,
+        .loopLatencyNs = latencyNs > UINT32_MAX ? UINT32_MAX : (u32)latencyNs,
+        .result        = rs,
+        .battC         = loop->sample.battC,
+        .controlC      = loop->controlC,
+        .flags         = (loop->readFailed ? FAN_TELEMETRY_READ_FAILED : 0) |
+                         (loop->dutyMismatch ? FAN_TELEMETRY_DUTY_MISMATCH : 0) |
+                         ((u32)sup->state << FAN_TELEMETRY_STATE_SHIFT),
+        .faults        = sup->faults > UINT32_MAX ? UINT32_MAX : (u32)sup->faults,
+        .recoveryUs    = sup->lastRecoveryNs / 1000 > UINT32_MAX ? UINT32_MAX
+                                                                 : (u32)(sup->lastRecoveryNs / 1000),
+        .pwmLevel      = loop->pwmLevel,
+    };
+    FanTelemetryPublish(fanTelemetry, &sample);
 }
 
-/* ── Interpolation ────────────────────────────────────────────────── */
+/* ── Thermal trace ────────────────────────────────────────────────── */
 
-static inline float InterpolateFanLevel(const TemperaturePoint *tbl, float tempC)
+/*
+ * The main thread copies each iteration out of the telemetry ring into a
+ * binary trace (thermal_trace.h), so the control thread does no file I/O
+ * for it. Records collect in a chunk that is appended to trace.bin when
+ * it fills up or every TRACE_FLUSH_NS. Each boot, and each time trace.bin
+ * reaches TRACE_FILE_MAX, the files shift down to trace.1.bin ...
+ * trace.<TRACE_FILES - 1>.bin and the oldest is deleted, which caps the
+ * traces at TRACE_FILES * TRACE_FILE_MAX bytes.
+ */
+#define TRACE_FILES         4
+#define TRACE_FILE_MAX      (256 * 1024)
+#define TRACE_CHUNK_SIZE    4096
+#define TRACE_FLUSH_NS      30000000000ULL
+
+static u8             fanTraceChunk[TRACE_CHUNK_SIZE];
+static size_t         fanTraceFill;
+static size_t         fanTraceFileSize;
+static bool           fanTraceNewFile = true;
+static FanTraceCursor fanTraceCursor;
+static u64            fanTraceReadCursor;
+static u64            fanTraceDropped;
+static u64            fanTraceFlushNs;
+
+/* Rotated names are TRACE_FILE_ROTATED with a single-digit index. */
+#define TRACE_PATH_MAX      64
+
+_Static_assert(TRACE_FILES <= 10, "rotated trace names have one digit");
+_Static_assert(sizeof(TRACE_FILE_ROTATED) - sizeof("%d") + 1 < TRACE_PATH_MAX,
+               "rotated trace names must fit TRACE_PATH_MAX");
+_Static_assert(TRACE_CHUNK_SIZE >= FAN_TRACE_HEADER_SIZE + FAN_TRACE_RECORD_MAX,
+               "a trace chunk must hold the header and a record");
+_Static_assert(FAN_TELEMETRY_SLOTS * FAN_SCHEDULER_MIN_INTERVAL_NS >= 2 * CONFIG_POLL_NS,
+               "the telemetry ring must outlast two housekeeping ticks");
+
+static void RotateTraceFiles(void)
+{
+    char from[TRACE_PATH_MAX], to[TRACE_PATH_MAX];
+
+    snprintf(to, sizeof(to), TRACE_FILE_ROTATED, TRACE_FILES - 1);
+    FanFsRemove(to);
+    for (int i = TRACE_FILES - 2; i >= 1; i--)
+    {
+        snprintf(from, sizeof(from), TRACE_FILE_ROTATED, i);
+        FanFsRename(from, to);
+        memcpy(to, from, sizeof(to));
+    }
+    FanFsRename(TRACE_FILE, to);
+}
+
+static void FlushTrace(void)
+{
+    if (fanTraceFill == 0)
+        return;
+
+    FanFsAppend(TRACE_FILE, fanTraceChunk, fanTraceFill);
+    fanTraceFileSize += fanTraceFill;
+    fanTraceFill = 0;
+
+    if (fanTraceFileSize >= TRACE_FILE_MAX)
+        fanTraceNewFile = true;
+}
+
+static void DrainTrace(u64 nowNs)
 {
-    if (tempC <= tbl[0].temperature_c)
-        return tbl[0].fanLevel_f;
+    static FanTelemetrySample batch[16];
+    size_t count;
 
-    for (size_t i = 0; i < TABLE_ENTRIES - 1; i++)
+    if (fanTelemetry == NULL)
+        return;
+
+    u64 dropped = fanTraceDropped;
+    while ((count = FanTelemetryReadSince(fanTelemetry, &fanTraceReadCursor, batch,
+                                          sizeof(batch) / sizeof(batch[0]), &dropped)) > 0)
     {
-        if (tempC <= tbl[i + 1].temperature_c)
+        for (size_t i = 0; i < count; i++)
         {
-            float dT = tbl[i + 1].temperature_c - tbl[i].temperature_c;
-            float dF = tbl[i + 1].fanLevel_f    - tbl[i].fanLevel_f;
-            float t  = (tempC - tbl[i].temperature_c) / dT;
-            return tbl[i].fanLevel_f + dF * t;
+            if (fanTraceFill + FAN_TRACE_RECORD_MAX > sizeof(fanTraceChunk))
+                FlushTrace();
+            if (fanTraceNewFile)
+            {
+                RotateTraceFiles();
+                fanTraceFill = FanTraceBegin(&fanTraceCursor, batch[i].timestampNs, fanTraceChunk);
+                fanTraceFileSize = 0;
+                fanTraceNewFile = false;
+            }
+            fanTraceFill += FanTraceEncode(&fanTraceCursor, &batch[i], fanTraceChunk + fanTraceFill);
         }
     }
 
-    return tbl[TABLE_ENTRIES - 1].fanLevel_f;
+    if (dropped != fanTraceDropped)
+    {
+        WriteLog(FanLogLevel_Warn, "trace: %lu samples lost", dropped - fanTraceDropped);
+        fanTraceDropped = dropped;
+    }
+    if (nowNs - fanTraceFlushNs >= TRACE_FLUSH_NS)
+    {
+        FlushTrace();
+        fanTraceFlushNs = nowNs;
+    }
+}
+
+/* ── Curve hot reload ─────────────────────────────────────────────── */
+
+static void LogFanProfile(void)
+{
+    WriteLog(FanLogLevel_Info, "fan profile: %s", fanConfig.profiles[fanActiveProfile].name);
+}
+
+/* A title rule for the running application wins over the power rules. */
+static size_t SelectFanProfile(void)
+{
+    int title = FanTitleIndexLookup(&fanTitleIndex, fanAppTitleId);
+    return title >= 0 ? (size_t)title : FanProfileSelect(&fanConfig, &fanPowerState);
 }
 
-/* ── Fan controller ───────────────────────────────────────────────── */
+/* Points the control thread at the curve of the profile the current state
+ * selects. Both candidates live in the same curve set, so nothing needs
+ * retiring. */
+static void ApplyFanProfile(void)
+{
+    size_t profile = SelectFanProfile();
+
+    atomic_store(&fanActiveCurve, &fanCurveSets[fanCurveSet][profile]);
+    if (profile != fanActiveProfile)
+    {
+        fanActiveProfile = profile;
+        LogFanProfile();
+    }
+}
 
-void InitFanController(TemperaturePoint *table)
+/* Publishes a new config for the control thread. Called from one thread
+ * only; returns false if the spare set is still in use, try again later. */
+static bool PublishFanConfig(const FanConfig *config)
 {
-    fanControllerTable = table;
+    const FanCurve *active = atomic_load(&fanActiveCurve);
+    u32 spare = fanCurveSet ^ 1;
+
+    if (active != NULL && atomic_load(&fanLoopEpoch) <= fanCurveRetireEpoch)
+        return false;
+
+    for (size_t i = 0; i < config->profileCount; i++)
+        FanCurveBuild(&fanCurveSets[spare][i], config->profiles[i].points, config->profiles[i].count);
+
+    if (config != &fanConfig)
+        fanConfig = *config;
+    FanTitleIndexBuild(&fanTitleIndex, &fanConfig);
+    fanCurveSet = spare;
+    fanActiveProfile = SelectFanProfile();
+    atomic_store(&fanActiveCurve, &fanCurveSets[spare][fanActiveProfile]);
+    fanCurveRetireEpoch = atomic_load(&fanLoopEpoch);
+    return true;
+}
+
+/*
+ * The reload poll only reads config.dat when its size or modification
+ * time has moved. FAT keeps the time in 2 second steps, so a second write
+ * of the same size in the same step looks unchanged; the file is parsed
+ * on a few more polls after every change to catch it. Without a time
+ * stamp every poll parses.
+ */
+#define CONFIG_SETTLE_POLLS  3
+
+static u64 fanConfigFileSize;
+static u64 fanConfigFileModified;
+static u32 fanConfigSettlePolls;
+
+static bool ConfigFileChanged(void)
+{
+    u64 size, modified;
+
+    if (R_FAILED(FanFsStat(CONFIG_FILE, &size, &modified)))
+        return false;
+
+    if (size != fanConfigFileSize || modified != fanConfigFileModified || modified == 0)
+    {
+        fanConfigFileSize     = size;
+        fanConfigFileModified = modified;
+        fanConfigSettlePolls  = CONFIG_SETTLE_POLLS;
+        return true;
+    }
+    if (fanConfigSettlePolls == 0)
+        return false;
+    fanConfigSettlePolls--;
+    return true;
+}
+
+/* Picks up config.dat changes made while the sysmodule is running. */
+static void CheckConfigReload(void)
+{
+    static FanConfig config;
+
+    if (atomic_load(&fanActiveCurve) == NULL || !ConfigFileChanged() || !LoadConfig(&config))
+        return;
+    if (FanConfigEqual(&config, &fanConfig))
+        return;
+
+    if (PublishFanConfig(&config))
+        WriteLog(FanLogLevel_Info, "config.dat changed, fan curve reloaded");
+    else
+        fanConfigSettlePolls = CONFIG_SETTLE_POLLS;     /* spare set busy, retry */
+}
+
+/* Re-reads the power state and switches profile if it selects another one. */
+static void UpdatePowerState(void)
+{
+    FanPowerStateRead(&fanPowerState);
+    ApplyFanProfile();
+}
+
+/*
+ * pm offers no launch notification a sysmodule can take without getting in
+ * the way: the debug hook holds the new process until someone starts it,
+ * and the shell's process events belong to ns. So the application process
+ * ID is checked on the housekeeping tick, one IPC round trip a second, and
+ * the program ID is only fetched when that process changes.
+ */
+static void UpdateForegroundTitle(void)
+{
+    u64 pid = 0;
+    u64 titleId = 0;
+
+    if (R_FAILED(pmdmntGetApplicationProcessId(&pid)))
+        pid = 0;
+    if (pid == fanAppPid)
+        return;
+
+    fanAppPid = pid;
+    if (pid != 0 && R_FAILED(pminfoGetProgramId(&titleId, pid)))
+        titleId = 0;
+    fanAppTitleId = titleId;
+    ApplyFanProfile();
+}
+
+/* psm only signals battery voltage thresholds, so rules on the charge
+ * level are also re-checked on the housekeeping tick. */
+static bool RulesUseBattery(void)
+{
+    for (size_t i = 0; i < fanConfig.ruleCount; i++)
+    {
+        if (fanConfig.rules[i].batteryMax < 100)
+            return true;
+    }
+    return false;
+}
+
+/* ── fanctl service handlers (main thread) ────────────────────────── */
+
+static void FanIpcGetStateHandler(void *ctx, FanIpcState *out)
+{
+    (void)ctx;
+    FanControllerStats stats;
+    GetFanControllerStats(&stats);
+
+    out->socC             = stats.tempC;
+    out->pcbC             = stats.pcbC;
+    out->battC            = stats.battC;
+    out->controlC         = stats.controlC;
+    out->targetLevel      = stats.targetLevel;
+    out->appliedLevel     = stats.appliedLevel;
+    out->mode             = atomic_load(&fanRequestedMode);
+    out->paused           = atomic_load(&fanControllerPaused);
+    out->writesIssued     = stats.writesIssued;
+    out->writesSuppressed = stats.writesSuppressed;
+    out->readFailures     = stats.readFailures;
+    out->lastIntervalNs   = stats.lastIntervalNs;
+    out->wakeupsPerMinute = stats.wakeupsPerMinute;
+    out->profile          = fanActiveProfile;
+    out->supervisorState  = stats.supervisorState;
+    out->handbacks        = stats.handbacks;
+    out->writeFaults      = stats.writeFaults;
+    out->recoveries       = stats.recoveries;
+    out->lastRecoveryNs   = stats.lastRecoveryNs;
+    out->maxRecoveryNs    = stats.maxRecoveryNs;
+    out->pwmLevel         = stats.pwmLevel;
+    out->dutyMismatches   = stats.dutyMismatches;
+    out->reasserts        = stats.reasserts;
+}
+
+static Result FanIpcSetTableHandler(void *ctx, u32 profile, const TemperaturePoint *tbl, size_t count)
+{
+    (void)ctx;
+    static FanConfig config;
+
+    if (profile >= fanConfig.profileCount)
+        return FAN_IPC_RESULT(FanIpcError_BadTable);
+
+    /* FanIpcDispatch has validated the table already. */
+    config = fanConfig;
+    memcpy(config.profiles[profile].points, tbl, count * sizeof(TemperaturePoint));
+    config.profiles[profile].count = count;
+
+    /* If the spare set is busy the config poll picks the file up later. */
+    WriteConfigFile(&config);
+    PublishFanConfig(&config);
+    return 0;
+}
+
+static Result FanIpcSetModeHandler(void *ctx, u32 mode)
+{
+    (void)ctx;
+    FanControllerSettings settings;
+
+    mutexLock(&fanSettingsMutex);
+    settings = fanSettingsUpdate;
+    mutexUnlock(&fanSettingsMutex);
+    settings.mode = mode;
+    atomic_store(&fanRequestedMode, mode);
+    WriteSettingsFile(&settings);
+    return 0;
+}
+
+static void FanIpcSetPausedHandler(void *ctx, bool paused)
+{
+    (void)ctx;
+    atomic_store(&fanControllerPaused, paused);
+    WriteLog(FanLogLevel_Info, paused ? "fanctl: paused" : "fanctl: resumed");
+}
+
+static Result FanIpcGetTelemetryHandler(void *ctx, FanIpcTelemetryInfo *out, Handle *handle)
+{
+    (void)ctx;
+    if (fanTelemetry == NULL)
+        return FAN_IPC_RESULT(FanIpcError_Unavailable);
+
+    out->size = TELEMETRY_SHM_SIZE;
+    *handle   = fanTelemetryShm.handle;
+    return 0;
+}
+
+static const FanIpcHandlers fanIpcHandlers =
+{
+    .ctx            = NULL,
+    .getState       = FanIpcGetStateHandler,
+    .setTable       = FanIpcSetTableHandler,
+    .setMode        = FanIpcSetModeHandler,
+    .setPaused      = FanIpcSetPausedHandler,
+    .getTelemetry   = FanIpcGetTelemetryHandler,
+};
+
+/* ── Control thread stack ─────────────────────────────────────────── */
 
+/* The stack is painted before the thread starts and the untouched bytes at
+ * its low end give the high-water mark. While the thread exists libnx maps
+ * the stack to stack_mirror and the original address is inaccessible. */
+#define STACK_PAINT         0xA5
+#define STACK_WARN_PERCENT  75
+
+_Static_assert(FAN_CONTROLLER_STACK_SIZE % 0x1000 == 0, "thread stacks must be whole pages");
+
+static u8   fanControllerStack[FAN_CONTROLLER_STACK_SIZE] __attribute__((aligned(0x1000)));
+static bool fanControllerStackWarned;
+
+static u32 GetFanControllerStackPeak(void)
+{
+    const u8 *stack = FanControllerThread.stack_mirror;
+    u32 untouched = 0;
+
+    while (untouched < FAN_CONTROLLER_STACK_SIZE && stack[untouched] == STACK_PAINT)
+        untouched++;
+    return FAN_CONTROLLER_STACK_SIZE - untouched;
+}
+
+static void UpdateFanControllerStack(void)
+{
+    u32 peak = GetFanControllerStackPeak();
+
+    mutexLock(&fanControllerStatsMutex);
+    fanControllerStats.stackPeak = peak;
+    mutexUnlock(&fanControllerStatsMutex);
+
+    if (!fanControllerStackWarned && peak * 100 > FAN_CONTROLLER_STACK_SIZE * STACK_WARN_PERCENT)
+    {
+        fanControllerStackWarned = true;
+        WriteLog(FanLogLevel_Warn, "Control thread stack at %u of %u bytes",
+                 peak, FAN_CONTROLLER_STACK_SIZE);
+    }
+}
+
+/* Needs only the fan, i2c and pwm services: the control thread starts on
+ * the built-in curve and default settings, and the log waits in the ring,
+ * until LoadFanControllerConfig has the SD card. */
+void InitFanController(void)
+{
+    static FanConfig config;
+
+    FanConfigInitSingle(&config, defaultTable, DEFAULT_TABLE_ENTRIES);
+    PublishFanConfig(&config);
+
+    if (R_SUCCEEDED(shmemCreate(&fanTelemetryShm, TELEMETRY_SHM_SIZE, Perm_Rw, Perm_R)) &&
+        R_SUCCEEDED(shmemMap(&fanTelemetryShm)))
+    {
+        fanTelemetry = shmemGetAddr(&fanTelemetryShm);
+        FanTelemetryRingInit(fanTelemetry);
+    }
+    else
+    {
+        shmemClose(&fanTelemetryShm);
+        WriteLog(FanLogLevel_Warn, "Telemetry shared memory unavailable");
+    }
+
+    /* Keep the TMP451 session open for the lifetime of the controller. */
+    if (R_FAILED(I2cSessionPoolOpen(I2cDevice_Tmp451)))
+        WriteLog(FanLogLevel_Warn, "I2cSessionPoolOpen(Tmp451) failed, will retry on read");
+
+    memset(fanControllerStack, STACK_PAINT, sizeof(fanControllerStack));
+    fanControllerStats.stackSize = FAN_CONTROLLER_STACK_SIZE;
     if (R_FAILED(threadCreate(&FanControllerThread,
                               FanControllerThreadFunction,
-                              NULL, NULL, 0x4000, 0x3F, -2)))
+                              NULL, fanControllerStack, FAN_CONTROLLER_STACK_SIZE, 0x3F, -2)))
     {
-        WriteLog("Error creating FanControllerThread");
+        WriteLog(FanLogLevel_Error, "Error creating FanControllerThread");
+        FlushLog();
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
     }
 }
 
+void LoadFanControllerConfig(void)
+{
+    static FanConfig config;
+    FanControllerSettings settings;
+
+    InitLog();
+    ReadConfigFile(&config);
+    ReadSettingsFile(&settings);
+    SetLogLevel(settings.logLevel);
+    SetFanControllerSettings(&settings);
+
+    if (R_FAILED(FanPowerStateOpen()))
+        WriteLog(FanLogLevel_Warn, "Power state events unavailable, profile rules may not switch");
+    FanPowerStateRead(&fanPowerState);
+
+    /* Fails only if the control thread hasn't finished an iteration on the
+     * built-in curve yet; the config poll then retries a second later. */
+    if (PublishFanConfig(&config))
+        LogFanProfile();
+    FlushLog();
+}
+
 void FanControllerThreadFunction(void *arg)
 {
     (void)arg;
 
-    FanController fc;
-    float tempC        =  0.0f;
+    FanHal        hal;
+    FanSupervisor sup;
+    FanLoop       loop =
+    {
+        .gateCfg    = &fanControllerSettings.gate,
+        .schedCfg   = &fanControllerSettings.sched,
+        .settings   = &fanControllerSettings,
+    };
+
+    bool          fanUp = false;
 
-    Result rs = fanOpenController(&fc, 0x3D000001);
+    FanLoopInit(&loop);
+    FanSupervisorInit(&sup);
+
+    Result rs = FanHalSwitchOpen(&hal);
     if (R_FAILED(rs))
     {
-        WriteLog("Error opening fanController");
+        WriteLog(FanLogLevel_Error, "Error opening fanController");
+        FlushLog();
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
     }
 
     while (!atomic_load_explicit(&fanControllerThreadExit, memory_order_relaxed))
     {
-        /* ── Read temperature with retry ────────────────────────── */
-        bool readOk = false;
-        for (int retry = 0; retry < TEMP_READ_RETRIES; retry++)
+        u64 interval;
+
+        if (atomic_load(&fanControllerPaused))
         {
-            rs = Tmp451GetSocTemp(&tempC);
-            if (R_SUCCEEDED(rs))
-            {
-                readOk = true;
-                break;
-            }
+            atomic_fetch_add(&fanLoopEpoch, 1);
+            hal.sleepNs(hal.ctx, PAUSE_POLL_NS);
+            continue;
         }
 
-        if (!readOk)
+        if (atomic_load(&fanSettingsPending))
+            TakeFanControllerSettings(&loop);
+
+        u32 mode = atomic_load(&fanRequestedMode);
+        if (mode != fanControllerSettings.mode)
         {
-            WriteLog("Tmp451GetSocTemp failed after retries");
-            tempC = 70.0f;
+            fanControllerSettings.mode = mode;
+            FanPidInit(&loop.pid);
         }
 
-        /* ── Compute target fan level ───────────────────────────── */
-        float target  = InterpolateFanLevel(fanControllerTable, tempC);
-
-        /* ── Always update fan speed for immediate response ─────── */
-        rs = fanControllerSetRotationSpeedLevel(&fc, target);
+        loop.curve = atomic_load(&fanActiveCurve);
+        FanSupervisorState prevState = sup.state;
+        u64 start = armGetSystemTick();
+        rs = FanSupervisorStep(&sup, &fanSupervisorConfig, &loop, &hal, &interval);
+        u64 latencyNs = armTicksToNs(armGetSystemTick() - start);
+        atomic_fetch_add(&fanLoopEpoch, 1);
+        if (loop.readFailed)
+            WriteLog(FanLogLevel_Warn, "Tmp451GetSocTemp failed after retries");
+        if (loop.dutyMismatch)
+            WriteLog(FanLogLevel_Debug, "Fan level overwritten: %d%% read back, %d%% written",
+                     (int)lroundf(loop.pwmLevel * 100.0f), (int)lroundf(loop.gate.applied * 100.0f));
         if (R_FAILED(rs))
+            WriteLog(FanLogLevel_Warn, "fanControllerSetRotationSpeedLevel error 0x%X", rs);
+        if (sup.state != prevState)
+        {
+            /* From the safe level on the curve no longer drives the fan. */
+            FanLogLevel level = sup.state == FanSupervisorState_Normal ? FanLogLevel_Info
+                              : sup.state >= FanSupervisorState_SafeLevel ? FanLogLevel_Error
+                              : FanLogLevel_Warn;
+            WriteLog(level, "Fan supervisor: %s -> %s, %lu faults, last recovery %lu ms",
+                     FanSupervisorStateName(prevState), FanSupervisorStateName(sup.state),
+                     sup.faults, sup.lastRecoveryNs / 1000000);
+        }
+
+        if (!fanUp && loop.gate.applied >= 0.0f)
         {
-            WriteLog("fanControllerSetRotationSpeedLevel error");
-            diagAbortWithResult(
-                MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+            u64 upUs = armTicksToNs(armGetSystemTick() - fanLaunchTick) / 1000;
+            fanUp = true;
+            mutexLock(&fanControllerStatsMutex);
+            fanControllerStats.firstWriteUs = upUs;
+            mutexUnlock(&fanControllerStatsMutex);
+            if (fanTelemetry != NULL)
+                FanTelemetrySetFirstWrite(fanTelemetry, upUs);
+            WriteLog(FanLogLevel_Info, "Fan up %lu us after launch", upUs);
         }
 
-        /* ── Adaptive sleep ─────────────────────────────────────── */
-        u64 interval = (tempC >= TEMP_FAST_THRESH)
-                      ? POLL_FAST_NS
-                      : POLL_NORMAL_NS;
-        svcSleepThread(interval);
+        PublishFanControllerStats(&loop, &sup, interval);
+        PublishFanTelemetry(&loop, &sup, latencyNs, rs);
+        hal.sleepNs(hal.ctx, interval);
     }
 
-    fanControllerClose(&fc);
+    FanHalSwitchClose(&hal);
+
+    WriteLog(FanLogLevel_Info, "Fan writes: %lu issued, %lu suppressed, %u wakeups/min",
+             loop.gate.writesIssued, loop.gate.writesSuppressed,
+             loop.sched.wakeupsPerMinute);
+    WriteLog(FanLogLevel_Info, "Fan level overwritten %lu times, %lu re-asserts",
+             loop.dutyMismatches, loop.reasserts);
+    if (fanControllerSettings.predict.enabled)
+        WriteLog(FanLogLevel_Info, "Thermal model: tau %d ms, gain %d C, %u samples",
+                 (int)lroundf(loop.predictor.tauS * 1000.0f), (int)lroundf(loop.predictor.gainC),
+                 loop.predictor.samples);
+    WriteLog(FanLogLevel_Info, "Fan faults: %lu, %lu recovered (max %lu ms), %lu reopens, %lu handbacks",
+             sup.faults, sup.recoveries, sup.maxRecoveryNs / 1000000, sup.reopens,
+             sup.handbacks);
 }
 
 /* ── Thread lifecycle ─────────────────────────────────────────────── */
@@ -242,7 +974,8 @@ void StartFanControllerThread(void)
 {
     if (R_FAILED(threadStart(&FanControllerThread)))
     {
-        WriteLog("Error starting FanControllerThread");
+        WriteLog(FanLogLevel_Error, "Error starting FanControllerThread");
+        FlushLog();
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
     }
 }
@@ -254,23 +987,100 @@ void CloseFanControllerThread(void)
     Result rs = threadWaitForExit(&FanControllerThread);
     if (R_FAILED(rs))
     {
-        WriteLog("Error waiting fanControllerThread");
+        WriteLog(FanLogLevel_Error, "Error waiting fanControllerThread");
+        FlushLog();
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
     }
 
+    u32 stackPeak = GetFanControllerStackPeak();
     threadClose(&FanControllerThread);
 
     atomic_store_explicit(&fanControllerThreadExit, false, memory_order_relaxed);
 
-    free(fanControllerTable);
-    fanControllerTable = NULL;
+    DrainTrace(armTicksToNs(armGetSystemTick()));
+    FlushTrace();
+    if (fanTelemetry != NULL)
+    {
+        shmemClose(&fanTelemetryShm);
+        fanTelemetry = NULL;
+    }
+
+    I2cReadStats stats;
+    I2cGetReadStats(&stats);
+    I2cSessionPoolClose();
+
+    WriteLog(FanLogLevel_Info,
+             "I2C: %lu reads, %lu session opens, %lu failures, avg %lu ns, max %lu ns",
+             stats.reads, stats.sessionOpens, stats.failures,
+             stats.reads ? armTicksToNs(stats.totalTicks / stats.reads) : 0,
+             armTicksToNs(stats.maxTicks));
+    WriteLog(FanLogLevel_Info, "Control thread stack: %u of %u bytes",
+             stackPeak, FAN_CONTROLLER_STACK_SIZE);
+    FlushLog();
 }
 
+/* Blocks until the control thread exits. Meanwhile serves the fanctl
+ * service, follows power state events and checks for config changes once
+ * a second. */
 void WaitFanController(void)
 {
-    if (R_FAILED(threadWaitForExit(&FanControllerThread)))
+    FanIpcServer server;
+    bool serving = R_SUCCEEDED(FanIpcServerOpen(&server));
+    if (!serving)
+        WriteLog(FanLogLevel_Warn, "fanctl: service registration failed, IPC disabled");
+
+    /* The control thread first, then the power state events. */
+    Handle extra[1 + FAN_POWER_MAX_HANDLES];
+    extra[0] = FanControllerThread.handle;
+    s32 extraCount = 1 + FanPowerStateHandles(extra + 1, FAN_POWER_MAX_HANDLES);
+
+    u64 nextCheckNs = armTicksToNs(armGetSystemTick()) + CONFIG_POLL_NS;
+
+    for (;;)
     {
-        WriteLog("Error waiting fanControllerThread");
-        diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+        u64 nowNs = armTicksToNs(armGetSystemTick());
+        if (nowNs >= nextCheckNs)
+        {
+            CheckConfigReload();
+            DrainTrace(nowNs);
+            if (fanConfig.titleCount > 0)
+                UpdateForegroundTitle();
+            if (RulesUseBattery())
+                UpdatePowerState();
+            UpdateFanControllerStack();
+            FlushLog();
+            nextCheckNs = nowNs + CONFIG_POLL_NS;
+        }
+
+        s32 signalled = -1;
+        Result rs;
+
+        if (serving)
+        {
+            rs = FanIpcServerProcess(&server, &fanIpcHandlers, extra, extraCount,
+                                     nextCheckNs - nowNs, &signalled);
+        }
+        else
+        {
+            rs = svcWaitSynchronization(&signalled, extra, extraCount, nextCheckNs - nowNs);
+            if (R_FAILED(rs))
+                signalled = -1;
+        }
+
+        if (signalled == 0)
+            break;
+        if (signalled > 0)
+            UpdatePowerState();
+
+        if (R_FAILED(rs) && R_VALUE(rs) != KERNELRESULT(TimedOut))
+        {
+            WriteLog(FanLogLevel_Error, "Error waiting fanControllerThread");
+            FlushLog();
+            diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+        }
     }
-}
\ No newline at end of file
+
+    if (serving)
+        FanIpcServerClose(&server);
+    FanPowerStateClose();
+}
@@ -0,0 +1,125 @@
+#include <math.h>
+#include "hal.h"
+#include "controller.h"
+#include "tmp451.h"
+#include "pwm.h"
+
+/* ── Console backend ──────────────────────────────────────────────── */
+
+static FanController switchFanController;
+static bool          switchFanOpen;
+static PwmChannelSession switchFanPwm;
+static bool          switchFanPwmOpen;
+
+#define FAN_DEVICE_CODE 0x3D000001
+
+/* MAX17050 fuel gauge: TEMP is signed, 1/256 C per LSB, and only updates
+ * every ~1.4 s, so one read a second is plenty. */
+#define MAX17050_TEMP_REG       0x08
+#define BATTERY_READ_NS         1000000000ULL
+
+static float switchBattC = NAN;
+static u64   switchBattReadNs;
+
+static float SwitchReadBattery(void)
+{
+    u64 nowNs = armTicksToNs(armGetSystemTick());
+    u16 raw;
+
+    if (switchBattReadNs != 0 && nowNs - switchBattReadNs < BATTERY_READ_NS)
+        return switchBattC;
+
+    switchBattReadNs = nowNs;
+    switchBattC = R_SUCCEEDED(I2cReadRegHandler16(MAX17050_TEMP_REG, I2cDevice_Max17050, &raw))
+                ? (float)(s16)raw / 256.0f : NAN;
+    return switchBattC;
+}
+
+static Result SwitchReadSensors(void *ctx, u32 sensors, FanSensorSample *out)
+{
+    (void)ctx;
+    Result rc = Tmp451GetTemps(&out->socC, &out->pcbC);
+    if (R_FAILED(rc))
+        return rc;
+
+    /* Same wake-up as the TMP451 read; a gauge failure only drops the
+     * battery from the fusion. */
+    out->battC = (sensors & (1u << FanSensor_Battery)) ? SwitchReadBattery() : NAN;
+    return rc;
+}
+
+static Result SwitchSetFanLevel(void *ctx, float level)
+{
+    return fanControllerSetRotationSpeedLevel((FanController *)ctx, level);
+}
+
+static Result SwitchReadFanLevel(void *ctx, float *level_out)
+{
+    (void)ctx;
+    double duty;
+    Result rc = pwmChannelSessionGetDutyCycle(&switchFanPwm, &duty);
+    if (R_SUCCEEDED(rc))
+        *level_out = duty >= 100.0 ? 0.0f : duty <= 0.0 ? 1.0f : (float)((100.0 - duty) / 100.0);
+    return rc;
+}
+
+static Result SwitchReopenFan(void *ctx)
+{
+    if (switchFanOpen)
+        fanControllerClose((FanController *)ctx);
+
+    Result rs = fanOpenController((FanController *)ctx, FAN_DEVICE_CODE);
+    switchFanOpen = R_SUCCEEDED(rs);
+    return rs;
+}
+
+static void SwitchReleaseFan(void *ctx)
+{
+    if (switchFanOpen)
+        fanControllerClose((FanController *)ctx);
+    switchFanOpen = false;
+}
+
+static u64 SwitchNowNs(void *ctx)
+{
+    (void)ctx;
+    return armTicksToNs(armGetSystemTick());
+}
+
+static void SwitchSleepNs(void *ctx, u64 ns)
+{
+    (void)ctx;
+    svcSleepThread(ns);
+}
+
+Result FanHalSwitchOpen(FanHal *hal)
+{
+    Result rs = fanOpenController(&switchFanController, FAN_DEVICE_CODE);
+    if (R_FAILED(rs))
+        return rs;
+
+    /* Readback is optional: without the pwm service (before 6.0.0) the
+     * loop just doesn't verify its writes. */
+    switchFanPwmOpen = serviceIsActive(pwmGetServiceSession()) &&
+                       R_SUCCEEDED(pwmOpenSession2(&switchFanPwm, FAN_DEVICE_CODE));
+
+    switchFanOpen    = true;
+    hal->ctx         = &switchFanController;
+    hal->readSensors = SwitchReadSensors;
+    hal->setFanLevel = SwitchSetFanLevel;
+    hal->readFanLevel = switchFanPwmOpen ? SwitchReadFanLevel : NULL;
+    hal->reopenFan   = SwitchReopenFan;
+    hal->releaseFan  = SwitchReleaseFan;
+    hal->nowNs       = SwitchNowNs;
+    hal->sleepNs     = SwitchSleepNs;
+    return rs;
+}
+
+void FanHalSwitchClose(FanHal *hal)
+{
+    SwitchReleaseFan(hal->ctx);
+    if (switchFanPwmOpen)
+        pwmChannelSessionClose(&switchFanPwm);
+    switchFanPwmOpen = false;
+    hal->ctx = NULL;
+}
@@ -0,0 +1,220 @@
+#include <string.h>
+#include "i2c.h"
+
+/* ── Session pool ─────────────────────────────────────────────────── */
+
+#define I2C_SESSION_POOL_SIZE 4
+
+typedef struct
+{
+    I2cDevice   dev;
+    I2cSession  session;
+    bool        used;       /* slot is bound to dev       */
+    bool        open;       /* session currently open     */
+} I2cSessionSlot;
+
+static I2cSessionSlot g_i2cSlots[I2C_SESSION_POOL_SIZE];
+static I2cReadStats   g_i2cStats;
+static Mutex          g_i2cMutex;
+
+static I2cSessionSlot *I2cFindSlot(I2cDevice dev)
+{
+    I2cSessionSlot *free_slot = NULL;
+
+    for (size_t i = 0; i < I2C_SESSION_POOL_SIZE; i++)
+    {
+        if (g_i2cSlots[i].used && g_i2cSlots[i].dev == dev)
+            return &g_i2cSlots[i];
+        if (!g_i2cSlots[i].used && free_slot == NULL)
+            free_slot = &g_i2cSlots[i];
+    }
+
+    if (free_slot != NULL)
+    {
+        free_slot->dev  = dev;
+        free_slot->used = true;
+        free_slot->open = false;
+    }
+    return free_slot;
+}
+
+static Result I2cSlotOpen(I2cSessionSlot *slot)
+{
+    Result res = i2cOpenSession(&slot->session, slot->dev);
+    g_i2cStats.sessionOpens++;
+    slot->open = R_SUCCEEDED(res);
+    return res;
+}
+
+static void I2cSlotClose(I2cSessionSlot *slot)
+{
+    if (slot->open)
+        i2csessionClose(&slot->session);
+    slot->open = false;
+}
+
+/* Caller holds g_i2cMutex. */
+static Result I2cSlotExecute(I2cSessionSlot *slot, void *dst, size_t dst_size,
+                             const void *cmd, size_t cmd_size)
+{
+    u64 start = armGetSystemTick();
+    Result res = i2csessionExecuteCommandList(&slot->session, dst, dst_size, cmd, cmd_size);
+    u64 ticks = armGetSystemTick() - start;
+
+    g_i2cStats.reads++;
+    g_i2cStats.totalTicks += ticks;
+    if (ticks > g_i2cStats.maxTicks)
+        g_i2cStats.maxTicks = ticks;
+    return res;
+}
+
+static Result I2cExecuteCommandList(I2cDevice dev, void *dst, size_t dst_size,
+                                    const void *cmd, size_t cmd_size)
+{
+    mutexLock(&g_i2cMutex);
+
+    I2cSessionSlot *slot = I2cFindSlot(dev);
+    if (slot == NULL)
+    {
+        mutexUnlock(&g_i2cMutex);
+        return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    }
+
+    Result res = 0;
+    if (!slot->open)
+        res = I2cSlotOpen(slot);
+
+    if (R_SUCCEEDED(res))
+    {
+        res = I2cSlotExecute(slot, dst, dst_size, cmd, cmd_size);
+
+        /* The session may have gone stale, reopen it once and retry. */
+        if (R_FAILED(res))
+        {
+            I2cSlotClose(slot);
+            res = I2cSlotOpen(slot);
+            if (R_SUCCEEDED(res))
+                res = I2cSlotExecute(slot, dst, dst_size, cmd, cmd_size);
+        }
+    }
+
+    if (R_FAILED(res))
+    {
+        g_i2cStats.failures++;
+        I2cSlotClose(slot);
+    }
+
+    mutexUnlock(&g_i2cMutex);
+    return res;
+}
+
+Result I2cSessionPoolOpen(I2cDevice dev)
+{
+    mutexLock(&g_i2cMutex);
+
+    Result res = 0;
+    I2cSessionSlot *slot = I2cFindSlot(dev);
+    if (slot == NULL)
+        res = MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    else if (!slot->open)
+        res = I2cSlotOpen(slot);
+
+    mutexUnlock(&g_i2cMutex);
+    return res;
+}
+
+void I2cSessionPoolClose(void)
+{
+    mutexLock(&g_i2cMutex);
+    for (size_t i = 0; i < I2C_SESSION_POOL_SIZE; i++)
+    {
+        I2cSlotClose(&g_i2cSlots[i]);
+        g_i2cSlots[i].used = false;
+    }
+    mutexUnlock(&g_i2cMutex);
+}
+
+void I2cGetReadStats(I2cReadStats *out)
+{
+    mutexLock(&g_i2cMutex);
+    *out = g_i2cStats;
+    mutexUnlock(&g_i2cMutex);
+}
+
+/* ── Register reads ───────────────────────────────────────────────── */
+
+struct readReg {
+    u8 send;
+    u8 sendLength;
+    u8 sendData;
+    u8 receive;
+    u8 receiveLength;
+};
+
+Result I2cReadRegHandler16(u8 reg, I2cDevice dev, u16 *out)
+{
+    u16 val;
+
+    struct readReg readRegister = {
+        .send = 0 | (I2cTransactionOption_Start << 6),
+        .sendLength = sizeof(reg),
+        .sendData = reg,
+        .receive = 1 | (I2cTransactionOption_All << 6),
+        .receiveLength = sizeof(val),
+    };
+
+    Result res = I2cExecuteCommandList(dev, &val, sizeof(val), &readRegister, sizeof(readRegister));
+    if (res)
+        return res;
+
+    *out = val;
+    return 0;
+}
+
+Result I2cReadRegHandler8(u8 reg, I2cDevice dev, u8 *out)
+{
+    u8 val;
+
+    struct readReg readRegister = {
+        .send = 0 | (I2cTransactionOption_Start << 6),
+        .sendLength = sizeof(reg),
+        .sendData = reg,
+        .receive = 1 | (I2cTransactionOption_All << 6),
+        .receiveLength = sizeof(val),
+    };
+
+    Result res = I2cExecuteCommandList(dev, &val, sizeof(val), &readRegister, sizeof(readRegister));
+    if (res)
+        return res;
+
+    *out = val;
+    return 0;
+}
+
+Result I2cReadRegsHandler8(const u8 *regs, size_t count, I2cDevice dev, u8 *out)
+{
+    if (count == 0 || count > I2C_MAX_BATCH_REGS)
+        return MAKERESULT(Module_Libnx, LibnxError_BadInput);
+
+    /* One write-address / read-byte pair per register, all in a single IPC. */
+    struct readReg readRegisters[I2C_MAX_BATCH_REGS];
+    u8 val[I2C_MAX_BATCH_REGS];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        readRegisters[i] = (struct readReg) {
+            .send = 0 | (I2cTransactionOption_Start << 6),
+            .sendLength = sizeof(regs[i]),
+            .sendData = regs[i],
+            .receive = 1 | (I2cTransactionOption_All << 6),
+            .receiveLength = sizeof(val[i]),
+        };
+    }
+
+    Result res = I2cExecuteCommandList(dev, val, count, readRegisters, count * sizeof(readRegisters[0]));
+    if (res)
+        return res;
+
+    memcpy(out, val, count);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <string.h>
+#include "log_ring.h"
+
+#define FAN_LOG_RING_MASK  (FAN_LOG_RING_SLOTS - 1)
+
+_Static_assert((FAN_LOG_RING_SLOTS & FAN_LOG_RING_MASK) == 0,
+               "FAN_LOG_RING_SLOTS must be a power of two");
+
+void FanLogRingInit(FanLogRing *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+}
+
+/* ── Producers ────────────────────────────────────────────────────── */
+
+bool FanLogPush(FanLogRing *ring, FanLogLevel level, u64 timestampNs, const char *text)
+{
+    u32 pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    FanLogSlot *slot;
+
+    for (;;)
+    {
+        slot = &ring->slots[pos & FAN_LOG_RING_MASK];
+        u32 seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        s32 diff = (s32)(seq - (pos & ~FAN_LOG_RING_MASK));
+
+        if (diff == 0)
+        {
+            /* Free for this position; claim it. On failure pos is
+             * reloaded with the current head. */
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            /* Still holds the line from one lap ago: full. */
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            /* Another producer claimed it first. */
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    size_t len = strnlen(text, FAN_LOG_LINE_MAX - 1);
+    slot->line.timestampNs = timestampNs;
+    slot->line.level       = level;
+    memcpy(slot->line.text, text, len);
+    slot->line.text[len] = '\0';
+
+    atomic_store_explicit(&slot->seq, (pos & ~FAN_LOG_RING_MASK) + 1, memory_order_release);
+    return true;
+}
+
+/* ── Consumer ─────────────────────────────────────────────────────── */
+
+bool FanLogPop(FanLogRing *ring, FanLogLine *out)
+{
+    u32 pos  = ring->tail;
+    u32 base = pos & ~FAN_LOG_RING_MASK;
+    FanLogSlot *slot = &ring->slots[pos & FAN_LOG_RING_MASK];
+
+    /* Claimed but not yet complete lines wait for the next pop. */
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != base + 1)
+        return false;
+
+    *out = slot->line;
+    atomic_store_explicit(&slot->seq, base + FAN_LOG_RING_SLOTS, memory_order_release);
+    ring->tail = pos + 1;
+    return true;
+}
+
+char FanLogLevelChar(FanLogLevel level)
+{
+    switch (level)
+    {
+    case FanLogLevel_Debug: return 'D';
+    case FanLogLevel_Info:  return 'I';
+    case FanLogLevel_Warn:  return 'W';
+    default:                return 'E';
+    }
+}
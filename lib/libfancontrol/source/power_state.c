@@ -0,0 +1,133 @@
+#include "power_state.h"
+
+/* libnx has no omm wrapper; only these two commands are needed. */
+#define OMM_CMD_GET_OPERATION_MODE          0
+#define OMM_CMD_GET_OPERATION_MODE_EVENT    1
+#define OMM_OPERATION_MODE_CONSOLE          1
+
+static Service    ommService;
+static Event      ommModeEvent;
+static bool       ommOpen;
+
+static PsmSession psmSession;
+static bool       psmOpen;
+
+/* ── Open / close ─────────────────────────────────────────────────── */
+
+static Result OpenOmm(void)
+{
+    Handle handle = INVALID_HANDLE;
+
+    Result rc = smGetService(&ommService, "omm");
+    if (R_FAILED(rc))
+        return rc;
+
+    rc = serviceDispatch(&ommService, OMM_CMD_GET_OPERATION_MODE_EVENT,
+        .out_handle_attrs = { SfOutHandleAttr_HipcCopy },
+        .out_handles      = &handle,
+    );
+    if (R_FAILED(rc))
+    {
+        serviceClose(&ommService);
+        return rc;
+    }
+
+    eventLoadRemote(&ommModeEvent, handle, false);
+    ommOpen = true;
+    return 0;
+}
+
+static Result OpenPsm(void)
+{
+    Result rc = psmInitialize();
+    if (R_FAILED(rc))
+        return rc;
+
+    rc = psmOpenSession(&psmSession);
+    if (R_SUCCEEDED(rc))
+    {
+        /* Charger type, power supply and battery voltage thresholds. */
+        rc = psmBindStateChangeEvent(&psmSession, true, true, true);
+        if (R_FAILED(rc))
+            psmCloseSession(&psmSession);
+    }
+    if (R_FAILED(rc))
+    {
+        psmExit();
+        return rc;
+    }
+
+    psmOpen = true;
+    return 0;
+}
+
+Result FanPowerStateOpen(void)
+{
+    Result rc = smInitialize();
+    if (R_FAILED(rc))
+        return rc;
+
+    Result ommRc = OpenOmm();
+    Result psmRc = OpenPsm();
+    smExit();
+
+    return R_FAILED(ommRc) ? ommRc : psmRc;
+}
+
+void FanPowerStateClose(void)
+{
+    if (ommOpen)
+    {
+        eventClose(&ommModeEvent);
+        serviceClose(&ommService);
+        ommOpen = false;
+    }
+    if (psmOpen)
+    {
+        psmUnbindStateChangeEvent(&psmSession);
+        psmCloseSession(&psmSession);
+        psmExit();
+        psmOpen = false;
+    }
+}
+
+/* ── State ────────────────────────────────────────────────────────── */
+
+s32 FanPowerStateHandles(Handle *out, s32 max)
+{
+    s32 count = 0;
+
+    if (ommOpen && count < max)
+        out[count++] = ommModeEvent.revent;
+    if (psmOpen && count < max)
+        out[count++] = psmSession.StateChangeEvent.revent;
+    return count;
+}
+
+void FanPowerStateRead(FanPowerState *out)
+{
+    out->docked         = false;
+    out->charging       = false;
+    out->batteryPercent = 100;
+
+    if (ommOpen)
+    {
+        u8 mode = 0;
+
+        eventClear(&ommModeEvent);
+        if (R_SUCCEEDED(serviceDispatchOut(&ommService, OMM_CMD_GET_OPERATION_MODE, mode)))
+            out->docked = mode == OMM_OPERATION_MODE_CONSOLE;
+    }
+
+    if (psmOpen)
+    {
+        PsmChargerType charger;
+        u32 percent;
+
+        eventClear(&psmSession.StateChangeEvent);
+        if (R_SUCCEEDED(psmGetChargerType(&charger)))
+            out->charging = charger != PsmChargerType_Unconnected;
+        if (R_SUCCEEDED(psmGetBatteryChargePercentage(&percent)))
+            out->batteryPercent = percent;
+    }
+}
@@ -4,26 +4,11 @@
 
 static Service g_pwmSrv;
 
-// Forward declarations
-Result _pwmInitialize(void);
-void _pwmCleanup(void);
-
-// Service guard macro
-#define NX_GENERATE_SERVICE_GUARD(name) \
-    Result name##Initialize(void) { \
-        return _##name##Initialize(); \
-    } \
-    void name##Exit(void) { \
-        _##name##Cleanup(); \
-    }
-
-NX_GENERATE_SERVICE_GUARD(pwm);
-
-Result _pwmInitialize(void) {
+Result pwmInitialize(void) {
     return smGetService(&g_pwmSrv, "pwm");
 }
 
-void _pwmCleanup(void) {
+void pwmExit(void) {
     serviceClose(&g_pwmSrv);
 }
 
@@ -44,4 +29,4 @@ Result pwmChannelSessionGetDutyCycle(PwmChannelSession *c, double* out) {
 
 void pwmChannelSessionClose(PwmChannelSession *controller) {
     serviceClose(&controller->s);
-}
\ No newline at end of file
+}
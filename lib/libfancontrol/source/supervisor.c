@@ -0,0 +1,188 @@
+#include "supervisor.h"
+
+void FanSupervisorInit(FanSupervisor *sup)
+{
+    sup->state          = FanSupervisorState_Normal;
+    sup->attempts       = 0;
+    sup->enteredNs      = 0;
+    sup->recovering     = false;
+    sup->faultNs        = 0;
+    sup->lastError      = 0;
+
+    sup->faults         = 0;
+    sup->recoveries     = 0;
+    sup->reopens        = 0;
+    sup->handbacks      = 0;
+    sup->lastRecoveryNs = 0;
+    sup->maxRecoveryNs  = 0;
+}
+
+/* ── Episode bookkeeping ──────────────────────────────────────────── */
+
+static u64 Backoff(const FanSupervisorConfig *cfg, u32 attempts)
+{
+    u64 delay = cfg->backoffNs;
+    while (attempts-- > 0 && delay < cfg->backoffMaxNs)
+        delay *= 2;
+    return delay < cfg->backoffMaxNs ? delay : cfg->backoffMaxNs;
+}
+
+static void Enter(FanSupervisor *sup, FanSupervisorState state, u64 nowNs)
+{
+    sup->state     = state;
+    sup->attempts  = 0;
+    sup->enteredNs = nowNs;
+}
+
+static void Fault(FanSupervisor *sup, Result rs, u64 nowNs)
+{
+    sup->faults++;
+    sup->lastError = rs;
+    if (!sup->recovering)
+    {
+        sup->recovering = true;
+        sup->faultNs    = nowNs;
+    }
+}
+
+static void Recover(FanSupervisor *sup, u64 nowNs)
+{
+    if (!sup->recovering)
+        return;
+
+    sup->recovering     = false;
+    sup->recoveries++;
+    sup->lastRecoveryNs = nowNs - sup->faultNs;
+    if (sup->lastRecoveryNs > sup->maxRecoveryNs)
+        sup->maxRecoveryNs = sup->lastRecoveryNs;
+}
+
+static void HandBack(FanSupervisor *sup, FanLoop *loop, const FanHal *hal, u64 nowNs)
+{
+    hal->releaseFan(hal->ctx);
+    sup->handbacks++;
+
+    /* The firmware moves the fan from here on, so the level is unknown
+     * until the next write of our own. */
+    loop->released       = true;
+    loop->fixedLevel     = -1.0f;
+    loop->gate.applied   = -1.0f;
+    loop->gate.direction = 0;
+    loop->gate.slewLevel = -1.0f;
+    Enter(sup, FanSupervisorState_Handback, nowNs);
+}
+
+/* ── Step ─────────────────────────────────────────────────────────── */
+
+Result FanSupervisorStep(FanSupervisor *sup, const FanSupervisorConfig *cfg,
+                         FanLoop *loop, const FanHal *hal, u64 *interval_out)
+{
+    u64 now = hal->nowNs(hal->ctx);
+    Result rs = 0;
+
+    /* A session left closed by a failed reopen is retried before the
+     * safe level can be written through it. */
+    bool reopen = sup->state == FanSupervisorState_Reopen ||
+                  (sup->state == FanSupervisorState_SafeLevel && loop->released) ||
+                  (sup->state == FanSupervisorState_Handback &&
+                   now - sup->enteredNs >= cfg->probeNs);
+    if (reopen)
+    {
+        sup->reopens++;
+        rs = hal->reopenFan(hal->ctx);
+        loop->released = R_FAILED(rs);
+    }
+
+    /* The iteration runs either way for the readings. After a failure the
+     * gate lets the next write through, so unless the session is closed
+     * a success below means the fan took a write. */
+    Result writeRs = FanLoopStep(loop, hal, interval_out);
+    if (R_SUCCEEDED(rs))
+        rs = writeRs;
+    bool failed = R_FAILED(rs);
+
+    switch (sup->state)
+    {
+    case FanSupervisorState_Normal:
+        if (failed)
+        {
+            Fault(sup, rs, now);
+            Enter(sup, FanSupervisorState_Retry, now);
+        }
+        break;
+
+    case FanSupervisorState_Retry:
+    case FanSupervisorState_Reopen:
+        if (!failed)
+        {
+            Recover(sup, now);
+            Enter(sup, FanSupervisorState_Normal, now);
+            break;
+        }
+        Fault(sup, rs, now);
+        if (sup->state == FanSupervisorState_Retry && ++sup->attempts >= cfg->retries)
+        {
+            Enter(sup, FanSupervisorState_Reopen, now);
+        }
+        else if (sup->state == FanSupervisorState_Reopen && ++sup->attempts >= cfg->reopens)
+        {
+            Enter(sup, FanSupervisorState_SafeLevel, now);
+            loop->fixedLevel = cfg->safeLevel;
+        }
+        break;
+
+    case FanSupervisorState_SafeLevel:
+        if (failed)
+        {
+            Fault(sup, rs, now);
+            if (++sup->attempts >= cfg->safeRetries)
+                HandBack(sup, loop, hal, now);
+        }
+        else if (sup->recovering)
+        {
+            /* The safe level stuck; the hold starts now. */
+            Recover(sup, now);
+            sup->enteredNs = now;
+        }
+        else if (now - sup->enteredNs >= cfg->safeHoldNs)
+        {
+            loop->fixedLevel = -1.0f;
+            Enter(sup, FanSupervisorState_Normal, now);
+        }
+        break;
+
+    case FanSupervisorState_Handback:
+        if (!reopen)
+            break;
+        if (!failed)
+        {
+            Recover(sup, now);
+            Enter(sup, FanSupervisorState_Normal, now);
+            break;
+        }
+        Fault(sup, rs, now);
+        if (!loop->released)
+        {
+            hal->releaseFan(hal->ctx);
+            loop->released = true;
+        }
+        sup->enteredNs = now;
+        break;
+    }
+
+    if (sup->recovering && sup->state != FanSupervisorState_Handback)
+        *interval_out = Backoff(cfg, sup->attempts);
+    return rs;
+}
+
+const char *FanSupervisorStateName(FanSupervisorState state)
+{
+    switch (state)
+    {
+    case FanSupervisorState_Normal:     return "normal";
+    case FanSupervisorState_Retry:      return "retry";
+    case FanSupervisorState_Reopen:     return "reopen";
+    case FanSupervisorState_SafeLevel:  return "safe level";
+    default:                            return "handback";
+    }
+}
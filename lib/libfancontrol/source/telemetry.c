@@ -0,0 +1,139 @@
+#include <string.h>
+#include "telemetry.h"
+
+#define FAN_TELEMETRY_MASK  (FAN_TELEMETRY_SLOTS - 1)
+
+_Static_assert((FAN_TELEMETRY_SLOTS & FAN_TELEMETRY_MASK) == 0,
+               "FAN_TELEMETRY_SLOTS must be a power of two");
+_Static_assert(sizeof(FanTelemetrySample) % sizeof(u32) == 0,
+               "FanTelemetrySample must be a whole number of words");
+
+/* ── Writer ───────────────────────────────────────────────────────── */
+
+void FanTelemetryRingInit(FanTelemetryRing *ring)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->magic     = FAN_TELEMETRY_MAGIC;
+    ring->version   = FAN_TELEMETRY_VERSION;
+    ring->slotCount = FAN_TELEMETRY_SLOTS;
+    atomic_store_explicit(&ring->head, 0, memory_order_release);
+}
+
+void FanTelemetryPublish(FanTelemetryRing *ring, const FanTelemetrySample *sample)
+{
+    u64 index = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    FanTelemetrySlot *slot = &ring->slots[index & FAN_TELEMETRY_MASK];
+    u32 words[FAN_TELEMETRY_SAMPLE_WORDS];
+    u32 seq = (u32)(index * 2);
+
+    memcpy(words, sample, sizeof(words));
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    for (size_t i = 0; i < FAN_TELEMETRY_SAMPLE_WORDS; i++)
+        atomic_store_explicit(&slot->words[i], words[i], memory_order_relaxed);
+
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&ring->head, index + 1, memory_order_release);
+}
+
+void FanTelemetrySetFirstWrite(FanTelemetryRing *ring, u64 us)
+{
+    u32 none = 0;
+    u32 value = us == 0 ? 1 : us > UINT32_MAX ? UINT32_MAX : (u32)us;
+
+    atomic_compare_exchange_strong_explicit(&ring->firstWriteUs, &none, value,
+                                            memory_order_release, memory_order_relaxed);
+}
+
+/* ── Reader ───────────────────────────────────────────────────────── */
+
+bool FanTelemetryRingValid(const FanTelemetryRing *ring)
+{
+    return ring->magic == FAN_TELEMETRY_MAGIC &&
+           ring->version == FAN_TELEMETRY_VERSION &&
+           ring->slotCount == FAN_TELEMETRY_SLOTS;
+}
+
+u32 FanTelemetryFirstWriteUs(const FanTelemetryRing *ring)
+{
+    /* The ring is only read here, the cast drops const for C11 atomics. */
+    return atomic_load_explicit((FAN_TELEMETRY_ATOMIC(u32) *)&ring->firstWriteUs,
+                                memory_order_acquire);
+}
+
+/* Copies sample index out of its slot; false if the slot holds another
+ * sample or was rewritten during the copy. */
+static bool FanTelemetryReadSlot(const FanTelemetryRing *ring, u64 index,
+                                 FanTelemetrySample *out)
+{
+    /* The ring is only read here, the casts drop const for C11 atomics. */
+    FanTelemetrySlot *slot = (FanTelemetrySlot *)&ring->slots[index & FAN_TELEMETRY_MASK];
+    u32 words[FAN_TELEMETRY_SAMPLE_WORDS];
+    u32 want = (u32)(index * 2 + 2);
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != want)
+        return false;
+
+    for (size_t i = 0; i < FAN_TELEMETRY_SAMPLE_WORDS; i++)
+        words[i] = atomic_load_explicit(&slot->words[i], memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != want)
+        return false;
+
+    memcpy(out, words, sizeof(*out));
+    return true;
+}
+
+static u64 FanTelemetryHead(const FanTelemetryRing *ring)
+{
+    return atomic_load_explicit((FAN_TELEMETRY_ATOMIC(u64) *)&ring->head, memory_order_acquire);
+}
+
+bool FanTelemetryReadLatest(const FanTelemetryRing *ring, FanTelemetrySample *out)
+{
+    for (int attempt = 0; attempt < FAN_TELEMETRY_READ_RETRIES; attempt++)
+    {
+        u64 head = FanTelemetryHead(ring);
+        if (head == 0)
+            return false;
+        if (FanTelemetryReadSlot(ring, head - 1, out))
+            return true;
+    }
+    return false;
+}
+
+size_t FanTelemetryReadSince(const FanTelemetryRing *ring, u64 *cursor,
+                             FanTelemetrySample *out, size_t max, u64 *dropped)
+{
+    u64 head = FanTelemetryHead(ring);
+    u64 next = *cursor;
+    u64 lost = 0;
+    size_t count = 0;
+
+    if (next > head)
+        next = head;
+
+    /* Anything more than a ring behind is gone already. */
+    if (head - next > FAN_TELEMETRY_SLOTS)
+    {
+        lost += head - FAN_TELEMETRY_SLOTS - next;
+        next = head - FAN_TELEMETRY_SLOTS;
+    }
+
+    while (next < head && count < max)
+    {
+        if (FanTelemetryReadSlot(ring, next, &out[count]))
+            count++;
+        else
+            lost++;     /* overwritten while we were catching up */
+        next++;
+    }
+
+    *cursor = next;
+    if (dropped != NULL)
+        *dropped += lost;
+    return count;
+}
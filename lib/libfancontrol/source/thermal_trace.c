@@ -0,0 +1,168 @@
+#include <math.h>
+#include <string.h>
+#include "thermal_trace.h"
+
+/* ── Field encoding ───────────────────────────────────────────────── */
+
+static size_t PutVarint(u8 *out, u64 value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (u8)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (u8)value;
+    return n;
+}
+
+static bool GetVarint(const u8 *data, size_t size, size_t *pos, u64 *value)
+{
+    u64 v = 0;
+    for (u32 shift = 0; shift < 64 && *pos < size; shift += 7)
+    {
+        u8 b = data[(*pos)++];
+        v |= (u64)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            *value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PutU16(u8 *out, u16 value)
+{
+    out[0] = (u8)value;
+    out[1] = (u8)(value >> 8);
+}
+
+static u16 GetU16(const u8 *data)
+{
+    return (u16)(data[0] | (data[1] << 8));
+}
+
+static u16 EncodeTemp(float tempC)
+{
+    if (isnan(tempC))
+        return (u16)FAN_TRACE_NO_TEMP;
+    float centi = roundf(tempC * 100.0f);
+    if (centi < (float)(INT16_MIN + 1))
+        centi = (float)(INT16_MIN + 1);
+    if (centi > (float)INT16_MAX)
+        centi = (float)INT16_MAX;
+    return (u16)(s16)centi;
+}
+
+static float DecodeTemp(u16 raw)
+{
+    return (s16)raw == FAN_TRACE_NO_TEMP ? NAN : (float)(s16)raw / 100.0f;
+}
+
+static u16 EncodeLevel(float level)
+{
+    if (!(level >= 0.0f))
+        return FAN_TRACE_NO_LEVEL;
+    return (u16)roundf(fminf(level, 1.0f) * 10000.0f);
+}
+
+static float DecodeLevel(u16 raw)
+{
+    return raw == FAN_TRACE_NO_LEVEL ? -1.0f : (float)raw / 10000.0f;
+}
+
+/* ── Writer ───────────────────────────────────────────────────────── */
+
+size_t FanTraceBegin(FanTraceCursor *cursor, u64 startNs, u8 *out)
+{
+    u32 magic   = FAN_TRACE_MAGIC;
+    u16 version = FAN_TRACE_VERSION;
+    u16 size    = FAN_TRACE_HEADER_SIZE;
+
+    memcpy(out,     &magic,   sizeof(magic));
+    memcpy(out + 4, &version, sizeof(version));
+    memcpy(out + 6, &size,    sizeof(size));
+    memcpy(out + 8, &startNs, sizeof(startNs));
+
+    cursor->lastUs = startNs / 1000;
+    return FAN_TRACE_HEADER_SIZE;
+}
+
+size_t FanTraceEncode(FanTraceCursor *cursor, const FanTelemetrySample *sample, u8 *out)
+{
+    u64 us = sample->timestampNs / 1000;
+    size_t n = 0;
+
+    n += PutVarint(out + n, us >= cursor->lastUs ? us - cursor->lastUs : 0);
+    out[n++] = (u8)sample->flags;
+    n += PutVarint(out + n, sample->result);
+    n += PutVarint(out + n, sample->loopLatencyNs / 1000);
+
+    PutU16(out + n, EncodeTemp(sample->socC));        n += 2;
+    PutU16(out + n, EncodeTemp(sample->pcbC));        n += 2;
+    PutU16(out + n, EncodeTemp(sample->battC));       n += 2;
+    PutU16(out + n, EncodeTemp(sample->controlC));    n += 2;
+    PutU16(out + n, EncodeLevel(sample->targetLevel)); n += 2;
+    PutU16(out + n, EncodeLevel(sample->dutyLevel));   n += 2;
+
+    if (us > cursor->lastUs)
+        cursor->lastUs = us;
+    return n;
+}
+
+/* ── Reader ───────────────────────────────────────────────────────── */
+
+bool FanTraceOpen(FanTraceCursor *cursor, const u8 *data, size_t size, size_t *pos)
+{
+    u32 magic;
+    u16 version, headerSize;
+    u64 startNs;
+
+    if (size < FAN_TRACE_HEADER_SIZE)
+        return false;
+    memcpy(&magic,      data,     sizeof(magic));
+    memcpy(&version,    data + 4, sizeof(version));
+    memcpy(&headerSize, data + 6, sizeof(headerSize));
+    memcpy(&startNs,    data + 8, sizeof(startNs));
+
+    if (magic != FAN_TRACE_MAGIC || version != FAN_TRACE_VERSION ||
+        headerSize < FAN_TRACE_HEADER_SIZE || headerSize > size)
+        return false;
+
+    cursor->lastUs = startNs / 1000;
+    *pos = headerSize;
+    return true;
+}
+
+bool FanTraceDecode(FanTraceCursor *cursor, const u8 *data, size_t size, size_t *pos,
+                    FanTelemetrySample *out)
+{
+    size_t p = *pos;
+    u64 dtUs, result, latencyUs;
+
+    if (!GetVarint(data, size, &p, &dtUs) || p >= size)
+        return false;
+    u8 flags = data[p++];
+    if (!GetVarint(data, size, &p, &result) || !GetVarint(data, size, &p, &latencyUs) ||
+        size - p < 12 || result > UINT32_MAX || latencyUs > UINT32_MAX / 1000)
+        return false;
+
+    cursor->lastUs    += dtUs;
+    out->timestampNs   = cursor->lastUs * 1000;
+    out->flags         = flags;
+    out->result        = (u32)result;
+    out->loopLatencyNs = (u32)latencyUs * 1000;
+    out->socC          = DecodeTemp(GetU16(data + p));
+    out->pcbC          = DecodeTemp(GetU16(data + p + 2));
+    out->battC         = DecodeTemp(GetU16(data + p + 4));
+    out->controlC      = DecodeTemp(GetU16(data + p + 6));
+    out->targetLevel   = DecodeLevel(GetU16(data + p + 8));
+    out->dutyLevel     = DecodeLevel(GetU16(data + p + 10));
+    out->faults        = 0;
+    out->recoveryUs    = 0;
+    out->pwmLevel      = -1.0f;
+
+    *pos = p + 12;
+    return true;
+}
@@ -8,8 +8,7 @@
 #define TMP451_SOC_TEMP_DEC_REG 0x10
 #define TMP451_PCB_TEMP_DEC_REG 0x15
 
-// Forward declarations
-Result I2cReadRegHandler8(u8 reg, I2cDevice dev, u8 *out);
+#include "i2c.h"
 
 static inline Result Tmp451ReadReg(u8 reg, u8 *out)
 {
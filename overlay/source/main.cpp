@@ -12,11 +12,13 @@ public:
         // 这里只初始化你的服务
         fsdevMountSdmc();
         pmshellInitialize();
+        pminfoInitialize();
     }
     
     virtual void exitServices() override {
         fsdevUnmountAll();
         pmshellExit();
+        pminfoExit();
     }
 
     virtual std::unique_ptr<tsl::Gui> loadInitialGui() override {
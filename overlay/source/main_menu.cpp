@@ -3,26 +3,22 @@
 
 MainMenu::MainMenu()
 {
-    ReadConfigFile(&this->_fanCurveTable);
+    ReadConfigFile(&this->_config);
 
     // 传感器初始化
     InitializeSensors();
 
+    // 默认编辑当前生效的方案
+    FanIpcState state;
+    if (GetFanState(&state) && state.profile < this->_config.profileCount)
+        this->_profile = state.profile;
+
+    this->_titleId = GetForegroundTitleId();
+
     // 初始化温度和风扇速度标签
     this->_socTempLabel = new tsl::elm::ListItem("核心温度: --℃");
     this->_fanSpeedLabel = new tsl::elm::ListItem("风扇转速: --%");
 
-    this->_p0Label = new tsl::elm::ListItem("P0: " + std::to_string(this->_fanCurveTable->temperature_c) + "℃ | " + std::to_string((int)(this->_fanCurveTable->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p1Label = new tsl::elm::ListItem("P1: " + std::to_string((this->_fanCurveTable + 1)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 1)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p2Label = new tsl::elm::ListItem("P2: " + std::to_string((this->_fanCurveTable + 2)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 2)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p3Label = new tsl::elm::ListItem("P3: " + std::to_string((this->_fanCurveTable + 3)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 3)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p4Label = new tsl::elm::ListItem("P4: " + std::to_string((this->_fanCurveTable + 4)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 4)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p5Label = new tsl::elm::ListItem("P5: " + std::to_string((this->_fanCurveTable + 5)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 5)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p6Label = new tsl::elm::ListItem("P6: " + std::to_string((this->_fanCurveTable + 6)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 6)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p7Label = new tsl::elm::ListItem("P7: " + std::to_string((this->_fanCurveTable + 7)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 7)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p8Label = new tsl::elm::ListItem("P8: " + std::to_string((this->_fanCurveTable + 8)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 8)->fanLevel_f * 100 + 0.5f)) + "%");
-    this->_p9Label = new tsl::elm::ListItem("P9: " + std::to_string((this->_fanCurveTable + 9)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 9)->fanLevel_f * 100 + 0.5f)) + "%");
-
     if (IsRunning() != 0)
     {
         this->_enabledBtn = new tsl::elm::ToggleListItem("应用风扇曲线", true);
@@ -75,114 +71,44 @@ tsl::elm::Element* MainMenu::createUI()
     list->addItem(this->_fanSpeedLabel);
 
     list->addItem(new tsl::elm::CategoryHeader("风扇曲线", true));
-    this->_p0Label->setClickListener([this](uint64_t keys)
-    {
-	    if (keys & KEY_A) 
-        {
-			tsl::changeTo<SelectMenu>(0, this->_fanCurveTable, &this->_tableIsChanged);
-			return true;
-		}
-		return false; 
-    });
-    list->addItem(this->_p0Label);
-
-    this->_p1Label->setClickListener([this](uint64_t keys)
-    {
-	    if (keys & KEY_A) 
-        {
-			tsl::changeTo<SelectMenu>(1, this->_fanCurveTable, &this->_tableIsChanged);
-			return true;
-		}
-		return false;
-    });
-    list->addItem(this->_p1Label);
-
-    this->_p2Label->setClickListener([this](uint64_t keys)
-    {
-	    if (keys & KEY_A) 
-        {
-			tsl::changeTo<SelectMenu>(2, this->_fanCurveTable, &this->_tableIsChanged);
-			return true;
-		}
-		return false; 
-    });
-    list->addItem(this->_p2Label);
-
-    this->_p3Label->setClickListener([this](uint64_t keys)
-    {
-	    if (keys & KEY_A) 
-        {
-		    tsl::changeTo<SelectMenu>(3, this->_fanCurveTable, &this->_tableIsChanged);
-			return true;
-		}
-		return false; 
-    });
-    list->addItem(this->_p3Label);
 
-    this->_p4Label->setClickListener([this](uint64_t keys)
+    // 多个方案时按 A 切换要编辑的方案
+    this->_profileBtn = new tsl::elm::ListItem("方案: " + std::string(this->_config.profiles[this->_profile].name));
+    this->_profileBtn->setClickListener([this](uint64_t keys)
     {
-	    if (keys & KEY_A) 
+        if ((keys & KEY_A) && this->_config.profileCount > 1)
         {
-				tsl::changeTo<SelectMenu>(4, this->_fanCurveTable, &this->_tableIsChanged);
-				return true;
-	    }
-	    return false; 
-    });
-    list->addItem(this->_p4Label);
-        this->_p5Label->setClickListener([this](uint64_t keys)
-    {
-        if (keys & KEY_A) 
-        {
-            tsl::changeTo<SelectMenu>(5, this->_fanCurveTable, &this->_tableIsChanged);
+            this->_profile = (this->_profile + 1) % this->_config.profileCount;
+            this->_profileBtn->setText("方案: " + std::string(this->_config.profiles[this->_profile].name));
+            if (this->_titleBtn != nullptr)
+                this->_titleBtn->setText(this->TitleText());
+            this->RemovePointItems();
+            this->AddPointItems();
             return true;
         }
         return false;
     });
-    list->addItem(this->_p5Label);
+    list->addItem(this->_profileBtn);
 
-    this->_p6Label->setClickListener([this](uint64_t keys)
+    // 游戏运行中时可让它固定使用当前方案
+    if (this->_titleId != 0)
     {
-        if (keys & KEY_A) 
+        this->_titleBtn = new tsl::elm::ListItem(this->TitleText());
+        this->_titleBtn->setClickListener([this](uint64_t keys)
         {
-            tsl::changeTo<SelectMenu>(6, this->_fanCurveTable, &this->_tableIsChanged);
-            return true;
-        }
-        return false;
-    });
-    list->addItem(this->_p6Label);
-
-    this->_p7Label->setClickListener([this](uint64_t keys)
-    {
-        if (keys & KEY_A) 
-        {
-            tsl::changeTo<SelectMenu>(7, this->_fanCurveTable, &this->_tableIsChanged);
-            return true;
-        }
-        return false;
-    });
-    list->addItem(this->_p7Label);
-
-    this->_p8Label->setClickListener([this](uint64_t keys)
-    {
-        if (keys & KEY_A) 
-        {
-            tsl::changeTo<SelectMenu>(8, this->_fanCurveTable, &this->_tableIsChanged);
-            return true;
-        }
-        return false;
-    });
-    list->addItem(this->_p8Label);
+            if (keys & KEY_A)
+            {
+                this->ToggleTitleRule();
+                this->_titleBtn->setText(this->TitleText());
+                return true;
+            }
+            return false;
+        });
+        list->addItem(this->_titleBtn);
+    }
 
-    this->_p9Label->setClickListener([this](uint64_t keys)
-    {
-        if (keys & KEY_A) 
-        {
-            tsl::changeTo<SelectMenu>(9, this->_fanCurveTable, &this->_tableIsChanged);
-            return true;
-        }
-        return false;
-    });
-    list->addItem(this->_p9Label);
+    this->_list = list;
+    this->AddPointItems();
 
     frame->setContent(list);
 
@@ -191,23 +117,34 @@ tsl::elm::Element* MainMenu::createUI()
 
 void MainMenu::update()
 {
-    static u64 counter = 0;
-    counter++;
-    
-    // 每 6-12 帧更新读数
-    if (counter % 6 == 0) {
-        // 获取 SOC 温度
-        float socTemp = GetSOCTemperature();
+    // 每帧从遥测环读取最新样本 (无系统调用), 仅在显示值变化时更新标签
+    FanTelemetrySample sample;
+    int socTemp = -1;
+    int fanSpeed = -1;
+    if (GetFanSample(&sample)) {
+        socTemp = (int)sample.socC;
+        u32 state = (sample.flags & FAN_TELEMETRY_STATE_MASK) >> FAN_TELEMETRY_STATE_SHIFT;
+        if (state == FanSupervisorState_Handback)
+            fanSpeed = FanSpeedHandback;  // 风扇写入反复失败, 已交还系统控制
+        else if (sample.dutyLevel >= 0.0f)
+            fanSpeed = (int)(sample.dutyLevel * 100.0f + 0.5f);
+    }
+
+    if (socTemp != this->_shownSocTemp) {
+        this->_shownSocTemp = socTemp;
         if (socTemp >= 0) {
-            this->_socTempLabel->setText("核心温度: " + std::to_string((int)socTemp) + "℃");
+            this->_socTempLabel->setText("核心温度: " + std::to_string(socTemp) + "℃");
         } else {
             this->_socTempLabel->setText("核心温度: 未知");
         }
+    }
 
-        // 获取风扇转速
-        float fanSpeed = GetFanSpeed();
-        if (fanSpeed >= -1) {
-            this->_fanSpeedLabel->setText("风扇转速: " + std::to_string((int)fanSpeed) + "%");
+    if (fanSpeed != this->_shownFanSpeed) {
+        this->_shownFanSpeed = fanSpeed;
+        if (fanSpeed >= 0) {
+            this->_fanSpeedLabel->setText("风扇转速: " + std::to_string(fanSpeed) + "%");
+        } else if (fanSpeed == FanSpeedHandback) {
+            this->_fanSpeedLabel->setText("风扇转速: 系统控制");
         } else {
             this->_fanSpeedLabel->setText("风扇转速: 未知");
         }
@@ -215,17 +152,92 @@ void MainMenu::update()
 
     if(this->_tableIsChanged)
     {
-        this->_p0Label->setText("P0: " + std::to_string(this->_fanCurveTable->temperature_c) + "℃ | " + std::to_string((int)(this->_fanCurveTable->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p1Label->setText("P1: " + std::to_string((this->_fanCurveTable + 1)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 1)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p2Label->setText("P2: " + std::to_string((this->_fanCurveTable + 2)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 2)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p3Label->setText("P3: " + std::to_string((this->_fanCurveTable + 3)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 3)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p4Label->setText("P4: " + std::to_string((this->_fanCurveTable + 4)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 4)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p5Label->setText("P5: " + std::to_string((this->_fanCurveTable + 5)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 5)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p6Label->setText("P6: " + std::to_string((this->_fanCurveTable + 6)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 6)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p7Label->setText("P7: " + std::to_string((this->_fanCurveTable + 7)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 7)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p8Label->setText("P8: " + std::to_string((this->_fanCurveTable + 8)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 8)->fanLevel_f * 100 + 0.5f)) + "%");
-        this->_p9Label->setText("P9: " + std::to_string((this->_fanCurveTable + 9)->temperature_c) + "℃ | " + std::to_string((int)((this->_fanCurveTable + 9)->fanLevel_f * 100 + 0.5f)) + "%");
+        // 点数变化时重建列表, 否则只更新文字
+        if (this->_pointLabels.size() != this->_config.profiles[this->_profile].count)
+        {
+            this->RemovePointItems();
+            this->AddPointItems();
+        }
+        else
+        {
+            for (size_t i = 0; i < this->_pointLabels.size(); i++)
+                this->_pointLabels[i]->setText(this->PointText(i));
+        }
 
         this->_tableIsChanged = false;
     }
 }
+
+std::string MainMenu::PointText(size_t i)
+{
+    const TemperaturePoint& point = this->_config.profiles[this->_profile].points[i];
+    return "P" + std::to_string(i) + ": " + std::to_string(point.temperature_c) + "℃ | " + std::to_string((int)(point.fanLevel_f * 100 + 0.5f)) + "%";
+}
+
+// 前台游戏在配置中的规则下标, 没有为 -1
+int MainMenu::TitleRule()
+{
+    for (size_t i = 0; i < this->_config.titleCount; i++)
+        if (this->_config.titles[i].titleId == this->_titleId)
+            return (int)i;
+    return -1;
+}
+
+std::string MainMenu::TitleText()
+{
+    int rule = this->TitleRule();
+    if (rule < 0)
+        return "当前游戏: 跟随规则";
+    if (this->_config.titles[rule].profile == this->_profile)
+        return "当前游戏: 使用此方案";
+    return "当前游戏: " + std::string(this->_config.profiles[this->_config.titles[rule].profile].name);
+}
+
+// 已绑定到当前方案则解除, 否则绑定到当前方案. 写入 config.dat 后系统模块在一秒内生效
+void MainMenu::ToggleTitleRule()
+{
+    int rule = this->TitleRule();
+    if (rule >= 0 && this->_config.titles[rule].profile == this->_profile)
+    {
+        this->_config.titles[rule] = this->_config.titles[--this->_config.titleCount];
+    }
+    else if (rule >= 0)
+    {
+        this->_config.titles[rule].profile = this->_profile;
+    }
+    else if (this->_config.titleCount < FAN_TITLE_RULE_MAX)
+    {
+        FanTitleRule& title = this->_config.titles[this->_config.titleCount++];
+        title = FanTitleRule{};
+        title.titleId = this->_titleId;
+        title.profile = this->_profile;
+    }
+    WriteConfigFile(&this->_config);
+}
+
+// 曲线点位于列表末尾, 可以整体移除后重新追加
+void MainMenu::AddPointItems()
+{
+    for (size_t i = 0; i < this->_config.profiles[this->_profile].count; i++)
+    {
+        auto label = new tsl::elm::ListItem(this->PointText(i));
+        label->setClickListener([this, i](uint64_t keys)
+        {
+            if (keys & KEY_A)
+            {
+                tsl::changeTo<SelectMenu>((int)i, &this->_config, this->_profile, &this->_tableIsChanged);
+                return true;
+            }
+            return false;
+        });
+        this->_list->addItem(label);
+        this->_pointLabels.push_back(label);
+    }
+}
+
+void MainMenu::RemovePointItems()
+{
+    for (auto label : this->_pointLabels)
+        this->_list->removeItem(label);
+    this->_pointLabels.clear();
+}
@@ -1,3 +1,4 @@
+#include <climits>
 #include <tesla.hpp>
 #include <fancontrol.h>
 #include "utils.hpp"
@@ -5,26 +6,33 @@
 class MainMenu : public tsl::Gui 
 {
 private:
-    TemperaturePoint* _fanCurveTable;
+    FanConfig _config;
+    size_t _profile = 0;        // 正在编辑的方案
     bool _tableIsChanged;
 
     tsl::elm::ToggleListItem* _enabledBtn;
+    tsl::elm::List* _list;
+    tsl::elm::ListItem* _profileBtn;
+    tsl::elm::ListItem* _titleBtn = nullptr;
+    u64 _titleId = 0;           // 前台游戏, 0 为无
     
     // 实时监控部分
     tsl::elm::ListItem* _socTempLabel;
     tsl::elm::ListItem* _fanSpeedLabel;
+    // 上次显示的值, -1 为未知, INT_MIN 为还没显示过
+    static constexpr int FanSpeedHandback = -2;   // 已交还系统控制
+    int _shownSocTemp = INT_MIN;
+    int _shownFanSpeed = INT_MIN;
 
-    tsl::elm::ListItem* _p0Label;
-    tsl::elm::ListItem* _p1Label;
-    tsl::elm::ListItem* _p2Label;
-    tsl::elm::ListItem* _p3Label;
-    tsl::elm::ListItem* _p4Label;
-    tsl::elm::ListItem* _p5Label;
-    tsl::elm::ListItem* _p6Label;
-    tsl::elm::ListItem* _p7Label;
-    tsl::elm::ListItem* _p8Label;
-    tsl::elm::ListItem* _p9Label;
+    // 曲线各点, 按当前方案生成
+    std::vector<tsl::elm::ListItem*> _pointLabels;
 
+    std::string PointText(size_t i);
+    int TitleRule();
+    std::string TitleText();
+    void ToggleTitleRule();
+    void AddPointItems();
+    void RemovePointItems();
 
 public:
     MainMenu();
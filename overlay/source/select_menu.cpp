@@ -1,15 +1,30 @@
 #include "select_menu.hpp"
 #include "utils.hpp"
 
-SelectMenu::SelectMenu(int i, TemperaturePoint* fanCurveTable, bool* tableIsChanged) 
+#define SELECT_MAX_TEMP 100
+
+SelectMenu::SelectMenu(int i, FanConfig* config, size_t profile, bool* tableIsChanged)
 {
     this->_i = i;
-    this->_fanCurveTable = fanCurveTable;
+    this->_config = config;
+    this->_profile = profile;
+    this->_fanCurve = &config->profiles[profile];
     this->_tableIsChanged = tableIsChanged;
 
     this->_saveBtn = new tsl::elm::ListItem("保存设置");
-    this->_tempLabel = new tsl::elm::CategoryHeader(std::to_string((this->_fanCurveTable + this->_i)->temperature_c) + "℃", true);
-    this->_fanLabel = new tsl::elm::CategoryHeader(std::to_string((int)((this->_fanCurveTable + this->_i)->fanLevel_f * 100 + 0.5f)) + "%", true);
+    this->_tempLabel = new tsl::elm::CategoryHeader(std::to_string(this->_fanCurve->points[this->_i].temperature_c) + "℃", true);
+    this->_fanLabel = new tsl::elm::CategoryHeader(std::to_string((int)(this->_fanCurve->points[this->_i].fanLevel_f * 100 + 0.5f)) + "%", true);
+}
+
+// 温度必须严格递增, 当前点只能在相邻两点之间移动
+int SelectMenu::MinTemp()
+{
+    return this->_i > 0 ? this->_fanCurve->points[this->_i - 1].temperature_c + 1 : 0;
+}
+
+int SelectMenu::MaxTemp()
+{
+    return this->_i + 1 < (int)this->_fanCurve->count ? this->_fanCurve->points[this->_i + 1].temperature_c - 1 : SELECT_MAX_TEMP;
 }
 
 tsl::elm::Element* SelectMenu::createUI(){
@@ -19,14 +34,18 @@ tsl::elm::Element* SelectMenu::createUI(){
     auto list = new tsl::elm::List();
 
     list->addItem(this->_tempLabel);
-    auto stepTemp = new tsl::elm::StepTrackBar("℃", 21);
-    stepTemp->setValueChangedListener([this](u8 value)
+    auto stepTemp = new tsl::elm::StepTrackBar("℃", SELECT_MAX_TEMP + 1);
+    stepTemp->setValueChangedListener([this, stepTemp](u8 value)
     {
-        this->_tempLabel->setText(std::to_string(value * 5) + "℃");
-        (this->_fanCurveTable + this->_i)->temperature_c = value * 5;
+        int temp = std::clamp((int)value, this->MinTemp(), this->MaxTemp());
+        if (temp != value)
+            stepTemp->setProgress(temp);
+
+        this->_tempLabel->setText(std::to_string(temp) + "℃");
+        this->_fanCurve->points[this->_i].temperature_c = temp;
         this->_saveBtn->setText("保存设置");
     });
-    stepTemp->setProgress(((this->_fanCurveTable + this->_i)->temperature_c) / 5);
+    stepTemp->setProgress(this->_fanCurve->points[this->_i].temperature_c);
     list->addItem(stepTemp);
 
     list->addItem(this->_fanLabel);
@@ -39,37 +58,85 @@ tsl::elm::Element* SelectMenu::createUI(){
         if (fanLevel > 1.0f) fanLevel = 1.0f;
         // 四舍五入以避免浮点精度问题
         fanLevel = (float)((int)(fanLevel * 100.0f + 0.5f)) / 100.0f;
-        (this->_fanCurveTable + this->_i)->fanLevel_f = fanLevel;
+        this->_fanCurve->points[this->_i].fanLevel_f = fanLevel;
         this->_saveBtn->setText("保存设置");
     });
-    stepFanL->setProgress(((int)((this->_fanCurveTable + this->_i)->fanLevel_f * 100 + 0.5f)) / 5);
+    stepFanL->setProgress(((int)(this->_fanCurve->points[this->_i].fanLevel_f * 100 + 0.5f)) / 5);
     list->addItem(stepFanL);
 
-    this->_saveBtn->setClickListener([this](uint64_t keys) 
+    // 在当前点之后插入新点, 取两点中间的温度和转速
+    auto insertBtn = new tsl::elm::ListItem("在此点后插入");
+    insertBtn->setClickListener([this, insertBtn](uint64_t keys)
     {
-	    if (keys & KEY_A) 
+        if (keys & KEY_A)
         {
-		    WriteConfigFile(this->_fanCurveTable);
+            FanProfile* curve = this->_fanCurve;
+            const TemperaturePoint& cur = curve->points[this->_i];
+            bool last = this->_i + 1 == (int)curve->count;
+            int nextTemp = last ? SELECT_MAX_TEMP + 1 : curve->points[this->_i + 1].temperature_c;
+            float nextLevel = last ? cur.fanLevel_f : curve->points[this->_i + 1].fanLevel_f;
+
+            if (curve->count >= FAN_CURVE_MAX_POINTS || nextTemp - cur.temperature_c < 2)
+            {
+                insertBtn->setText("无法插入");
+                return true;
+            }
+
+            TemperaturePoint point;
+            point.temperature_c = last ? std::min(cur.temperature_c + 5, SELECT_MAX_TEMP) : (cur.temperature_c + nextTemp) / 2;
+            point.fanLevel_f = (cur.fanLevel_f + nextLevel) / 2;
+
+            memmove(&curve->points[this->_i + 2], &curve->points[this->_i + 1], (curve->count - this->_i - 1) * sizeof(TemperaturePoint));
+            curve->points[this->_i + 1] = point;
+            curve->count++;
+
+            insertBtn->setText("已插入 P" + std::to_string(this->_i + 1));
+            this->_saveBtn->setText("保存设置");
+            *this->_tableIsChanged = true;
+            return true;
+        }
+        return false;
+    });
+    list->addItem(insertBtn);
 
-            if(IsRunning() != 0)
+    auto removeBtn = new tsl::elm::ListItem("删除此点");
+    removeBtn->setClickListener([this, removeBtn](uint64_t keys)
+    {
+        if (keys & KEY_A)
+        {
+            FanProfile* curve = this->_fanCurve;
+            if (curve->count <= FAN_CURVE_MIN_POINTS)
             {
-                pmshellTerminateProgram(SysFanControlID);
-                const NcmProgramLocation programLocation
-                {
-                    .program_id = SysFanControlID,
-                    .storageID = NcmStorageId_None,
-                };
-                u64 pid = 0;
-                pmshellLaunchProgram(0, &programLocation, &pid);
+                removeBtn->setText("至少保留 " + std::to_string(FAN_CURVE_MIN_POINTS) + " 个点");
+                return true;
             }
-                
+
+            memmove(&curve->points[this->_i], &curve->points[this->_i + 1], (curve->count - this->_i - 1) * sizeof(TemperaturePoint));
+            curve->count--;
+
+            // 当前点已不存在, 立即保存并回到曲线列表
+            SaveFanCurve(this->_config, this->_profile);
+            *this->_tableIsChanged = true;
+            tsl::goBack();
+            return true;
+        }
+        return false;
+    });
+    list->addItem(removeBtn);
+
+    this->_saveBtn->setClickListener([this](uint64_t keys)
+    {
+	    if (keys & KEY_A)
+        {
+		    SaveFanCurve(this->_config, this->_profile);
+
             this->_saveBtn->setText("保存成功");
             *this->_tableIsChanged = true;
 		    return true;
 		}
-		
+
         return false;
-		
+
     });
 
     list->addItem(this->_saveBtn);
@@ -4,15 +4,20 @@
 class SelectMenu : public tsl::Gui {
 private:
     int _i = 0;
-    TemperaturePoint* _fanCurveTable;
+    FanConfig* _config;
+    size_t _profile;
+    FanProfile* _fanCurve;
     bool* _tableIsChanged;
 
     tsl::elm::CategoryHeader* _tempLabel;
     tsl::elm::CategoryHeader* _fanLabel;
     tsl::elm::ListItem* _saveBtn;
 
+    int MinTemp();
+    int MaxTemp();
+
 public:
-    SelectMenu(int i, TemperaturePoint *tps, bool* tableIsChanged);
+    SelectMenu(int i, FanConfig *config, size_t profile, bool* tableIsChanged);
 
     virtual tsl::elm::Element* createUI() override;
 };
\ No newline at end of file
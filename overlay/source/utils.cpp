@@ -1,15 +1,14 @@
 #include "utils.hpp"
-#include "tmp451.h"
-#include "pwm.h"
 
-// Global variables for sensor sessions
+// Readings come from the sysmodule: the latest sample is read straight out
+// of its telemetry ring (no syscalls), with the fanctl service as fallback.
+// The overlay no longer opens its own I2C / PWM sessions.
 static bool g_sensorsInitialized = false;
-static PwmChannelSession g_fanSession;
-static Result pwmCheck = 1;
+static const FanTelemetryRing *g_telemetry = nullptr;
 
-// Cache last valid fan speed to avoid showing 0% on transient failures
-static float g_lastValidFanSpeed = -1.0f;
-static u64 g_lastValidFanSpeedTime = 0;
+// A loop iteration happens at least once a second; older samples mean the
+// sysmodule is paused or gone.
+#define TELEMETRY_STALE_NS 3000000000ULL
 
 u64 IsRunning() {
     u64 pid = 0;
@@ -17,6 +16,13 @@ u64 IsRunning() {
     return pid;
 }
 
+u64 GetForegroundTitleId() {
+    u64 pid = 0, titleId = 0;
+    if (R_FAILED(pmdmntGetApplicationProcessId(&pid)) || R_FAILED(pminfoGetProgramId(&titleId, pid)))
+        return 0;
+    return titleId;
+}
+
 void RemoveB2F()
 {
     remove(SysFanControlB2FPath);
@@ -30,92 +36,92 @@ void CreateB2F()
 
 bool InitializeSensors() {
     if (g_sensorsInitialized) return true;
-    
-    // Initialize I2C for temperature sensor
-    if (R_FAILED(i2cInitialize())) {
-        return false;
-    }
-    
-    // Initialize PWM for fan speed reading (exactly like Status Monitor)
-    if (hosversionAtLeast(6,0,0) && R_SUCCEEDED(pwmInitialize())) {
-        pwmCheck = pwmOpenSession2(&g_fanSession, 0x3D000001);
-    }
-    
+
     g_sensorsInitialized = true;
     return true;
 }
 
-float GetSOCTemperature() {
-    if (!g_sensorsInitialized) return -1.0f;
-    
-    float temperature = 0.0f;
-    Result rc = Tmp451GetSocTemp(&temperature);
-    if (R_FAILED(rc)) {
-        return -1.0f;
+// Connects to fanctl if the sysmodule is up. smGetService would block until
+// the service is registered, so never ask while the sysmodule is stopped.
+// Attempts are spaced out since the overlay polls every frame.
+static bool ConnectFanService() {
+    static u64 lastAttemptNs = 0;
+
+    if (FanIpcClientIsOpen()) return true;
+
+    u64 nowNs = armTicksToNs(armGetSystemTick());
+    if (lastAttemptNs != 0 && nowNs - lastAttemptNs < 1000000000ULL) return false;
+    lastAttemptNs = nowNs;
+
+    if (IsRunning() == 0) return false;
+    return R_SUCCEEDED(FanIpcClientOpen());
+}
+
+bool GetFanState(FanIpcState *out) {
+    if (!g_sensorsInitialized || !ConnectFanService()) return false;
+
+    if (R_FAILED(FanIpcGetState(out))) {
+        // Sysmodule went away; reconnect on the next call.
+        FanIpcClientClose();
+        g_telemetry = nullptr;
+        return false;
     }
-    return temperature;
+    return true;
 }
 
-float GetFanSpeed() {
-    if (!g_sensorsInitialized) return -1.0f;
-    
-    // Use Status Monitor's exact implementation with retry logic
-    if (R_SUCCEEDED(pwmCheck)) {
-        const int MAX_RETRIES = 3;
-        
-        for (int retry = 0; retry < MAX_RETRIES; retry++) {
-            double temp = 0.0;
-            Result rc = pwmChannelSessionGetDutyCycle(&g_fanSession, &temp);
-            
-            if (R_SUCCEEDED(rc)) {
-                temp *= 10.0;
-                temp = trunc(temp);
-                temp /= 10.0;
-                double fanSpeed = 100.0 - temp;
-                
-                // Cache the valid reading
-                g_lastValidFanSpeed = (float)fanSpeed;
-                g_lastValidFanSpeedTime = armGetSystemTick();
-                
-                return (float)fanSpeed;
-            }
-            
-            // Small delay before retry (about 1ms)
-            if (retry < MAX_RETRIES - 1) {
-                svcSleepThread(1000000); // 1ms in nanoseconds
-            }
-        }
-        
-        // All retries failed - check if we have a recent cached value
-        u64 currentTick = armGetSystemTick();
-        u64 ticksPerSecond = armGetSystemTickFreq();
-        
-        // If we have a cached value from within the last 2 seconds, use it
-        if (g_lastValidFanSpeed >= 0.0f && 
-            (currentTick - g_lastValidFanSpeedTime) < (ticksPerSecond * 2)) {
-            return g_lastValidFanSpeed;
+bool GetFanSample(FanTelemetrySample *out) {
+    if (!g_sensorsInitialized || !ConnectFanService()) return false;
+
+    if (g_telemetry == nullptr && R_FAILED(FanIpcGetTelemetry(&g_telemetry)))
+        g_telemetry = nullptr;
+
+    if (g_telemetry != nullptr && FanTelemetryReadLatest(g_telemetry, out) &&
+        armTicksToNs(armGetSystemTick()) - out->timestampNs < TELEMETRY_STALE_NS)
+        return true;
+
+    // No fresh sample: ask directly, which also notices a dead sysmodule.
+    // Twice a second is plenty for that, reuse the answer in between.
+    static FanTelemetrySample fallback;
+    static bool fallbackValid = false;
+    static u64 fallbackNs = 0;
+
+    u64 nowNs = armTicksToNs(armGetSystemTick());
+    if (fallbackNs == 0 || nowNs - fallbackNs >= 500000000ULL) {
+        FanIpcState state;
+        fallbackNs = nowNs;
+        fallbackValid = GetFanState(&state);
+        if (fallbackValid) {
+            fallback.timestampNs   = nowNs;
+            fallback.socC          = state.socC;
+            fallback.pcbC          = state.pcbC;
+            fallback.battC         = state.battC;
+            fallback.controlC      = state.controlC;
+            fallback.targetLevel   = state.targetLevel;
+            fallback.dutyLevel     = state.appliedLevel;
+            fallback.loopLatencyNs = 0;
+            fallback.flags         = state.supervisorState << FAN_TELEMETRY_STATE_SHIFT;
         }
     }
-    
-    // If we have any cached value at all, return it rather than -1
-    if (g_lastValidFanSpeed >= 0.0f) {
-        return g_lastValidFanSpeed;
-    }
-    
-    return -1.0f;
+
+    *out = fallback;
+    return fallbackValid;
+}
+
+bool SaveFanCurve(const FanConfig *config, size_t profile) {
+    // Goes through the sysmodule when it is running so the new curve is
+    // applied right away; it persists config.dat itself.
+    const FanProfile *curve = &config->profiles[profile];
+    if (ConnectFanService() && R_SUCCEEDED(FanIpcSetTable(profile, curve->points, curve->count)))
+        return true;
+
+    WriteConfigFile(config);
+    return false;
 }
 
 void CloseSensors() {
     if (g_sensorsInitialized) {
-        if (R_SUCCEEDED(pwmCheck)) {
-            pwmChannelSessionClose(&g_fanSession);
-        }
-        pwmExit();
-        i2cExit();
+        FanIpcClientClose();
+        g_telemetry = nullptr;
         g_sensorsInitialized = false;
-        
-        // Reset cached values
-        g_lastValidFanSpeed = -1.0f;
-        g_lastValidFanSpeedTime = 0;
     }
 }
\ No newline at end of file
@@ -4,17 +4,21 @@
 #include <switch.h>
 #include <stdio.h>
 #include <fancontrol.h>
-#include "pwm.h"
 
 #define SysFanControlID 0x00FF0000B378D640
 #define SysFanControlB2FPath "/atmosphere/contents/00FF0000B378D640/flags/boot2.flag"
 
 u64 IsRunning();
+u64 GetForegroundTitleId();     // 0 if no game is running
 void CreateB2F();
 void RemoveB2F();
 
-// Add temperature and fan speed reading functions
+// Temperature and fan level, read from the sysmodule
 bool InitializeSensors();
-float GetSOCTemperature();
-float GetFanSpeed();
-void CloseSensors();
\ No newline at end of file
+bool GetFanState(FanIpcState *out);
+bool GetFanSample(FanTelemetrySample *out);
+void CloseSensors();
+
+// Applies the curve through the sysmodule if it is running, otherwise just
+// writes config.dat. Returns true if the sysmodule took it.
+bool SaveFanCurve(const FanConfig *config, size_t profile);
\ No newline at end of file
@@ -1,7 +1,15 @@
 #include "fancontrol.h"
-
-// ڲѴС, 50KB.
-#define INNER_HEAP_SIZE 0xC800
+#include "pwm.h"
+#include "fan_fs.h"
+
+// ڲѴС. ļд fan_fs, ߳ջǾ̬, ־ʽ,
+// вڴ; ֻһ. STATIC_ONLY=1 ʱûж,
+// κ malloc ʧ.
+#ifdef FANCONTROL_STATIC_ONLY
+#define INNER_HEAP_SIZE 0
+#else
+#define INNER_HEAP_SIZE 0x2000
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,20 +24,29 @@ u32 __nx_fs_num_sessions = 1;
 // Newlib ú (ʹ malloc/free ).
 void __libnx_initheap(void)
 {
-    static u8 inner_heap[INNER_HEAP_SIZE];
     extern void* fake_heap_start;
     extern void* fake_heap_end;
 
+#if INNER_HEAP_SIZE > 0
+    static u8 inner_heap[INNER_HEAP_SIZE];
+
     //  Newlib .
     fake_heap_start = inner_heap;
     fake_heap_end   = inner_heap + sizeof(inner_heap);
+#else
+    fake_heap_start = NULL;
+    fake_heap_end   = NULL;
+#endif
 }
 
-// ʼ.
+// ʼ. ֻȿҪķ, fs  pm ȷת
+//  InitDeferredServices ʼ.
 void __appInit(void)
 {
     Result rc;
 
+    MarkFanControllerLaunch();
+
     rc = smInitialize();
     if (R_FAILED(rc))
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_InitFail_SM));
@@ -43,19 +60,36 @@ void __appInit(void)
         setsysExit();
     }
 
-    rc = fsInitialize();
+    rc = fanInitialize();
+    if (R_FAILED(rc))
+        diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+
+    rc = i2cInitialize();
     if (R_FAILED(rc))
-        diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_InitFail_FS));       
+        diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
+
+    // ռձȻض (6.0.0+), ʱֻǲУд
+    if (hosversionAtLeast(6, 0, 0))
+        pwmInitialize();
+
+    // sm  InitDeferredServices ٹر
+}
+
+// ڶ׶γʼ, ߳Ѿ߿Ʒ.
+static void InitDeferredServices(void)
+{
+    Result rc;
 
-    rc = fsdevMountSdmc();;
+    rc = fsInitialize();
     if (R_FAILED(rc))
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_InitFail_FS));
 
-    rc = fanInitialize();
+    // ǰ̨Ϸл
+    rc = pmdmntInitialize();
     if (R_FAILED(rc))
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
 
-    rc = i2cInitialize();
+    rc = pminfoInitialize();
     if (R_FAILED(rc))
         diagAbortWithResult(MAKERESULT(Module_Libnx, LibnxError_ShouldNotHappen));
 
@@ -68,8 +102,11 @@ void __appExit(void)
     CloseFanControllerThread();
     fanExit();
     i2cExit();
+    pwmExit();
+    pminfoExit();
+    pmdmntExit();
+    FanFsClose();
     fsExit();
-    fsdevUnmountAll();
 }
 
 #ifdef __cplusplus
@@ -79,11 +116,13 @@ void __appExit(void)
 // ڵ.
 int main(int argc, char* argv[])
 {
-    TemperaturePoint *table;
-    
-    ReadConfigFile(&table);
-    InitFanController(table);
+    // ߺĬ÷ת, ٶ SD ϵ־, ú,
+    // ߳޷лû
+    InitFanController();
     StartFanControllerThread();
+
+    InitDeferredServices();
+    LoadFanControllerConfig();
     WaitFanController();
 
     return 0;
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""Worst-case stack depth per thread from gcc's -fcallgraph-info=su output.
+
+Reads every .ci file under the given directories, walks the call graph from
+each root and prints the deepest path next to the stack the thread actually
+gets. Calls through function pointers are resolved with --indirect; calls
+into libnx and newlib, which are built without call graph info, are charged
+a flat --external allowance each.
+
+    stack_report.py --root main=0x3000 --indirect 'FanLoopStep=Switch*' build ...
+"""
+
+import argparse
+import fnmatch
+import os
+import re
+import sys
+
+NODE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+FRAME = re.compile(r'\\n(\d+) bytes \(([^)]*)\)')
+
+
+def load(dirs):
+    frames, calls = {}, {}
+    for top in dirs:
+        for path, _, files in os.walk(top):
+            for name in files:
+                if not name.endswith(".ci"):
+                    continue
+                with open(os.path.join(path, name)) as f:
+                    for line in f:
+                        m = NODE.match(line)
+                        if m:
+                            frame = FRAME.search(m.group(2))
+                            if frame:
+                                frames[m.group(1)] = (int(frame.group(1)), frame.group(2))
+                            continue
+                        m = EDGE.match(line)
+                        if m:
+                            calls.setdefault(m.group(1), set()).add(m.group(2))
+    return frames, calls
+
+
+def bare(title):
+    return title.rsplit(":", 1)[-1]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dirs", nargs="+", help="directories holding .ci files")
+    ap.add_argument("--root", action="append", default=[], metavar="FUNC=BYTES",
+                    help="thread entry point and its stack size")
+    ap.add_argument("--indirect", action="append", default=[], metavar="CALLER=PATTERN",
+                    help="functions an indirect call in CALLER may reach (glob)")
+    ap.add_argument("--external", type=lambda s: int(s, 0), default=2048,
+                    help="bytes charged per call outside the graph (default 2048)")
+    args = ap.parse_args()
+
+    frames, calls = load(args.dirs)
+    by_name = {}
+    for title in frames:
+        by_name.setdefault(bare(title), []).append(title)
+
+    indirect = {}
+    for spec in args.indirect:
+        caller, pattern = spec.split("=", 1)
+        indirect.setdefault(caller, []).extend(
+            t for t in frames if fnmatch.fnmatch(bare(t), pattern))
+
+    unresolved = set()
+
+    def callees(title):
+        for target in calls.get(title, ()):
+            if target == "__indirect_call":
+                targets = indirect.get(bare(title))
+                if not targets:
+                    unresolved.add(bare(title))
+                    yield None
+                for t in targets or ():
+                    yield t
+            elif target in frames:
+                yield target
+            elif bare(target) in by_name:
+                yield from by_name[bare(target)]
+            else:
+                yield None
+
+    memo = {}
+
+    def depth(title, active):
+        if title in memo:
+            return memo[title]
+        if title in active:
+            print(f"warning: recursion through {bare(title)}, counted once", file=sys.stderr)
+            return 0, [], False
+        active.add(title)
+        best, path, external = 0, [], False
+        for callee in callees(title):
+            if callee is None:
+                d, p, e = args.external, ["<external>"], True
+            else:
+                d, p, e = depth(callee, active)
+            if d > best:
+                best, path, external = d, p, e
+        active.discard(title)
+        frame, kind = frames[title]
+        memo[title] = (frame + best, [f"{bare(title)} {frame}{'' if kind == 'static' else '*'}"] + path, external)
+        return memo[title]
+
+    status = 0
+    for spec in args.root:
+        name, size = spec.split("=", 1)
+        size = int(size, 0)
+        if name not in by_name:
+            print(f"{name}: not found")
+            status = 1
+            continue
+        used, path, _ = max(depth(t, set()) for t in by_name[name])
+        print(f"{name}: {used} of {size} bytes ({100 * used // size}%)")
+        for step in path:
+            print(f"    {step}")
+        if used > size:
+            status = 1
+
+    if unresolved:
+        print("indirect calls charged as external in: " + ", ".join(sorted(unresolved)))
+    print(f"(* dynamic frame, <external> = {args.external} bytes)")
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())